@@ -0,0 +1,42 @@
+#pragma once
+
+#include "raytracer_export.h"
+
+#include "Intersection.h"
+#include "Types.h"
+
+#include <vector>
+
+class Frustum;
+class Ray;
+class RayPacket;
+class TileCandidates;
+
+// Spatial structure answering ray queries against a set of shapes
+class IAccelerator
+{
+public:
+    virtual ~IAccelerator() = default;
+
+    // ray is in world space
+    virtual void Intersect(Ray const& ray, std::vector<Intersection>& xs) const = 0;
+
+    // ray is in world space. Closest hit query, see Ray::IntersectClosest
+    virtual bool IntersectClosest(Ray const& ray, Intersection& hit) const = 0;
+
+    // ray is in world space. Returns the first object found occluding the
+    // ray before the given distance, or null if there is none
+    virtual ShapePtr const* FindOccluder(Ray const& ray, float distance) const = 0;
+
+    // ray is in world space
+    bool IntersectsBefore(Ray const& ray, float distance) const { return FindOccluder(ray, distance) != nullptr; }
+
+    // packet is in world space. Packet versions of the queries above, see
+    // RayPacket. The default implementations trace one lane after the other.
+    RAYTRACER_EXPORT virtual uint32_t IntersectClosest(RayPacket const& packet, uint32_t mask, Intersection* hits) const;
+    RAYTRACER_EXPORT virtual uint32_t FindOccluders(RayPacket const& packet, uint32_t mask, float const* distances) const;
+
+    // Fills candidates with the parts of the accelerator that rays within the
+    // frustum may hit. By default nothing is culled.
+    RAYTRACER_EXPORT virtual void CollectCandidates(Frustum const& frustum, TileCandidates& candidates) const;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "raytracer_export.h"
+
+#include "Matrix.h"
+#include "Tuple.h"
+
+#include <ostream>
+
+// 3x4 matrix holding the top rows of an affine 4x4 transform, whose last row
+// is always (0, 0, 0, 1). Transforms are classified when built, so the ones
+// that only translate or scale uniformly skip most of the arithmetic when
+// applied or inverted.
+class AffineTransform
+{
+public:
+    enum class Kind : uint8_t
+    {
+        Identity,
+        Translation,  // identity linear part
+        UniformScale, // linear part is a multiple of the identity, may also translate
+        General
+    };
+
+    RAYTRACER_EXPORT AffineTransform();
+
+    // Throws if the last row of m is not (0, 0, 0, 1)
+    RAYTRACER_EXPORT explicit AffineTransform(Mat44 const& m);
+
+    static AffineTransform Identity() { return AffineTransform(); }
+
+    Kind GetKind() const { return m_kind; }
+    bool IsIdentity() const { return m_kind == Kind::Identity; }
+
+    float At(uint8_t row, uint8_t col) const { return m_data[row][col]; }
+
+    RAYTRACER_EXPORT Mat44 ToMat44() const;
+
+    // Closed form, no cofactor expansion involved
+    RAYTRACER_EXPORT AffineTransform Inverse() const;
+
+    // Transposed linear part without translation, used to transform normals
+    // when this is a world to object transform
+    RAYTRACER_EXPORT AffineTransform NormalMatrix() const;
+
+    RAYTRACER_EXPORT AffineTransform operator*(AffineTransform const& other) const;
+
+    Tuple operator*(Tuple const& t) const
+    {
+        switch (m_kind)
+        {
+        case Kind::Identity:
+            return t;
+        case Kind::Translation:
+            return {
+                t.X() + (m_data[0][3] * t.W()),
+                t.Y() + (m_data[1][3] * t.W()),
+                t.Z() + (m_data[2][3] * t.W()),
+                t.W() };
+        case Kind::UniformScale:
+            return {
+                (m_data[0][0] * t.X()) + (m_data[0][3] * t.W()),
+                (m_data[0][0] * t.Y()) + (m_data[1][3] * t.W()),
+                (m_data[0][0] * t.Z()) + (m_data[2][3] * t.W()),
+                t.W() };
+        default:
+            return {
+                (m_data[0][0] * t.X()) + (m_data[0][1] * t.Y()) + (m_data[0][2] * t.Z()) + (m_data[0][3] * t.W()),
+                (m_data[1][0] * t.X()) + (m_data[1][1] * t.Y()) + (m_data[1][2] * t.Z()) + (m_data[1][3] * t.W()),
+                (m_data[2][0] * t.X()) + (m_data[2][1] * t.Y()) + (m_data[2][2] * t.Z()) + (m_data[2][3] * t.W()),
+                t.W() };
+        }
+    }
+
+    RAYTRACER_EXPORT bool operator==(AffineTransform const& other) const;
+    bool operator!=(AffineTransform const& other) const { return !operator==(other); }
+    bool operator==(Mat44 const& other) const { return ToMat44() == other; }
+    bool operator!=(Mat44 const& other) const { return !operator==(other); }
+
+private:
+    void Classify();
+
+    float m_data[3][4];
+    Kind m_kind;
+};
+
+RAYTRACER_EXPORT std::ostream& operator<<(std::ostream& os, AffineTransform const& t);
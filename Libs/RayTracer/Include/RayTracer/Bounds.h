@@ -1,5 +1,6 @@
 #pragma once
 
+#include "AffineTransform.h"
 #include "Matrix.h"
 #include "raytracer_export.h"
 #include "Tuple.h"
@@ -13,6 +14,9 @@ public:
     RAYTRACER_EXPORT Bounds();
     RAYTRACER_EXPORT Bounds(Tuple const& min, Tuple const& max);
 
+    // Inverted bounds, ready to be grown by merging other bounds into it
+    RAYTRACER_EXPORT static Bounds Empty();
+
     Tuple Min() const { return m_min; }
     Tuple Max() const { return m_max; }
 
@@ -22,6 +26,17 @@ public:
     RAYTRACER_EXPORT bool operator==(Bounds const& other) const;
 
     RAYTRACER_EXPORT void Merge(Bounds const& other);
+    RAYTRACER_EXPORT void Merge(Tuple const& point);
+
+    RAYTRACER_EXPORT bool IsFinite() const;
+    RAYTRACER_EXPORT Tuple Center() const;
+    RAYTRACER_EXPORT float SurfaceArea() const;
+
+    RAYTRACER_EXPORT bool Contains(Tuple const& point) const;
+    RAYTRACER_EXPORT bool Contains(Bounds const& other) const;
+
+    // Splits the bounds in two halves across its largest dimension
+    RAYTRACER_EXPORT std::pair<Bounds, Bounds> Split() const;
 
     RAYTRACER_EXPORT bool Intersects(Ray const& ray, float& t1, float& t2) const;
     bool Intersects(Ray const& ray) const { float t1, t2; return Intersects(ray, t1, t2); }
@@ -35,5 +50,6 @@ private:
 };
 
 RAYTRACER_EXPORT Bounds operator*(Mat44 const& m, Bounds const& b);
+RAYTRACER_EXPORT Bounds operator*(AffineTransform const& t, Bounds const& b);
 
 RAYTRACER_EXPORT std::ostream& operator<<(std::ostream& os, Bounds const& b);
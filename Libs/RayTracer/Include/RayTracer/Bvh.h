@@ -0,0 +1,104 @@
+#pragma once
+
+#include "raytracer_export.h"
+
+#include "Accelerator.h"
+#include "Bounds.h"
+#include "Intersection.h"
+#include "Types.h"
+
+#include <unordered_map>
+#include <vector>
+
+class Ray;
+
+// Bounding Volume Hierarchy over a list of shapes. Split planes are chosen
+// with the Surface Area Heuristic (SAH) evaluated over a fixed number of bins.
+// Shapes with infinite bounds (i.e. planes) can't be placed in the hierarchy
+// so they are kept apart and always tested. Subtrees without shadow casters
+// are skipped by occlusion queries, so the tree must be rebuilt after
+// changing whether its shapes cast shadows.
+class Bvh : public IAccelerator
+{
+public:
+    // Nodes deeper than this are turned into leaves, so traversal stacks
+    // can be sized at compile time
+    static constexpr uint32_t kMaxDepth = 64u;
+
+    // A refitted tree is considered degraded once its SAH cost grows past
+    // this factor of the cost it had when built
+    static constexpr float kRebuildThreshold = 1.5f;
+
+    RAYTRACER_EXPORT Bvh();
+    RAYTRACER_EXPORT explicit Bvh(std::vector<ShapePtr> const& objects);
+
+    RAYTRACER_EXPORT void Build(std::vector<ShapePtr> const& objects);
+
+    // Updates the bounds of the leaves holding the given shapes and of their
+    // ancestors, keeping the tree topology. Returns false if any of the shapes
+    // is not in the hierarchy or its bounds are no longer finite, in which
+    // case the tree must be rebuilt.
+    RAYTRACER_EXPORT bool Refit(std::vector<ShapePtr> const& shapes);
+
+    // SAH cost of the tree relative to the area of its root
+    RAYTRACER_EXPORT float SahCost() const;
+    float BuildSahCost() const { return m_buildSahCost; }
+    bool NeedsRebuild() const { return SahCost() > (kRebuildThreshold * m_buildSahCost); }
+
+    RAYTRACER_EXPORT void Intersect(Ray const& ray, std::vector<Intersection>& xs) const override;
+    RAYTRACER_EXPORT bool IntersectClosest(Ray const& ray, Intersection& hit) const override;
+    RAYTRACER_EXPORT ShapePtr const* FindOccluder(Ray const& ray, float distance) const override;
+
+    Bounds GetBounds() const { return m_nodes.empty() ? Bounds::Empty() : m_nodes.front().m_bounds; }
+    size_t NodeCount() const { return m_nodes.size(); }
+    size_t UnboundedCount() const { return m_unbounded.size(); }
+    RAYTRACER_EXPORT size_t Depth() const;
+
+private:
+    friend class LinearBvh;
+    template<uint32_t> friend class WideBvh;
+
+    static constexpr uint32_t kNoParent = ~0u;
+
+    struct Node
+    {
+        Bounds m_bounds;
+        uint32_t m_parent;
+        uint32_t m_left;   // interior nodes only
+        uint32_t m_right;  // interior nodes only
+        uint32_t m_first;  // leaf nodes only, index into m_objects
+        uint32_t m_count;  // 0 for interior nodes
+        bool m_castsShadows; // false if no shape below casts shadows
+
+        bool IsLeaf() const { return m_count > 0; }
+    };
+
+    struct BuildEntry
+    {
+        Bounds m_bounds;
+        Tuple m_centroid;
+        ShapePtr m_shape;
+    };
+
+    uint32_t BuildNode(std::vector<BuildEntry>& entries, uint32_t first, uint32_t count, uint32_t parent, uint32_t depth);
+    void MakeLeaf(uint32_t nodeIdx, std::vector<BuildEntry> const& entries, uint32_t first, uint32_t count);
+    size_t Depth(uint32_t nodeIdx) const;
+
+    float NodeCost(Node const& node) const;
+    void SetNodeBounds(uint32_t nodeIdx, Bounds const& bounds);
+
+    void Intersect(Ray const& ray, uint32_t nodeIdx, std::vector<Intersection>& xs) const;
+    bool IntersectClosest(Ray const& ray, uint32_t nodeIdx, Intersection& hit) const;
+    ShapePtr const* FindOccluder(Ray const& ray, float distance, uint32_t nodeIdx) const;
+
+    std::vector<Node> m_nodes;
+    std::vector<ShapePtr> m_objects;
+    std::vector<ShapePtr> m_unbounded;
+
+    // Leaf holding every object, used to refit from the bottom up
+    std::unordered_map<Shape const*, uint32_t> m_objectLeaves;
+
+    // Sum of the area weighted cost of every node, kept up to date on refits
+    float m_areaCost = 0.f;
+    float m_buildSahCost = 0.f;
+};
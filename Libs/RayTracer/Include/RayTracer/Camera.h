@@ -2,9 +2,13 @@
 
 #include "raytracer_export.h"
 
+#include "AffineTransform.h"
 #include "Canvas.h"
+#include "Frustum.h"
 #include "Matrix.h"
 #include "Ray.h"
+#include "RenderSettings.h"
+#include "RenderTarget.h"
 #include "Transformations.h"
 
 class Camera
@@ -17,16 +21,40 @@ public:
     float FieldOfView() const { return m_fov; }
     float PixelSize() const { return m_pixelSize; }
 
-    void SetTransform(Mat44 const& transform) { m_transform = transform; m_invTransform = transform.Inverse(); }
-    Mat44 const& Transform() const { return m_transform; }
+    void SetTransform(Mat44 const& transform) { m_transform = AffineTransform(transform); m_invTransform = m_transform.Inverse(); }
+    AffineTransform const& Transform() const { return m_transform; }
 
     RAYTRACER_EXPORT Ray RayForPixel(uint32_t x, uint32_t y) const;
 
-    RAYTRACER_EXPORT Canvas Render(World const& world) const;
+    // Ray through the point of the pixel at (dx, dy) within [0, 1), (.5, .5)
+    // being its center
+    RAYTRACER_EXPORT Ray RayForPixel(uint32_t x, uint32_t y, float dx, float dy) const;
+
+    // Frustum containing the primary rays of pixels [x0, x1) x [y0, y1),
+    // bounded by the outer edges of the pixels
+    RAYTRACER_EXPORT Frustum TileFrustum(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) const;
+
+    // Tiles of the given size cover the image row by row, those of the last
+    // column and row being clipped to it
+    RAYTRACER_EXPORT uint32_t TileCount(uint32_t tileSize) const;
+    RAYTRACER_EXPORT void TileBounds(uint32_t tile, uint32_t tileSize, uint32_t& x0, uint32_t& y0, uint32_t& x1, uint32_t& y1) const;
+
+    // Images are rendered in tiles spread over the workers of a
+    // ThreadPool::Shared pool, as set up by settings. Throws if the settings
+    // are out of range. The measures they enable are written to stats if
+    // not null.
+    RAYTRACER_EXPORT Canvas Render(World const& world, RenderSettings const& settings = RenderSettings(), RenderStats* stats = nullptr) const;
+
+    // Same as above, rendering into target, which must have the size of the
+    // image. Other threads can take snapshots of it meanwhile, onProgress is
+    // called after every tile if not empty. Returns false if the render was
+    // cancelled or ran out of time, the coverage of the target then tells
+    // which pixels were rendered.
+    RAYTRACER_EXPORT bool Render(World const& world, RenderSettings const& settings, RenderTarget& target, ProgressCallback const& onProgress = nullptr, RenderStats* stats = nullptr) const;
 
 private:
-    Mat44 m_transform;
-    Mat44 m_invTransform;
+    AffineTransform m_transform;
+    AffineTransform m_invTransform;
     float m_fov;
     float m_halfWidth;
     float m_halfHeight;
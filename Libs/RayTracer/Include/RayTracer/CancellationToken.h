@@ -0,0 +1,17 @@
+#pragma once
+
+#include <atomic>
+
+// Stops the renders given it through their RenderSettings once cancelled,
+// from any thread or from a progress callback. Workers don't start any new
+// tile, those already running still finish.
+class CancellationToken
+{
+public:
+    void Cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+    void Reset() { m_cancelled.store(false, std::memory_order_relaxed); }
+    bool IsCancelled() const { return m_cancelled.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> m_cancelled = false;
+};
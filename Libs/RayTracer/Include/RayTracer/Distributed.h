@@ -0,0 +1,126 @@
+#pragma once
+
+#include "raytracer_export.h"
+
+#include "Camera.h"
+#include "Canvas.h"
+#include "RenderSettings.h"
+#include "RenderTarget.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Renders spread over worker processes, on one host or more. Addresses are
+// either "unix:<path>" or "tcp:<host>:<port>". Only POSIX sockets are
+// supported, anything else throws.
+
+// Unit of the protocol between a RenderCoordinator and its workers, framed
+// by its type and the size of its payload
+struct RenderMessage
+{
+    enum class Type : uint32_t
+    {
+        Job,    // to workers: scene JSON, camera and settings of the next tiles
+        Tiles,  // to workers: range of tiles of the job to render
+        Pixels, // to the coordinator: the range of tiles rendered, as pixel blocks
+        Quit    // to workers: no more jobs
+    };
+
+    Type m_type = Type::Quit;
+    std::vector<uint8_t> m_payload;
+};
+
+// Socket between a coordinator and a worker, closed when destroyed
+class RenderConnection
+{
+public:
+    // Throws if nothing listens at address
+    RAYTRACER_EXPORT static std::unique_ptr<RenderConnection> Connect(std::string const& address);
+
+    RAYTRACER_EXPORT explicit RenderConnection(int socket);
+    RAYTRACER_EXPORT ~RenderConnection();
+
+    RenderConnection(RenderConnection const&) = delete;
+    RenderConnection& operator=(RenderConnection const&) = delete;
+
+    int Socket() const { return m_socket; }
+
+    // All return false once the peer is gone, or sent something which isn't
+    // a message. Receive blocks until a whole message arrived. TryReceive
+    // only reads what already did and sets complete once a message is whole,
+    // so a peer stalling mid message can't block the caller.
+    RAYTRACER_EXPORT bool Send(RenderMessage const& message);
+    RAYTRACER_EXPORT bool Receive(RenderMessage& message);
+    RAYTRACER_EXPORT bool TryReceive(RenderMessage& message, bool& complete);
+
+private:
+    int m_socket;
+    std::vector<uint8_t> m_received; // start of the next message
+};
+
+// Listens for workers at an address and hands them the tiles of renders a
+// range at a time, assembling the pixels they send back. Workers may join
+// at any time. Tiles given to a worker which disconnects before sending them
+// back, or which doesn't within replyTimeout seconds of getting them, are
+// handed to the others and the worker is dropped.
+class RenderCoordinator
+{
+public:
+    // Port 0 of a tcp address picks a free one, given by Address. A
+    // replyTimeout of 0 waits for workers however long they take.
+    RAYTRACER_EXPORT explicit RenderCoordinator(std::string const& address, uint32_t tilesPerAssignment = 4u, double replyTimeout = 60.);
+
+    // Workers are told to quit
+    RAYTRACER_EXPORT ~RenderCoordinator();
+
+    RenderCoordinator(RenderCoordinator const&) = delete;
+    RenderCoordinator& operator=(RenderCoordinator const&) = delete;
+
+    std::string const& Address() const { return m_address; }
+    uint32_t WorkerCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+    // Accepts workers until there are count of them or timeout seconds went
+    // by, returns how many there are
+    RAYTRACER_EXPORT uint32_t WaitForWorkers(uint32_t count, double timeout);
+
+    // Renders scene, the JSON read by World::Load, through camera with the
+    // workers, their own number of threads aside. Throws if the scene is not
+    // a JSON object, if the settings are out of range or hold a sampler,
+    // which can't be sent, or if every worker is gone while tiles are left.
+    // Workers failing to load the scene disconnect and are dropped.
+    RAYTRACER_EXPORT Canvas Render(std::string const& scene, Camera const& camera, RenderSettings const& settings = RenderSettings());
+
+    // Same as above, rendering into target, which must have the size of the
+    // image. Returns false if the render was cancelled or ran out of time:
+    // no more tiles are handed out, those being rendered are still waited for.
+    RAYTRACER_EXPORT bool Render(std::string const& scene, Camera const& camera, RenderSettings const& settings, RenderTarget& target);
+
+private:
+    struct Worker
+    {
+        std::unique_ptr<RenderConnection> m_connection;
+        bool m_busy = false;
+        std::pair<uint32_t, uint32_t> m_tiles; // being rendered while busy
+        std::chrono::steady_clock::time_point m_deadline; // to send them back by
+    };
+
+    // Adds the worker connecting, false if it couldn't
+    bool Accept();
+
+    int m_listener;
+    std::string m_address;
+    std::string m_socketPath; // of unix addresses, removed when destroyed
+    uint32_t m_tilesPerAssignment;
+    double m_replyTimeout;
+    std::vector<Worker> m_workers;
+};
+
+// Connects to the coordinator at address and renders the tiles it hands out
+// with the given number of threads, 0 for one per hardware thread. Returns
+// true once told to quit, false if the coordinator went away. Throws if it
+// can't connect or load a scene.
+RAYTRACER_EXPORT bool RunRenderWorker(std::string const& address, uint32_t threads = 0u);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "raytracer_export.h"
+
+#include "Bounds.h"
+#include "Tuple.h"
+
+#include <array>
+
+// Infinite pyramid with its apex at the origin of a set of rays, such as the
+// primary rays of a tile of pixels, containing all of them. It is bounded by
+// a plane through each pair of consecutive corners and the apex, and by a
+// near plane through the apex, as rays only go forward.
+class Frustum
+{
+public:
+    enum class Overlap { Outside, Partial, Inside };
+
+    // corners are points along the edges of the pyramid, given in order
+    // around it
+    RAYTRACER_EXPORT Frustum(Tuple const& origin, std::array<Tuple, 4> const& corners);
+
+    Tuple const& Origin() const { return m_origin; }
+
+    // Conservative test, boxes crossing the frustum near one of its edges
+    // may be reported as overlapping it while they don't
+    RAYTRACER_EXPORT Overlap Classify(float const* min, float const* max) const;
+    RAYTRACER_EXPORT Overlap Classify(Bounds const& bounds) const;
+
+    // Squared distance from the apex to the closest point of the box
+    RAYTRACER_EXPORT float SquaredDistance(float const* min, float const* max) const;
+
+private:
+    static constexpr size_t kPlaneCount = 5;
+
+    Tuple m_origin;
+    std::array<Tuple, kPlaneCount> m_normals; // pointing inside
+    std::array<float, kPlaneCount> m_offsets;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "raytracer_export.h"
+#include "Material.h"
 #include "Matrix.h"
 #include "Tuple.h"
 #include "Types.h"
@@ -20,27 +21,72 @@ struct IntersectionData
     float m_n2;
     float m_distance;
     bool m_inside;
-    ShapeConstPtr m_object;
+    // Non owning, valid as long as the world that was hit
+    Shape const* m_object;
+    Instance const* m_instance;
+
+    // Material of the hit object, unless overriden by its instance
+    RAYTRACER_EXPORT Material const& GetMaterial() const;
 };
 
+// Shapes are not owned by intersections, they are only valid as long as the
+// world that was hit. Copying them is as cheap as copying a few pointers.
 class Intersection
 {
 public:
-    RAYTRACER_EXPORT Intersection(float distance, ShapeConstPtr const& s);
+    // No hit yet, infinitely far
+    RAYTRACER_EXPORT Intersection();
+    RAYTRACER_EXPORT Intersection(float distance, Shape const* s);
+    Intersection(float distance, ShapeConstPtr const& s) : Intersection(distance, s.get()) {}
 
     float Distance() const { return m_distance; }
-    ShapeConstPtr Object() const { return m_shape; }
+    Shape const* Object() const { return m_shape; }
+
+    // Instance through which the object was hit, if any
+    ::Instance const* Instance() const { return m_instance; }
+    void SetInstance(::Instance const* instance) { m_instance = instance; }
+
+    // Material of the hit object, unless overriden by its instance
+    RAYTRACER_EXPORT Material const& GetMaterial() const;
 
     RAYTRACER_EXPORT bool operator==(Intersection const& other) const;
     RAYTRACER_EXPORT bool operator<(Intersection const& other) const;
 
 private:
     float m_distance;
-    ShapeConstPtr m_shape;
+    Shape const* m_shape;
+    ::Instance const* m_instance;
 };
 
 RAYTRACER_EXPORT Intersection Hit(std::vector<Intersection> const& xs);
 
+// Pool of intersection lists owned by the calling thread. Lists are cleared
+// but keep their capacity when released, so once warmed up ray queries don't
+// allocate. Leases must be released in the reverse order they were acquired,
+// which scoping them guarantees.
+class IntersectionArena
+{
+public:
+    class Lease
+    {
+    public:
+        RAYTRACER_EXPORT ~Lease();
+
+        Lease(Lease const&) = delete;
+        Lease& operator=(Lease const&) = delete;
+
+        std::vector<Intersection>& List() { return m_list; }
+
+    private:
+        friend class IntersectionArena;
+        explicit Lease(std::vector<Intersection>& list) : m_list(list) {}
+
+        std::vector<Intersection>& m_list;
+    };
+
+    RAYTRACER_EXPORT static Lease Acquire();
+};
+
 template<typename ...Args>
 std::vector<Intersection> Intersections(Args const&... args)
 {
@@ -26,4 +26,6 @@ private:
     std::string m_name;
 };
 
+// surfaceColor is the material color already evaluated at position
+RAYTRACER_EXPORT Color Lighting(Material const& m, Color const& surfaceColor, PointLight const& light, Tuple const& position, Tuple const& eye, Tuple const& normal, bool inShadow=false);
 RAYTRACER_EXPORT Color Lighting(Material const& m, ShapeConstPtr const& shape, PointLight const& light, Tuple const& position, Tuple const& eye, Tuple const& normal, bool inShadow=false);
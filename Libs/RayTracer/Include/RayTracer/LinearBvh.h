@@ -0,0 +1,109 @@
+#pragma once
+
+#include "raytracer_export.h"
+
+#include "Accelerator.h"
+#include "Bounds.h"
+#include "Bvh.h"
+#include "PrimitiveBatch.h"
+#include "Types.h"
+
+#include <unordered_map>
+#include <vector>
+
+class Ray;
+class RayPacket;
+
+// Flattened copy of a Bvh laid out for cache friendly traversal. Nodes are
+// stored in depth first order, so the first child of an interior node always
+// follows it in memory and only the second child index needs to be stored.
+// Traversal is iterative with a fixed size stack, no shared pointers nor
+// virtual calls are involved until a leaf is reached. Subtrees holding only
+// a few spheres and cubes are collapsed into a single leaf referencing a
+// PrimitiveBatch, so all of them are tested at once.
+class LinearBvh : public IAccelerator
+{
+public:
+    RAYTRACER_EXPORT LinearBvh();
+    RAYTRACER_EXPORT explicit LinearBvh(Bvh const& bvh);
+
+    RAYTRACER_EXPORT void Build(Bvh const& bvh);
+
+    // Copies the bounds updated by a refit of the bvh it was built from
+    RAYTRACER_EXPORT void Refit(Bvh const& bvh, std::vector<ShapePtr> const& shapes);
+
+    RAYTRACER_EXPORT void Intersect(Ray const& ray, std::vector<Intersection>& xs) const override;
+    RAYTRACER_EXPORT bool IntersectClosest(Ray const& ray, Intersection& hit) const override;
+    RAYTRACER_EXPORT ShapePtr const* FindOccluder(Ray const& ray, float distance) const override;
+
+    // Rays of the packet are traced together as long as they reach the same
+    // nodes, each lane then goes on alone
+    RAYTRACER_EXPORT uint32_t IntersectClosest(RayPacket const& packet, uint32_t mask, Intersection* hits) const override;
+    RAYTRACER_EXPORT uint32_t FindOccluders(RayPacket const& packet, uint32_t mask, float const* distances) const override;
+
+    // Keeps the subtrees overlapping the frustum, nearest first. Nodes
+    // crossing its sides are opened as long as there are at most
+    // kMaxCandidates subtrees, nodes fully inside it are kept whole.
+    RAYTRACER_EXPORT void CollectCandidates(Frustum const& frustum, TileCandidates& candidates) const override;
+
+    RAYTRACER_EXPORT Bounds GetBounds() const;
+    size_t NodeCount() const { return m_nodes.size(); }
+    size_t BatchCount() const { return m_batches.size(); }
+
+    static constexpr uint32_t kMaxCandidates = 8u;
+
+private:
+    friend class TileCandidates;
+
+    static constexpr uint32_t kCollapsed = ~0u;
+
+    // Node flags
+    static constexpr uint8_t kCastsShadows = 1u;
+    static constexpr uint8_t kBatch = 2u;
+
+    struct alignas(32) Node
+    {
+        float m_min[3];
+        float m_max[3];
+        uint32_t m_offset; // leaf: first object or batch index, interior: second child index
+        uint16_t m_count;  // 0 for interior nodes
+        uint8_t m_axis;    // interior nodes only, axis used to pick the nearest child
+        uint8_t m_flags;
+
+        bool IsLeaf() const { return m_count > 0; }
+        bool IsBatch() const { return (m_flags & kBatch) != 0u; }
+        bool CastsShadows() const { return (m_flags & kCastsShadows) != 0u; }
+    };
+    static_assert(sizeof(Node) == 32, "LinearBvh nodes must fit in 32 bytes");
+
+    uint32_t Flatten(Bvh const& bvh, uint32_t nodeIdx);
+    bool FitsInBatch(Bvh const& bvh, uint32_t nodeIdx, uint32_t& count) const;
+    void MakeBatch(Bvh const& bvh, uint32_t nodeIdx, uint32_t linearIdx, uint32_t count);
+    void SetNodeBounds(uint32_t nodeIdx, Bounds const& bounds);
+
+    // Traversals of the subtree below rootIdx
+    void Intersect(Ray const& ray, std::vector<Intersection>& xs, uint32_t rootIdx) const;
+    bool IntersectClosest(Ray const& ray, Intersection& hit, uint32_t rootIdx) const;
+    ShapePtr const* FindOccluder(Ray const& ray, float distance, uint32_t rootIdx) const;
+    uint32_t IntersectClosest(RayPacket const& packet, uint32_t mask, Intersection* hits, uint32_t rootIdx) const;
+    uint32_t FindOccluders(RayPacket const& packet, uint32_t mask, float const* distances, uint32_t rootIdx) const;
+
+    bool IntersectClosest(PrimitiveBatch const& batch, Ray const& ray, Intersection& hit) const;
+    ShapePtr const* FindOccluder(PrimitiveBatch const& batch, Ray const& ray, float distance) const;
+
+    // Node still to visit by a packet, with the lanes that reached it
+    struct PacketEntry
+    {
+        uint32_t m_nodeIdx;
+        uint32_t m_mask;
+    };
+
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_linearIndices; // indexed by source bvh node, kCollapsed inside batches
+    std::vector<ShapePtr> m_objects;
+    std::vector<ShapePtr> m_unbounded;
+    std::vector<PrimitiveBatch> m_batches;
+
+    // Batch and lane of every batched object, as batch * kWidth + lane
+    std::unordered_map<Shape const*, uint32_t> m_batchLanes;
+};
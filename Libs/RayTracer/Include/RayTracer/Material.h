@@ -19,7 +19,7 @@ public:
     RAYTRACER_EXPORT void SetColor(Color const& color);
     RAYTRACER_EXPORT Color const& GetColor() const;
 
-    RAYTRACER_EXPORT Color ColorAt(ShapeConstPtr const&, Tuple const& point) const;
+    RAYTRACER_EXPORT Color ColorAt(Shape const* shape, Tuple const& point) const;
 
     float Ambient() const { return m_ambient; }
     float Diffuse() const { return m_diffuse; }
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+#ifdef USE_SSE
+#include <emmintrin.h>
+#endif
+
+// Kernels behind Tuple, Color and Mat44 arithmetic and the slab tests of
+// ray packets and wide bvhs. Operands are arrays of four floats and matrices
+// are sixteen floats stored row major. Results may alias the operands. The scalar kernels are the reference implementation,
+// the SSE ones are used instead when the library is built with USE_SSE.
+// They only rely on SSE2, so no extra compiler flags are needed on x64.
+namespace math
+{
+
+namespace scalar
+{
+    inline void Add(float const* a, float const* b, float* r)
+    {
+        for (int i = 0; i < 4; i++) r[i] = a[i] + b[i];
+    }
+
+    inline void Sub(float const* a, float const* b, float* r)
+    {
+        for (int i = 0; i < 4; i++) r[i] = a[i] - b[i];
+    }
+
+    inline void Mul(float const* a, float const* b, float* r)
+    {
+        for (int i = 0; i < 4; i++) r[i] = a[i] * b[i];
+    }
+
+    inline void Scale(float const* a, float s, float* r)
+    {
+        for (int i = 0; i < 4; i++) r[i] = a[i] * s;
+    }
+
+    inline float Dot(float const* a, float const* b)
+    {
+        return (a[0] * b[0]) + (a[1] * b[1]) + (a[2] * b[2]) + (a[3] * b[3]);
+    }
+
+    // Cross product of the xyz components, w is set to 0
+    inline void Cross(float const* a, float const* b, float* r)
+    {
+        float const x = (a[1] * b[2]) - (a[2] * b[1]);
+        float const y = (a[2] * b[0]) - (a[0] * b[2]);
+        float const z = (a[0] * b[1]) - (a[1] * b[0]);
+        r[0] = x;
+        r[1] = y;
+        r[2] = z;
+        r[3] = 0.f;
+    }
+
+    inline void Normalize(float const* a, float* r)
+    {
+        Scale(a, 1.f / std::sqrt(Dot(a, a)), r);
+    }
+
+    inline void MulMat44Vec(float const* m, float const* v, float* r)
+    {
+        float tmp[4];
+        for (int i = 0; i < 4; i++)
+        {
+            tmp[i] = Dot(m + (i * 4), v);
+        }
+        for (int i = 0; i < 4; i++) r[i] = tmp[i];
+    }
+
+    inline void MulMat44(float const* a, float const* b, float* r)
+    {
+        float tmp[16];
+        for (int i = 0; i < 4; i++)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                tmp[(i * 4) + j]
+                    = (a[(i * 4) + 0] * b[j])
+                    + (a[(i * 4) + 1] * b[4 + j])
+                    + (a[(i * 4) + 2] * b[8 + j])
+                    + (a[(i * 4) + 3] * b[12 + j]);
+            }
+        }
+        for (int i = 0; i < 16; i++) r[i] = tmp[i];
+    }
+
+    // One axis of a slab test. Narrows [lo, hi] to the distances along the
+    // ray between the planes at min and max, the box is hit when lo <= hi
+    // once every axis is done. A NaN distance, from a ray lying in one of the
+    // planes, leaves the range as is.
+    inline void Slab(float min, float max, float origin, float invDir, float& lo, float& hi)
+    {
+        float t1 = (min - origin) * invDir;
+        float t2 = (max - origin) * invDir;
+        if (t1 > t2) std::swap(t1, t2);
+        lo = std::max(lo, t1);
+        hi = std::min(hi, t2);
+    }
+}
+
+#ifdef USE_SSE
+namespace sse
+{
+    // Sum of the lanes of a * b, broadcast to every lane
+    inline __m128 Dot4(__m128 a, __m128 b)
+    {
+        __m128 const m = _mm_mul_ps(a, b);
+        __m128 const s = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_add_ps(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 0, 3, 2)));
+    }
+
+    inline void Add(float const* a, float const* b, float* r)
+    {
+        _mm_storeu_ps(r, _mm_add_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)));
+    }
+
+    inline void Sub(float const* a, float const* b, float* r)
+    {
+        _mm_storeu_ps(r, _mm_sub_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)));
+    }
+
+    inline void Mul(float const* a, float const* b, float* r)
+    {
+        _mm_storeu_ps(r, _mm_mul_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)));
+    }
+
+    inline void Scale(float const* a, float s, float* r)
+    {
+        _mm_storeu_ps(r, _mm_mul_ps(_mm_loadu_ps(a), _mm_set1_ps(s)));
+    }
+
+    inline float Dot(float const* a, float const* b)
+    {
+        return _mm_cvtss_f32(Dot4(_mm_loadu_ps(a), _mm_loadu_ps(b)));
+    }
+
+    inline void Cross(float const* a, float const* b, float* r)
+    {
+        __m128 const va = _mm_loadu_ps(a);
+        __m128 const vb = _mm_loadu_ps(b);
+        __m128 const aYZX = _mm_shuffle_ps(va, va, _MM_SHUFFLE(3, 0, 2, 1));
+        __m128 const bYZX = _mm_shuffle_ps(vb, vb, _MM_SHUFFLE(3, 0, 2, 1));
+        __m128 const aZXY = _mm_shuffle_ps(va, va, _MM_SHUFFLE(3, 1, 0, 2));
+        __m128 const bZXY = _mm_shuffle_ps(vb, vb, _MM_SHUFFLE(3, 1, 0, 2));
+        __m128 const cross = _mm_sub_ps(_mm_mul_ps(aYZX, bZXY), _mm_mul_ps(aZXY, bYZX));
+        __m128 const xyzMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+        _mm_storeu_ps(r, _mm_and_ps(cross, xyzMask));
+    }
+
+    inline void Normalize(float const* a, float* r)
+    {
+        // Full precision square root and division, the reciprocal
+        // approximations are too coarse for EPSILON comparisons
+        __m128 const v = _mm_loadu_ps(a);
+        _mm_storeu_ps(r, _mm_div_ps(v, _mm_sqrt_ps(Dot4(v, v))));
+    }
+
+    inline void MulMat44Vec(float const* m, float const* v, float* r)
+    {
+        __m128 const vv = _mm_loadu_ps(v);
+        __m128 p0 = _mm_mul_ps(_mm_loadu_ps(m + 0), vv);
+        __m128 p1 = _mm_mul_ps(_mm_loadu_ps(m + 4), vv);
+        __m128 p2 = _mm_mul_ps(_mm_loadu_ps(m + 8), vv);
+        __m128 p3 = _mm_mul_ps(_mm_loadu_ps(m + 12), vv);
+        // Once transposed, summing the products of each row gives one lane each
+        _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+        _mm_storeu_ps(r, _mm_add_ps(_mm_add_ps(p0, p1), _mm_add_ps(p2, p3)));
+    }
+
+    inline void MulMat44(float const* a, float const* b, float* r)
+    {
+        __m128 const b0 = _mm_loadu_ps(b + 0);
+        __m128 const b1 = _mm_loadu_ps(b + 4);
+        __m128 const b2 = _mm_loadu_ps(b + 8);
+        __m128 const b3 = _mm_loadu_ps(b + 12);
+        __m128 rows[4];
+        for (int i = 0; i < 4; i++)
+        {
+            float const* row = a + (i * 4);
+            rows[i] = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(row[0]), b0), _mm_mul_ps(_mm_set1_ps(row[1]), b1)),
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(row[2]), b2), _mm_mul_ps(_mm_set1_ps(row[3]), b3)));
+        }
+        for (int i = 0; i < 4; i++)
+        {
+            _mm_storeu_ps(r + (i * 4), rows[i]);
+        }
+    }
+
+    // scalar::Slab on four lanes, which may be four rays or four boxes.
+    // min_ps and max_ps return their second operand when either is NaN, so
+    // the operands are ordered for NaNs to be discarded the same way.
+    inline void Slab(__m128 min, __m128 max, __m128 origin, __m128 invDir, __m128& lo, __m128& hi)
+    {
+        __m128 const t1 = _mm_mul_ps(_mm_sub_ps(min, origin), invDir);
+        __m128 const t2 = _mm_mul_ps(_mm_sub_ps(max, origin), invDir);
+        lo = _mm_max_ps(_mm_min_ps(t2, t1), lo);
+        hi = _mm_min_ps(_mm_max_ps(t1, t2), hi);
+    }
+
+    // Bit i is set when lane i of a slab test is a hit
+    inline uint32_t SlabHits(__m128 lo, __m128 hi)
+    {
+        return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(lo, hi)));
+    }
+}
+
+namespace active = sse;
+#else
+namespace active = scalar;
+#endif
+
+}
@@ -22,6 +22,10 @@ public:
     float At(uint8_t row, uint8_t col) const { return m_data[row][col]; }
     float& At(uint8_t row, uint8_t col) { return m_data[row][col]; }
 
+    // Row major elements, for the math kernels
+    float const* Data() const { return &m_data[0][0]; }
+    float* Data() { return &m_data[0][0]; }
+
     bool operator==(Matrix const& other) const;
     bool operator!=(Matrix const& other) const { return !this->operator==(other); }
 
@@ -31,12 +35,9 @@ public:
     typename std::enable_if<(R == 4) && (C == 4), Tuple>::type
     operator*(Tuple const& tuple) const
     {
-        return {
-            (At<0,0>() * tuple.X()) + (At<0,1>() * tuple.Y()) + (At<0,2>() * tuple.Z()) + (At<0,3>() * tuple.W()),
-            (At<1,0>() * tuple.X()) + (At<1,1>() * tuple.Y()) + (At<1,2>() * tuple.Z()) + (At<1,3>() * tuple.W()),
-            (At<2,0>() * tuple.X()) + (At<2,1>() * tuple.Y()) + (At<2,2>() * tuple.Z()) + (At<2,3>() * tuple.W()),
-            (At<3,0>() * tuple.X()) + (At<3,1>() * tuple.Y()) + (At<3,2>() * tuple.Z()) + (At<3,3>() * tuple.W())
-        };
+        Tuple r;
+        math::active::MulMat44Vec(Data(), tuple.Data(), r.Data());
+        return r;
     }
 
     Matrix Transposed() const;
@@ -102,6 +103,11 @@ template<uint8_t ROWS, uint8_t COLS>
 Matrix<ROWS, COLS> Matrix<ROWS, COLS>::operator*(Matrix const& other) const
 {
     Matrix<ROWS, COLS> c;
+    if constexpr ((ROWS == 4) && (COLS == 4))
+    {
+        math::active::MulMat44(Data(), other.Data(), c.Data());
+        return c;
+    }
 
     for (int i = 0; i < ROWS; i++)
     {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "AffineTransform.h"
 #include "Color.h"
 #include "Matrix.h"
 #include "raytracer_export.h"
@@ -17,18 +18,18 @@ public:
 
     RAYTRACER_EXPORT IPattern();
 
-    RAYTRACER_EXPORT Color ShapeColorAt(ShapeConstPtr const& shape, Tuple const& point) const;
+    RAYTRACER_EXPORT Color ShapeColorAt(Shape const* shape, Tuple const& point) const;
     virtual Color ColorAt(Tuple const& point) const = 0;
 
-    void SetTransform(Mat44 const& t) { m_transform = t; m_invTransform = t.Inverse(); }
-    Mat44 const& Transform() const { return m_transform; }
-    Mat44 const& InvTransform() const { return m_invTransform; }
+    void SetTransform(Mat44 const& t) { m_transform = AffineTransform(t); m_invTransform = m_transform.Inverse(); }
+    AffineTransform const& Transform() const { return m_transform; }
+    AffineTransform const& InvTransform() const { return m_invTransform; }
 
     virtual bool operator==(PatternPtr const& other) const = 0;
 
 private:
-    Mat44 m_transform;
-    Mat44 m_invTransform;
+    AffineTransform m_transform;
+    AffineTransform m_invTransform;
 };
 
 class SolidPattern : public IPattern
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "raytracer_export.h"
+
+#include "Types.h"
+
+#include <cstdint>
+
+class Ray;
+
+// Up to kWidth spheres and cubes stored as structure of arrays, so a ray is
+// tested against all of them at once with straight-line vector code instead
+// of one virtual call per shape. Each lane keeps the inverse transform of its
+// shape, rows first, so shapes must be intersected in the space the batch was
+// built in, like the top level objects of an accelerator.
+struct PrimitiveBatch
+{
+    static constexpr uint32_t kWidth = 8u;
+
+    // Whether the shape is a plain sphere or cube
+    RAYTRACER_EXPORT static bool CanBatch(Shape const& shape);
+
+    // objectIdx is only stored to find the shape back from a lane
+    RAYTRACER_EXPORT void Add(uint32_t objectIdx, Shape const& shape);
+
+    // Copies the transform of the shape again after it moved
+    RAYTRACER_EXPORT void Update(uint32_t lane, Shape const& shape);
+
+    // Distances of both hits of the ray with every lane, even behind its
+    // origin. Returns the mask of the lanes that are hit.
+    RAYTRACER_EXPORT uint32_t Intersect(Ray const& ray, float* t1, float* t2) const;
+
+    alignas(32) float m_invTransform[12][kWidth] = {};
+    uint32_t m_objects[kWidth] = {};
+    uint32_t m_count = 0u;
+    uint32_t m_cubes = 0u;         // mask of the lanes holding cubes, the others hold spheres
+    uint32_t m_shadowCasters = 0u; // mask of the lanes casting shadows
+};
+
+// Kernels behind PrimitiveBatch::Intersect, exposed to compare them. The
+// scalar one is the reference, the AVX one is used instead when the library
+// is built with USE_AVX.
+namespace batch
+{
+    RAYTRACER_EXPORT uint32_t IntersectScalar(PrimitiveBatch const& batch, Ray const& ray, float* t1, float* t2);
+#ifdef USE_AVX
+    RAYTRACER_EXPORT uint32_t IntersectAvx(PrimitiveBatch const& batch, Ray const& ray, float* t1, float* t2);
+#endif
+}
@@ -2,9 +2,11 @@
 
 #include "raytracer_export.h"
 
+#include "AffineTransform.h"
 #include "Intersection.h"
 #include "Matrix.h"
 #include "Tuple.h"
+#include "Util.h"
 #include "World.h"
 
 #include <vector>
@@ -12,24 +14,52 @@
 class RAYTRACER_EXPORT Ray
 {
 public:
-    Ray(Tuple const& origin, Tuple const& direction);
+    Ray(Tuple const& origin, Tuple const& direction, float tMax = INF);
 
     Tuple const& Origin() const { return m_origin; }
     Tuple const& Direction() const { return m_direction; }
 
+    // Upper bound of the hits closest hit queries look for. It shrinks as
+    // they find hits, even on const rays, so a ray must not be reused for
+    // another closest hit query without resetting it.
+    float TMax() const { return m_tMax; }
+    void TMax(float tMax) const { m_tMax = tMax; }
+
     Tuple Position(float t) const { return m_origin + (m_direction * t); }
 
     void Intersect(ShapePtr const& shape, std::vector<Intersection>& xs) const;
     void Intersect(World const& world, std::vector<Intersection>& xs) const;
 
-    bool HasIntersectionNearThan(World const& world, float distance) const;
-    bool IntersectsBefore(ShapePtr const& shape, float distance) const;
+    // Closest hit queries, only hits within [0, TMax()) are considered. When a
+    // closer one is found it's stored in hit and TMax() is shrunk to its
+    // distance, so farther shapes and nodes are culled.
+    bool IntersectClosest(ShapePtr const& shape, Intersection& hit) const;
+    bool IntersectClosest(World const& world, Intersection& hit) const;
+
+    // Keeps candidate as the closest hit if it lies within [0, TMax())
+    bool UpdateClosest(Intersection const& candidate, Intersection& hit) const
+    {
+        if ((candidate.Distance() < 0.f) || (candidate.Distance() >= m_tMax))
+        {
+            return false;
+        }
+        m_tMax = candidate.Distance();
+        hit = candidate;
+        return true;
+    }
+
+    bool HasIntersectionNearThan(World const& world, float distance) const { return FindOccluder(world, distance) != nullptr; }
+    ShapePtr const* FindOccluder(World const& world, float distance) const;
+    bool IntersectsBefore(Shape const& shape, float distance) const;
+    bool IntersectsBefore(ShapePtr const& shape, float distance) const { return IntersectsBefore(*shape, distance); }
 
     IntersectionData Precompute(Intersection const& i, std::vector<Intersection> const& xs = {}) const;
 
 private:
     Tuple m_origin;
     Tuple m_direction;
+    mutable float m_tMax;
 };
 
-RAYTRACER_EXPORT Ray operator*(Mat44 const& m, Ray const& r);
\ No newline at end of file
+RAYTRACER_EXPORT Ray operator*(Mat44 const& m, Ray const& r);
+RAYTRACER_EXPORT Ray operator*(AffineTransform const& t, Ray const& r);
\ No newline at end of file
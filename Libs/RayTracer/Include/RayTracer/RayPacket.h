@@ -0,0 +1,93 @@
+#pragma once
+
+#include "raytracer_export.h"
+
+#include "AffineTransform.h"
+#include "Intersection.h"
+#include "Ray.h"
+#include "Tuple.h"
+#include "Types.h"
+
+#include <cstdint>
+
+class World;
+
+// Calls f with the index of every lane set in mask
+template<typename F>
+void ForEachLane(uint32_t mask, F const& f)
+{
+    for (uint32_t lane = 0u; mask != 0u; lane++, mask >>= 1u)
+    {
+        if ((mask & 1u) != 0u)
+        {
+            f(lane);
+        }
+    }
+}
+
+// Up to kMaxSize coherent rays, such as the primary rays of a few neighbour
+// pixels, traced together. Rays are stored as structure of arrays so a node
+// of an accelerator is tested against all of them at once. Queries take the
+// mask of the lanes to trace, and output arrays indexed by lane, which must
+// hold kMaxSize entries.
+class RayPacket
+{
+public:
+    static constexpr uint32_t kMaxSize = 16u;
+
+    RAYTRACER_EXPORT RayPacket();
+
+    RAYTRACER_EXPORT void Add(Ray const& ray);
+    void Clear() { m_size = 0u; }
+
+    uint32_t Size() const { return m_size; }
+    uint32_t FullMask() const { return (1u << m_size) - 1u; }
+
+    // Copy of a single ray, with its current bound
+    RAYTRACER_EXPORT Ray At(uint32_t lane) const;
+
+    float const* Origin(uint32_t axis) const { return m_origin[axis]; }
+    float const* Direction(uint32_t axis) const { return m_direction[axis]; }
+    bool DirIsNeg(uint32_t lane, uint32_t axis) const { return m_invDir[axis][lane] < 0.f; }
+
+    // Same as Ray::TMax, one per lane
+    float const* TMax() const { return m_tMax; }
+    float TMax(uint32_t lane) const { return m_tMax[lane]; }
+    void TMax(uint32_t lane, float tMax) const { m_tMax[lane] = tMax; }
+    RAYTRACER_EXPORT void ResetTMax() const;
+
+    // Same as Ray::UpdateClosest for a single lane
+    bool UpdateClosest(uint32_t lane, Intersection const& candidate, Intersection& hit) const
+    {
+        if ((candidate.Distance() < 0.f) || (candidate.Distance() >= m_tMax[lane]))
+        {
+            return false;
+        }
+        m_tMax[lane] = candidate.Distance();
+        hit = candidate;
+        return true;
+    }
+
+    // Mask of the lanes crossing the box within [tMin, tMax[lane]]. Lanes
+    // past Size() are meaningless.
+    RAYTRACER_EXPORT uint32_t SlabTest(float const* min, float const* max, float tMin, float const* tMax) const;
+
+    // Closest hit queries, see Ray::IntersectClosest. Return the mask of the
+    // lanes that found a closer hit.
+    RAYTRACER_EXPORT uint32_t IntersectClosest(ShapePtr const& shape, uint32_t mask, Intersection* hits) const;
+    RAYTRACER_EXPORT uint32_t IntersectClosest(World const& world, uint32_t mask, Intersection* hits) const;
+
+    // Occlusion queries, see Ray::IntersectsBefore. Return the mask of the
+    // lanes occluded before their distance.
+    RAYTRACER_EXPORT uint32_t IntersectsBefore(ShapePtr const& shape, uint32_t mask, float const* distances) const;
+    RAYTRACER_EXPORT uint32_t FindOccluders(World const& world, uint32_t mask, float const* distances) const;
+
+    RAYTRACER_EXPORT friend RayPacket operator*(AffineTransform const& t, RayPacket const& packet);
+
+private:
+    alignas(16) float m_origin[3][kMaxSize];
+    alignas(16) float m_direction[3][kMaxSize];
+    alignas(16) float m_invDir[3][kMaxSize];
+    alignas(16) mutable float m_tMax[kMaxSize];
+    uint32_t m_size;
+};
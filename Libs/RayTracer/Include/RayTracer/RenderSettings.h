@@ -0,0 +1,83 @@
+#pragma once
+
+#include "raytracer_export.h"
+
+#include "CancellationToken.h"
+#include "Sampler.h"
+#include "ThreadPool.h"
+#include "World.h"
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Options of a single Camera::Render, so the same binary can be tuned for
+// every job and machine without being rebuilt
+struct RenderSettings
+{
+    static constexpr uint32_t kMaxPasses = 8u;
+
+    uint32_t m_threads = 0u;         // 0 uses one per hardware thread
+    uint32_t m_tileSize = 16u;       // tiles of m_tileSize x m_tileSize pixels are spread over the threads
+    uint8_t m_maxDepth = World::kDefaultMaxDepth; // reflected and refracted bounces
+    uint32_t m_samplesPerPixel = 1u; // spread over the pixel and averaged, 1 traces its center
+
+    // Offsets of the samples within their pixel, dimensions 0 and 1. The
+    // R2Sampler is used if null. Give StratifiedSampler the max number of
+    // samples of a pixel.
+    SamplerPtr m_sampler;
+
+    // Adaptive sampling: pixels get as many samples again, up to this many,
+    // as long as the standard error of their luminance or its difference
+    // with a neighbour exceeds m_adaptiveThreshold. Edges are refined while
+    // flat regions keep m_samplesPerPixel. 0 disables it.
+    uint32_t m_maxSamplesPerPixel = 0u;
+    float m_adaptiveThreshold = .05f;
+
+    // Coarse to fine passes. The first one traces one pixel out of
+    // 2^(m_passes - 1) along each axis of a tile and fills the block of
+    // pixels it stands for, the next ones halve the blocks. Every pixel is
+    // still traced once, the final image doesn't depend on it.
+    uint32_t m_passes = 1u;
+
+    // Primary rays of blocks of this many pixels are traced together as a
+    // RayPacket: 2x2, 4x2 or 4x4 pixels. 1 traces every ray on its own.
+    uint32_t m_packetSize = 16u;
+
+    // Primary rays of a tile are only tested against the objects and
+    // accelerator nodes within its frustum
+    bool m_frustumCulling = true;
+
+    // Only tiles [first, last) of the image, row by row, are rendered if
+    // set. The other pixels of the target are left as they are. That is how
+    // a RenderCoordinator splits renders over its workers.
+    std::optional<std::pair<uint32_t, uint32_t>> m_tiles;
+
+    // The accelerator of the world is used if not set, it must be built
+    std::optional<World::AcceleratorType> m_accelerator;
+
+    // Workers stop starting new tiles once this many seconds went by since
+    // the render started, 0 for no limit, or once m_cancellation (not owned,
+    // may be null) is cancelled. Progressive renders then keep the blocks of
+    // their last passes where the current one didn't get.
+    double m_timeBudget = 0.;
+    CancellationToken const* m_cancellation = nullptr;
+
+    // Measures written to the RenderStats given to Camera::Render
+    bool m_workerStats = false;
+    bool m_occluderCacheStats = false;
+
+    // Throws if any of them is out of range
+    RAYTRACER_EXPORT void Validate() const;
+};
+
+// Measures of a single Camera::Render, the optional ones are only filled
+// when enabled in its RenderSettings
+struct RenderStats
+{
+    double m_seconds = 0.;
+    uint64_t m_samples = 0u; // primary rays traced
+    std::vector<WorkerStats> m_workers;
+    World::OccluderCacheStats m_occluderCache;
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "raytracer_export.h"
+
+#include "Canvas.h"
+#include "Color.h"
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Pixels [m_x0, m_x1) x [m_y0, m_y1) all set to the same color
+struct PixelBlock
+{
+    uint32_t m_x0;
+    uint32_t m_y0;
+    uint32_t m_x1;
+    uint32_t m_y1;
+    Color m_color;
+    uint32_t m_samples = 1u; // averaged into m_color
+};
+
+// Image being rendered by Camera::Render. Workers write whole tiles at once
+// under a lock, so any thread can take a snapshot of it meanwhile.
+class RenderTarget
+{
+public:
+    RAYTRACER_EXPORT RenderTarget(uint32_t width, uint32_t height);
+
+    RenderTarget(RenderTarget const&) = delete;
+    RenderTarget& operator=(RenderTarget const&) = delete;
+
+    uint32_t Width() const { return m_width; }
+    uint32_t Height() const { return m_height; }
+
+    // Copy of the image as rendered so far, pixels not rendered yet are
+    // black. The matching coverage is written to coverage if not null: the
+    // size of the block every pixel was filled from, row by row. That is 1
+    // for pixels traced themselves, more for those filled by the coarse
+    // passes of a progressive render, and 0 for those not rendered yet.
+    // The number of samples averaged by every pixel is likewise written to
+    // samples if not null.
+    RAYTRACER_EXPORT Canvas Snapshot(std::vector<uint8_t>* coverage = nullptr, std::vector<uint32_t>* samples = nullptr) const;
+
+    // Every pixel has been traced
+    RAYTRACER_EXPORT bool IsComplete() const;
+
+    // blockSize is the size of the blocks before being clipped to their tile
+    RAYTRACER_EXPORT void Write(std::vector<PixelBlock> const& blocks, uint32_t blockSize = 1u);
+
+    // Pixels [x0, x1) x [y0, y1) as they are now, one block each, row by row
+    RAYTRACER_EXPORT std::vector<PixelBlock> Read(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) const;
+
+    // Moves the image out, leaving the target empty
+    RAYTRACER_EXPORT Canvas TakeCanvas();
+
+private:
+    mutable std::mutex m_mutex;
+    uint32_t m_width;
+    uint32_t m_height;
+    Canvas m_canvas;
+    std::vector<uint8_t> m_coverage;
+    std::vector<uint32_t> m_samples;
+    uint32_t m_traced = 0u;
+};
+
+// Where a progressive render stands once a tile is done
+struct RenderProgress
+{
+    uint32_t m_pass = 0u;
+    uint32_t m_passCount = 0u;
+    uint32_t m_tilesDone = 0u; // in this pass, the pass is over once it reaches m_tileCount
+    uint32_t m_tileCount = 0u;
+    uint32_t m_x0 = 0u;        // pixels of the tile
+    uint32_t m_y0 = 0u;
+    uint32_t m_x1 = 0u;
+    uint32_t m_y1 = 0u;
+};
+
+// Called by the workers after every tile, one call at a time, with the
+// target already updated. Rendering waits for it to return.
+using ProgressCallback = std::function<void(RenderProgress const& progress, RenderTarget const& target)>;
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "raytracer_export.h"
+
+#include <cstdint>
+#include <memory>
+
+class ISampler;
+using SamplerPtr = std::shared_ptr<ISampler const>;
+
+// Sample points in [0, 1)^n for anything stochastic: offsets within a pixel,
+// points on a light or a lens, directions of a glossy bounce. A value only
+// depends on the pixel, the index of the sample and the dimension, so renders
+// come out the same whatever the threads that trace them. Every caller takes
+// its own dimensions, in pairs for 2D points: the camera takes 0 and 1 for
+// the offset within the pixel.
+class ISampler
+{
+public:
+    virtual ~ISampler() = default;
+
+    virtual float Get(uint32_t x, uint32_t y, uint32_t sample, uint32_t dimension) const = 0;
+
+    void Get2D(uint32_t x, uint32_t y, uint32_t sample, uint32_t dimension, float& u, float& v) const
+    {
+        u = Get(x, y, sample, dimension);
+        v = Get(x, y, sample, dimension + 1u);
+    }
+};
+
+// R2 sequence, an additive recurrence by the generalized golden ratio, the
+// same in every pixel. Any number of first samples is spread evenly, so more
+// can be added later on, and the first one is at the center. Pairs of
+// dimensions after the first one are shifted by a fixed offset. That is what
+// the camera uses when given no sampler.
+class R2Sampler : public ISampler
+{
+public:
+    RAYTRACER_EXPORT float Get(uint32_t x, uint32_t y, uint32_t sample, uint32_t dimension) const override;
+};
+
+// Sobol (0, 2)-sequence over every pair of dimensions: the first 2^m samples
+// of a pair fall in every elementary interval of area 2^-m once. Both the
+// points and the order of the samples are Owen scrambled from a hash of the
+// pixel, the pair and the seed, so pixels and pairs of dimensions aren't
+// correlated while keeping that stratification.
+class SobolSampler : public ISampler
+{
+public:
+    SobolSampler(uint32_t seed = 0u) : m_seed(seed) {}
+
+    RAYTRACER_EXPORT float Get(uint32_t x, uint32_t y, uint32_t sample, uint32_t dimension) const override;
+
+private:
+    uint32_t m_seed;
+};
+
+// Halton sequence, the radical inverse of the index of the sample in the nth
+// prime base for dimension n. Digits are shifted by a hash of their position,
+// the pixel, the dimension and the seed. Dimensions past kBaseCount reuse the
+// bases with the sample indices shuffled per pixel, so they are not a function
+// of the dimensions sharing their base.
+class HaltonSampler : public ISampler
+{
+public:
+    static constexpr uint32_t kBaseCount = 32u;
+
+    HaltonSampler(uint32_t seed = 0u) : m_seed(seed) {}
+
+    RAYTRACER_EXPORT float Get(uint32_t x, uint32_t y, uint32_t sample, uint32_t dimension) const override;
+
+private:
+    uint32_t m_seed;
+};
+
+// Jittered samples for a known count: every pair of dimensions is split in
+// a grid of about sqrt(samples) x sqrt(samples) strata, each sample falls in
+// a different one at a random place. Strata are shuffled per pixel and pair.
+// Samples past the count are uniformly random.
+class StratifiedSampler : public ISampler
+{
+public:
+    RAYTRACER_EXPORT StratifiedSampler(uint32_t samples, uint32_t seed = 0u);
+
+    RAYTRACER_EXPORT float Get(uint32_t x, uint32_t y, uint32_t sample, uint32_t dimension) const override;
+
+private:
+    uint32_t m_samples;
+    uint32_t m_columns;
+    uint32_t m_rows;
+    uint32_t m_seed;
+};
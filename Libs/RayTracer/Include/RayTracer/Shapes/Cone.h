@@ -17,7 +17,7 @@ protected:
 
     float RadiusAt(float y) const override { return std::abs(y); }
     float CalculateNormalY(float y, float d) const override;
-    void EarlyTest(Ray const& ray, std::vector<Intersection>& xs) const override;
+    void EarlyTest(Ray const& ray, Hits& hits) const override;
 
     void UpdateBounds() override;
 };
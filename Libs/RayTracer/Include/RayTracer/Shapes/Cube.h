@@ -7,5 +7,9 @@ class Cube : public Shape
 {
 public:
     RAYTRACER_EXPORT void Intersect(Ray const& ray, std::vector<Intersection>& xs) const override;
+    RAYTRACER_EXPORT bool IntersectsBefore(Ray const& ray, float distance) const override;
+    RAYTRACER_EXPORT bool IntersectClosest(Ray const& ray, Intersection& hit) const override;
+    RAYTRACER_EXPORT uint32_t IntersectsBefore(RayPacket const& packet, uint32_t mask, float const* distances) const override;
+    RAYTRACER_EXPORT uint32_t IntersectClosest(RayPacket const& packet, uint32_t mask, Intersection* hits) const override;
     RAYTRACER_EXPORT Tuple NormalAtLocal(Tuple const& point) const override;
 };
@@ -3,6 +3,7 @@
 #include "raytracer_export.h"
 #include "Shape.h"
 
+#include <array>
 #include <numeric>
 
 class Cylinder : public Shape
@@ -14,6 +15,8 @@ public:
     RAYTRACER_EXPORT void Initialize(json const& data, json const& dataOverride, ArchetypeMap const& archetypes) override;
 
     RAYTRACER_EXPORT void Intersect(Ray const& ray, std::vector<Intersection>& xs) const override;
+    RAYTRACER_EXPORT bool IntersectsBefore(Ray const& ray, float distance) const override;
+    RAYTRACER_EXPORT bool IntersectClosest(Ray const& ray, Intersection& hit) const override;
     RAYTRACER_EXPORT Tuple NormalAtLocal(Tuple const& point) const override;
 
     float Minimum() const { return m_min; }
@@ -22,7 +25,17 @@ public:
     bool Closed() const { return m_closed; }
 
 protected:
-    void IntersectCaps(Ray const& ray, std::vector<Intersection>& xs) const;
+    // Distances to the hits of a ray, a cylinder is hit at most 4 times
+    struct Hits
+    {
+        std::array<float, 4> m_t;
+        uint32_t m_count = 0u;
+
+        void Add(float t) { m_t[m_count++] = t; }
+    };
+
+    void IntersectLocal(Ray const& ray, Hits& hits) const;
+    void IntersectCaps(Ray const& ray, Hits& hits) const;
 
     virtual float A(Ray const& ray) const;
     virtual float B(Ray const& ray) const;
@@ -30,7 +43,7 @@ protected:
     virtual float RadiusAt(float y) const { return 1.f; }
     virtual float CalculateNormalY(float y, float d) const { return 0.f; }
 
-    virtual void EarlyTest(Ray const& ray, std::vector<Intersection>& xs) const {}
+    virtual void EarlyTest(Ray const& ray, Hits& hits) const {}
 
     bool IsInRange(Ray const& ray, float t) const;
 
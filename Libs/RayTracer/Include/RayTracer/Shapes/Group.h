@@ -13,6 +13,8 @@ public:
     RAYTRACER_EXPORT void Initialize(json const& data, json const& dataOverride, ArchetypeMap const& archetypes) override;
 
     RAYTRACER_EXPORT void Intersect(Ray const& ray, std::vector<Intersection>& xs) const override;
+    RAYTRACER_EXPORT bool IntersectsBefore(Ray const& ray, float distance) const override;
+    RAYTRACER_EXPORT bool IntersectClosest(Ray const& ray, Intersection& hit) const override;
     RAYTRACER_EXPORT Tuple NormalAtLocal(Tuple const& point) const override;
 
     bool IsEmpty() const { return m_children.empty(); }
@@ -22,6 +24,14 @@ public:
 
     std::vector<ShapePtr> const& Children() const { return m_children;  }
 
+    RAYTRACER_EXPORT void Divide(uint32_t threshold) override;
+    RAYTRACER_EXPORT void UpdateWorldTransform() override;
+
+    // Removes from this group the children fully contained in each half of
+    // its bounds. Children straddling both halves are left untouched.
+    RAYTRACER_EXPORT std::pair<std::vector<ShapePtr>, std::vector<ShapePtr>> PartitionChildren();
+    RAYTRACER_EXPORT void MakeSubgroup(std::vector<ShapePtr> const& children);
+
 protected:
     void UpdateBounds(ShapePtr child);
     virtual void UpdateBounds() override;
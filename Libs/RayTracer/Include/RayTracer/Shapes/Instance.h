@@ -0,0 +1,54 @@
+#pragma once
+
+#include "raytracer_export.h"
+#include "Shape.h"
+#include "../Bvh.h"
+
+#include <memory>
+
+// Shape tree of an archetype, built once and shared by all of its instances
+// along with the acceleration structure over its top level shapes
+struct InstancePrototype
+{
+    ShapePtr m_root;
+    Bvh m_bvh;
+};
+
+using InstancePrototypeConstPtr = std::shared_ptr<InstancePrototype const>;
+
+// Lightweight placement of an archetype. Instances own a transform and
+// optionally a material override, the geometry lives in the shared prototype.
+// Instances are meant to be placed at the top level of a world, nesting them
+// is not supported.
+class Instance : public Shape
+{
+public:
+    RAYTRACER_EXPORT explicit Instance(InstancePrototypeConstPtr const& prototype);
+
+    RAYTRACER_EXPORT void Initialize(json const& data, json const& dataOverride, ArchetypeMap const& archetypes) override;
+
+    RAYTRACER_EXPORT void Intersect(Ray const& ray, std::vector<Intersection>& xs) const override;
+    RAYTRACER_EXPORT bool IntersectsBefore(Ray const& ray, float distance) const override;
+    RAYTRACER_EXPORT bool IntersectClosest(Ray const& ray, Intersection& hit) const override;
+    RAYTRACER_EXPORT Tuple NormalAtLocal(Tuple const& point) const override;
+
+    // Normal of a shape from the prototype at the given world space point
+    RAYTRACER_EXPORT Tuple PrototypeNormalAt(Shape const* object, Tuple const& point) const;
+
+    InstancePrototypeConstPtr const& Prototype() const { return m_prototype; }
+
+    bool OverridesMaterial() const { return m_overridesMaterial; }
+    void OverridesMaterial(bool overrides) { m_overridesMaterial = overrides; }
+
+    // Builds the prototype shared by every instance of the given shape tree.
+    // The root transform is reset, as each instance provides its own.
+    RAYTRACER_EXPORT static InstancePrototypeConstPtr Compile(ShapePtr const& root);
+
+    // Whether an archetype reference can be turned into an instance, that is,
+    // it only overrides properties owned by instances
+    RAYTRACER_EXPORT static bool CanInstance(json const& archetypeTemplate, json const& reference);
+
+private:
+    InstancePrototypeConstPtr m_prototype;
+    bool m_overridesMaterial;
+};
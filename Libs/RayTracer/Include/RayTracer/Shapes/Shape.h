@@ -2,6 +2,7 @@
 
 #include "raytracer_export.h"
 
+#include "../AffineTransform.h"
 #include "../Bounds.h"
 #include "../Material.h"
 #include "../Matrix.h"
@@ -16,6 +17,7 @@
 using nlohmann::json;
 
 class Ray;
+class RayPacket;
 
 class Shape : public std::enable_shared_from_this<Shape>
 {
@@ -27,11 +29,19 @@ public:
     Bounds const& GetBounds() const { return m_bounds; }
 
     RAYTRACER_EXPORT void SetTransform(Mat44 const& t);
-    Mat44 const& Transform() const { return m_transform; }
-    Mat44 const& InvTransform() const { return m_invTransform; }
+    AffineTransform const& Transform() const { return m_transform; }
+    AffineTransform const& InvTransform() const { return m_invTransform; }
 
     ShapePtr Parent() { return m_parent; }
-    void SetParent(ShapePtr parent) { m_parent = parent; }
+    void SetParent(ShapePtr parent) { m_parent = parent; UpdateWorldTransform(); }
+
+    // Transforms composed with the ones of all the parents, kept up to date
+    // by SetTransform and SetParent
+    AffineTransform const& WorldToObject() const { return m_worldToObject; }
+    AffineTransform const& NormalToWorldTransform() const { return m_normalToWorld; }
+
+    // Recomposes them after a parent moved. Groups also update their children.
+    RAYTRACER_EXPORT virtual void UpdateWorldTransform();
 
     Material& ModifyMaterial() { return m_material; }
     Material const& GetMaterial() const { return m_material; }
@@ -48,8 +58,25 @@ public:
     // ray is in shape's local space
     virtual void Intersect(Ray const& ray, std::vector<Intersection>& xs) const = 0;
 
-    // ray is in shape's local space
-    RAYTRACER_EXPORT bool IntersectsBefore(Ray const& ray, float distance) const;
+    // ray is in shape's local space. Occlusion query, true if the ray hits the
+    // shape within [EPSILON, distance). Shapes should override it to answer
+    // without collecting intersections, the default implementation does.
+    RAYTRACER_EXPORT virtual bool IntersectsBefore(Ray const& ray, float distance) const;
+
+    // ray is in shape's local space. Closest hit query, see Ray::IntersectClosest.
+    // Shapes should override it to skip hits beyond the ray tMax without
+    // collecting intersections, the default implementation does.
+    RAYTRACER_EXPORT virtual bool IntersectClosest(Ray const& ray, Intersection& hit) const;
+
+    // packet is in shape's local space. Packet versions of the two queries
+    // above, see RayPacket. The default implementations trace one lane after
+    // the other through the single ray versions.
+    RAYTRACER_EXPORT virtual uint32_t IntersectsBefore(RayPacket const& packet, uint32_t mask, float const* distances) const;
+    RAYTRACER_EXPORT virtual uint32_t IntersectClosest(RayPacket const& packet, uint32_t mask, Intersection* hits) const;
+
+    // Breaks down groups with at least threshold children into a hierarchy of
+    // smaller groups. Does nothing for primitive shapes.
+    virtual void Divide(uint32_t /*threshold*/) {}
 
     RAYTRACER_EXPORT virtual bool operator==(Shape const& other) const;
 
@@ -75,8 +102,10 @@ protected:
 private:
     std::string m_name;
     Bounds m_bounds;
-    Mat44 m_transform;
-    Mat44 m_invTransform;
+    AffineTransform m_transform;
+    AffineTransform m_invTransform;
+    AffineTransform m_worldToObject;
+    AffineTransform m_normalToWorld;
     Material m_material;
     bool m_castShadows;
     std::shared_ptr<Shape> m_parent;
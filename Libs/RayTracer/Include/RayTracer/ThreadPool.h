@@ -0,0 +1,86 @@
+#pragma once
+
+#include "raytracer_export.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Time spent by a worker of a ThreadPool during a single ParallelFor
+struct WorkerStats
+{
+    double m_busySeconds = 0.;  // running tasks
+    double m_idleSeconds = 0.;  // waiting to be woken up, looking for tasks or for the others to finish
+    uint32_t m_tasks = 0u;
+    uint32_t m_steals = 0u;     // times it ran out of tasks and took some from another worker
+};
+
+// Persistent threads running batches of tasks. Every worker starts with a
+// contiguous range of the task indices and takes them from the front, once
+// done it steals the back half of the range of another worker. Neighbour
+// tasks, such as neighbour tiles of an image, thus tend to be run by the same
+// worker, while no worker sits idle as long as there are tasks left.
+class ThreadPool
+{
+public:
+    using Task = std::function<void(uint32_t index, uint32_t worker)>;
+
+    // 0 uses one worker per hardware thread
+    RAYTRACER_EXPORT explicit ThreadPool(uint32_t workerCount);
+    RAYTRACER_EXPORT ~ThreadPool();
+
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    uint32_t WorkerCount() const { return static_cast<uint32_t>(m_threads.size()); }
+
+    // Runs task for every index in [0, count) and blocks until all of them
+    // are done. Calls are serialized, tasks must not call it on the same
+    // pool. The first exception thrown by a task is rethrown once the others
+    // are done. Time spent by every worker is written to stats if not null.
+    RAYTRACER_EXPORT void ParallelFor(uint32_t count, Task const& task, std::vector<WorkerStats>* stats = nullptr);
+
+    // Called by a task, the tasks of the current ParallelFor not started yet
+    // are dropped. Those already running still finish.
+    void Cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+
+    // Pool with the given number of workers shared by the whole process,
+    // created on first use
+    RAYTRACER_EXPORT static ThreadPool& Shared(uint32_t workerCount);
+
+private:
+    // Range of task indices still owned by a worker
+    struct alignas(64) Queue
+    {
+        std::mutex m_mutex;
+        uint32_t m_begin = 0u;
+        uint32_t m_end = 0u;
+    };
+
+    void Work(uint32_t worker);
+    void RunTasks(uint32_t worker);
+    bool Pop(uint32_t worker, uint32_t& index);
+    bool Steal(uint32_t worker, uint32_t& index);
+
+    std::vector<std::thread> m_threads;
+    std::unique_ptr<Queue[]> m_queues;
+    std::vector<WorkerStats> m_stats;
+
+    std::mutex m_runMutex; // held for a whole ParallelFor
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    uint64_t m_generation = 0u;
+    uint32_t m_running = 0u;
+    bool m_stop = false;
+
+    Task const* m_task = nullptr;
+    std::exception_ptr m_exception;
+    std::atomic<bool> m_cancelled = false;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "raytracer_export.h"
+
+#include "Accelerator.h"
+#include "Types.h"
+
+#include <vector>
+
+class LinearBvh;
+
+// Parts of a world that rays within the frustum of a tile may hit, collected
+// once per tile by World::CollectCandidates: objects, and subtrees of a
+// linear bvh whose other nodes were culled. Accelerators that can't be culled
+// are referenced as a whole. Queries only give the same results as the world
+// for rays within that frustum.
+class TileCandidates : public IAccelerator
+{
+public:
+    RAYTRACER_EXPORT TileCandidates();
+
+    RAYTRACER_EXPORT void Clear();
+
+    void Add(ShapePtr const& object) { m_objects.push_back(object); }
+    RAYTRACER_EXPORT void Add(LinearBvh const& bvh, uint32_t nodeIdx);
+    RAYTRACER_EXPORT void SetFallback(IAccelerator const* accelerator);
+
+    size_t ObjectCount() const { return m_objects.size(); }
+    size_t SubtreeCount() const { return m_subtrees.size(); }
+    bool IsCulled() const { return m_fallback == nullptr; }
+
+    RAYTRACER_EXPORT void Intersect(Ray const& ray, std::vector<Intersection>& xs) const override;
+    RAYTRACER_EXPORT bool IntersectClosest(Ray const& ray, Intersection& hit) const override;
+    RAYTRACER_EXPORT ShapePtr const* FindOccluder(Ray const& ray, float distance) const override;
+
+    RAYTRACER_EXPORT uint32_t IntersectClosest(RayPacket const& packet, uint32_t mask, Intersection* hits) const override;
+    RAYTRACER_EXPORT uint32_t FindOccluders(RayPacket const& packet, uint32_t mask, float const* distances) const override;
+
+private:
+    IAccelerator const* m_fallback = nullptr;
+    LinearBvh const* m_bvh = nullptr;
+    std::vector<ShapePtr> m_objects;
+    std::vector<uint32_t> m_subtrees; // root node indices, nearest first
+};
@@ -2,6 +2,8 @@
 
 #include "raytracer_export.h"
 
+#include "MathIntrinsics.h"
+
 #include <nlohmann/json.hpp>
 
 #include <ostream>
@@ -43,6 +45,10 @@ public:
     float& Z() { return m_z; }
     float& W() { return m_w; }
 
+    // The four components, contiguous, for the math kernels
+    float const* Data() const { return &m_x; }
+    float* Data() { return &m_x; }
+
 private:
     float m_x;
     float m_y;
@@ -53,13 +59,13 @@ private:
 RAYTRACER_EXPORT Tuple Point(float x, float y, float z);
 RAYTRACER_EXPORT Tuple Vector(float x, float y, float z);
 
-#define APPLY_OPERATOR(a, b, op) { a.X() op b.X(), a.Y() op b.Y(), a.Z() op b.Z(), a.W() op b.W() }
-inline Tuple operator+(Tuple const& a, Tuple const& b) { return APPLY_OPERATOR(a, b, +); }
-inline Tuple operator-(Tuple const& a, Tuple const& b) { return APPLY_OPERATOR(a, b, -); }
-inline Tuple operator*(Tuple const& a, Tuple const& b) { return APPLY_OPERATOR(a, b, *); }
-#undef APPLY_OPERATOR
+#define APPLY_KERNEL(a, b, kernel) Tuple r; math::active::kernel(a.Data(), b.Data(), r.Data()); return r
+inline Tuple operator+(Tuple const& a, Tuple const& b) { APPLY_KERNEL(a, b, Add); }
+inline Tuple operator-(Tuple const& a, Tuple const& b) { APPLY_KERNEL(a, b, Sub); }
+inline Tuple operator*(Tuple const& a, Tuple const& b) { APPLY_KERNEL(a, b, Mul); }
+#undef APPLY_KERNEL
 
-inline Tuple operator*(Tuple const& t, float s) { return { t.X() * s, t.Y() * s, t.Z() * s, t.W() * s }; }
+inline Tuple operator*(Tuple const& t, float s) { Tuple r; math::active::Scale(t.Data(), s, r.Data()); return r; }
 inline Tuple operator/(Tuple const& t, float s) { return t * (1.f / s); }
 inline Tuple operator-(Tuple const& t) { return { -t.X(), -t.Y(), -t.Z(), -t.W() }; }
 
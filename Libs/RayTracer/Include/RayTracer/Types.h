@@ -12,6 +12,8 @@ class Shape;
 using ShapePtr = std::shared_ptr<Shape>;
 using ShapeConstPtr = std::shared_ptr<Shape const>;
 
+class Instance;
+
 class IPattern;
 using PatternPtr = std::shared_ptr<IPattern>;
 using PatternConstPtr = std::shared_ptr<IPattern const>;
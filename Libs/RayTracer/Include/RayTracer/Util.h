@@ -25,6 +25,12 @@ inline bool Equals(float a, float b)
     return std::abs(a - b) < EPSILON;
 }
 
+// Whether a hit at distance t blocks the way to something at the given distance
+inline bool IsOccluding(float t, float distance)
+{
+    return (t >= EPSILON) && (t < distance);
+}
+
 template<typename T>
 typename std::enable_if_t<std::is_arithmetic_v<T>, T>
 Clamp(T value, T min, T max)
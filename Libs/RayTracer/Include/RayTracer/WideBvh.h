@@ -0,0 +1,98 @@
+#pragma once
+
+#include "raytracer_export.h"
+
+#include "Accelerator.h"
+#include "Bounds.h"
+#include "Bvh.h"
+#include "Types.h"
+
+#include <cstdint>
+#include <vector>
+
+class Ray;
+
+// Bounding volume hierarchy with up to kWidth children per node, built by
+// collapsing the binary tree of a Bvh: the child with the largest surface
+// area is opened until the node is full. Child bounds are stored as structure
+// of arrays and quantized to 8 bits relative to the bounds of their parent,
+// so a BVH4 node fits in a cache line (a BVH8 one in two) and a ray is tested
+// against all children of a node at once. Quantized bounds are rounded
+// outward, so they can only add candidates, never miss one.
+template<uint32_t kWidth>
+class WideBvh : public IAccelerator
+{
+    static_assert((kWidth == 4u) || (kWidth == 8u), "Wide bvh nodes have 4 or 8 children");
+
+public:
+    RAYTRACER_EXPORT WideBvh();
+    RAYTRACER_EXPORT explicit WideBvh(Bvh const& bvh);
+
+    RAYTRACER_EXPORT void Build(Bvh const& bvh);
+
+    // Quantizes again the bounds updated by a refit of the bvh it was built from
+    RAYTRACER_EXPORT void Refit(Bvh const& bvh, std::vector<ShapePtr> const& shapes);
+
+    RAYTRACER_EXPORT void Intersect(Ray const& ray, std::vector<Intersection>& xs) const override;
+    RAYTRACER_EXPORT bool IntersectClosest(Ray const& ray, Intersection& hit) const override;
+    RAYTRACER_EXPORT ShapePtr const* FindOccluder(Ray const& ray, float distance) const override;
+
+    Bounds GetBounds() const { return m_bounds; }
+    size_t NodeCount() const { return m_nodes.size(); }
+    size_t LeafCount() const { return m_leaves.size(); }
+
+private:
+    static constexpr uint32_t kNone = ~0u;
+    static constexpr uint32_t kLeafBit = 1u << 31u;
+
+    struct alignas(16 * kWidth) Node
+    {
+        float m_origin[3];           // min corner of the node
+        int8_t m_exponent[3];        // children are quantized in steps of 2^exponent
+        uint8_t m_childCount;
+        uint8_t m_shadowCasters;     // mask of the children with shadow casters below
+        uint8_t m_qMin[3][kWidth];
+        uint8_t m_qMax[3][kWidth];
+        uint32_t m_children[kWidth]; // node index, or leaf index with kLeafBit set
+    };
+    static_assert(sizeof(Node) == 16 * kWidth, "Wide bvh nodes must fit in 16 bytes per child");
+
+    // Range of objects of a leaf of the source bvh
+    struct Leaf
+    {
+        uint32_t m_first;
+        uint32_t m_count;
+    };
+
+    // Child still to visit, with the distance at which the ray enters it
+    struct StackEntry
+    {
+        uint32_t m_child;
+        float m_tNear;
+    };
+
+    uint32_t Collapse(Bvh const& bvh, uint32_t srcIdx, uint32_t parent);
+    void Quantize(Bvh const& bvh, uint32_t nodeIdx);
+
+    // Mask of the children crossed by the ray within [tMin, tMax], along
+    // with the distance at which it enters each of them
+    static uint32_t IntersectChildren(Node const& node, float const* origin, float const* invDir, float tMin, float tMax, float* tNear);
+
+    std::vector<Node> m_nodes;
+    std::vector<Leaf> m_leaves;
+    std::vector<ShapePtr> m_objects;
+    std::vector<ShapePtr> m_unbounded;
+    Bounds m_bounds = Bounds::Empty();
+
+    // Source bvh nodes of every node and of its children, used by refits
+    std::vector<uint32_t> m_sources;
+    std::vector<uint32_t> m_childSources;
+    std::vector<uint32_t> m_parents;
+    std::vector<uint32_t> m_leafParents; // indexed by source bvh node, kNone if not a leaf
+};
+
+extern template class WideBvh<4u>;
+extern template class WideBvh<8u>;
+
+using Bvh4 = WideBvh<4u>;
+using Bvh8 = WideBvh<8u>;
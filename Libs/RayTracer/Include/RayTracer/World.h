@@ -2,25 +2,54 @@
 
 #include "raytracer_export.h"
 
+#include "Accelerator.h"
+#include "Bvh.h"
 #include "Color.h"
 #include "Intersection.h"
+#include "LinearBvh.h"
 #include "Lighting.h"
 #include "Shapes/Shape.h"
 #include "Transformations.h"
+#include "WideBvh.h"
 
+#include <atomic>
 #include <istream>
 #include <map>
+#include <memory>
 #include <vector>
 
+class Frustum;
 class Ray;
+class RayPacket;
+class TileCandidates;
+struct InstancePrototype;
 
 class World
 {
 public:
+    // Acceleration structure used to answer ray queries. None falls back to
+    // testing every object, which is mostly useful to validate the others.
+    // Bvh4 and Bvh8 are wide trees collapsed from the binary one.
+    enum class AcceleratorType { None, Bvh, LinearBvh, Bvh4, Bvh8 };
+
+    // Shadow rays first test the object that occluded the previous shadow ray
+    // traced by the same thread toward the same light. These count how often
+    // that saves a full traversal.
+    struct OccluderCacheStats
+    {
+        uint64_t m_queries = 0u;
+        uint64_t m_hits = 0u;
+    };
+
+    // Reflected and refracted bounces traced when not given
+    static constexpr uint8_t kDefaultMaxDepth = 4u;
+
+    RAYTRACER_EXPORT World();
+
     RAYTRACER_EXPORT bool Load(std::istream& is);
 
     std::vector<ShapePtr> const& Objects() const { return m_objects; }
-    std::vector<ShapePtr>& ModifyObjects() { return m_objects; }
+    std::vector<ShapePtr>& ModifyObjects() { ResetAccelerator(); return m_objects; }
 
     std::vector<PointLight> const& Lights() const { return m_lights; }
     std::vector<PointLight>& ModifyLights() { return m_lights; }
@@ -28,16 +57,72 @@ public:
     ArchetypeMap const& Archetypes() const { return m_archetypes; }
 
     RAYTRACER_EXPORT void Add(ArchetypePtr const& a);
-    void Add(ShapePtr const& s) { m_objects.push_back(s); }
+    void Add(ShapePtr const& s) { m_objects.push_back(s); ResetAccelerator(); }
     void Add(PointLight const& l) { m_lights.push_back(l); }
 
-    RAYTRACER_EXPORT Color ShadeHit(IntersectionData const& data, uint8_t remaining = 4u) const;
-    RAYTRACER_EXPORT Color ReflectedColor(IntersectionData const& data, uint8_t maxRecursion = 4u) const;
-    RAYTRACER_EXPORT Color RefractedColor(IntersectionData const& data, uint8_t maxRecursion = 4u) const;
-    RAYTRACER_EXPORT Color ColorAt(Ray const& r, uint8_t remaining = 4u) const;
+    // Builds the accelerator from the bvh if there is one and it was not
+    // built yet
+    RAYTRACER_EXPORT void SetAcceleratorType(AcceleratorType type);
+    AcceleratorType GetAcceleratorType() const { return m_acceleratorType; }
+
+    // Must be called after adding or modifying objects, otherwise queries
+    // fall back to brute force. Load() builds it automatically. Only the bvh
+    // and the accelerator of the current type collapsed from it are built.
+    RAYTRACER_EXPORT void BuildAccelerator();
+
+    // Keeps the accelerator valid after moving the given objects, which may
+    // be nested in groups, by refitting only the affected nodes. The tree is
+    // rebuilt instead when it can't be refitted or its quality degraded.
+    RAYTRACER_EXPORT void RefitAccelerator(std::vector<ShapePtr> const& moved);
+
+    // Returns null if the accelerator is disabled or out of date
+    RAYTRACER_EXPORT IAccelerator const* GetAccelerator() const;
+    Bvh const* GetBvh() const { return (m_acceleratorType == AcceleratorType::Bvh) ? m_bvh.get() : nullptr; }
+    LinearBvh const* GetLinearBvh() const { return (m_acceleratorType == AcceleratorType::LinearBvh) ? m_linearBvh.get() : nullptr; }
+    Bvh4 const* GetBvh4() const { return (m_acceleratorType == AcceleratorType::Bvh4) ? m_bvh4.get() : nullptr; }
+    Bvh8 const* GetBvh8() const { return (m_acceleratorType == AcceleratorType::Bvh8) ? m_bvh8.get() : nullptr; }
+
+    RAYTRACER_EXPORT Color ShadeHit(IntersectionData const& data, uint8_t remaining = kDefaultMaxDepth) const;
+    RAYTRACER_EXPORT Color ReflectedColor(IntersectionData const& data, uint8_t maxRecursion = kDefaultMaxDepth) const;
+    RAYTRACER_EXPORT Color RefractedColor(IntersectionData const& data, uint8_t maxRecursion = kDefaultMaxDepth) const;
+    RAYTRACER_EXPORT Color ColorAt(Ray const& r, uint8_t remaining = kDefaultMaxDepth) const;
+
+    // Writes the color seen by every ray of the packet to colors, indexed by
+    // lane. Hits and shadow rays toward each light are traced as packets,
+    // the latter without the occluder cache. Reflected and refracted rays
+    // diverge, so they are traced one by one.
+    RAYTRACER_EXPORT void ColorAt(RayPacket const& packet, Color* colors, uint8_t remaining = kDefaultMaxDepth) const;
+
+    // Same as above for primary rays of a tile, whose closest hits are only
+    // searched among the candidates collected for the frustum of the tile.
+    // Shadow, reflected and refracted rays still go through the whole world.
+    RAYTRACER_EXPORT Color ColorAt(Ray const& r, TileCandidates const& candidates, uint8_t remaining = kDefaultMaxDepth) const;
+    RAYTRACER_EXPORT void ColorAt(RayPacket const& packet, TileCandidates const& candidates, Color* colors, uint8_t remaining = kDefaultMaxDepth) const;
+
+    // Objects and accelerator nodes that rays within the frustum may hit.
+    // Objects with infinite bounds are always kept.
+    RAYTRACER_EXPORT void CollectCandidates(Frustum const& frustum, TileCandidates& candidates) const;
 
     RAYTRACER_EXPORT bool IsShadowed(Tuple const& point, PointLight const& light) const;
 
+    void UseOccluderCache(bool use) { m_useOccluderCache = use; }
+    bool UseOccluderCache() const { return m_useOccluderCache; }
+
+    // Counters of threads still rendering may not be accounted yet
+    RAYTRACER_EXPORT OccluderCacheStats GetOccluderCacheStats() const;
+    RAYTRACER_EXPORT void ResetOccluderCacheStats();
+
+    // Publishes the counters of the calling thread, so they are accounted
+    // right away by GetOccluderCacheStats
+    RAYTRACER_EXPORT void FlushOccluderCacheStats() const;
+
+    // Shared by every thread tracing shadow rays in this world
+    struct OccluderCacheCounters
+    {
+        std::atomic<uint64_t> m_queries = 0u;
+        std::atomic<uint64_t> m_hits = 0u;
+    };
+
 protected:
     friend class Loader;
 
@@ -45,8 +130,33 @@ protected:
     bool LoadArchetypes(std::vector<json> const& archetypes);
     bool LoadLight(json const& data);
 
+    // Returns null if the object is not an archetype reference that can be instanced
+    ShapePtr CreateInstance(json const& data);
+
+    // Builds the accelerator of the current type from the bvh if missing
+    void BuildCollapsed();
+
+    // Also renews the scene id, as objects may have been removed
+    void ResetAccelerator() { m_bvh.reset(); m_linearBvh.reset(); m_bvh4.reset(); m_bvh8.reset(); m_sceneId = NextSceneId(); }
+    RAYTRACER_EXPORT static uint64_t NextSceneId();
+
+    // Shading steps shared by single rays and packets
+    IntersectionData Precompute(Ray const& r, Intersection const& hit) const;
+    Color SurfaceColor(IntersectionData const& data) const;
+    Color AddSecondaryColors(Color const& color, IntersectionData const& data, uint8_t remaining) const;
+    void ShadePacket(RayPacket const& packet, uint32_t found, Intersection const* hits, Color* colors, uint8_t remaining) const;
+
 private:
     std::vector<ShapePtr>   m_objects;
     std::vector<PointLight> m_lights;
     ArchetypeMap            m_archetypes;
+    std::map<std::string, std::shared_ptr<InstancePrototype const>> m_prototypes;
+    AcceleratorType         m_acceleratorType;
+    std::shared_ptr<Bvh> m_bvh;
+    std::shared_ptr<LinearBvh> m_linearBvh;
+    std::shared_ptr<Bvh4> m_bvh4;
+    std::shared_ptr<Bvh8> m_bvh8;
+    uint64_t                m_sceneId;
+    bool                    m_useOccluderCache;
+    std::shared_ptr<OccluderCacheCounters> m_occluderCacheCounters;
 };
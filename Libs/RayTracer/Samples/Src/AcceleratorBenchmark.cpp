@@ -0,0 +1,92 @@
+#include <RayTracer/Camera.h>
+#include <RayTracer/Shapes/Plane.h>
+#include <RayTracer/Shapes/Sphere.h>
+#include <RayTracer/Transformations.h>
+#include <RayTracer/World.h>
+
+#include <iostream>
+#include <string>
+
+namespace
+{
+
+World BuildScene(int gridSize)
+{
+    World world;
+    world.Add(PointLight(Point(-10.f, 20.f, -10.f), Color(1.f, 1.f, 1.f)));
+    world.Add(std::make_shared<Plane>());
+
+    float const offset = gridSize * .5f;
+    for (int i = 0; i < gridSize; i++)
+    {
+        for (int j = 0; j < gridSize; j++)
+        {
+            auto sphere = std::make_shared<Sphere>();
+            sphere->SetTransform(matrix::Translation(i - offset, .25f, j - offset) * matrix::Scaling(.25f, .25f, .25f));
+            sphere->ModifyMaterial().SetColor(Color((float)i / gridSize, .5f, (float)j / gridSize));
+            world.Add(sphere);
+        }
+    }
+
+    world.BuildAccelerator();
+    return world;
+}
+
+void Benchmark(std::string const& name, World const& world, World::AcceleratorType type, Camera const& camera, RenderSettings settings)
+{
+    settings.m_accelerator = type;
+    settings.m_occluderCacheStats = true;
+    RenderStats stats;
+    auto const canvas = camera.Render(world, settings, &stats);
+    std::cout << name << ": " << stats.m_seconds << " seconds." << std::endl;
+    if (settings.m_maxSamplesPerPixel > 0u)
+    {
+        std::cout << "  samples per pixel: " << (double(stats.m_samples) / (camera.HorizontalSize() * camera.VerticalSize())) << std::endl;
+    }
+
+    if (stats.m_occluderCache.m_queries > 0u)
+    {
+        std::cout << "  occluder cache hits: " << stats.m_occluderCache.m_hits << "/" << stats.m_occluderCache.m_queries
+            << " (" << ((100.0 * stats.m_occluderCache.m_hits) / stats.m_occluderCache.m_queries) << "%)" << std::endl;
+    }
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    int const gridSize = (argc > 1) ? std::stoi(argv[1]) : 100;
+    std::cout << "Building scene with " << (gridSize * gridSize) << " spheres..." << std::endl;
+    auto world = BuildScene(gridSize);
+
+    auto camera = Camera(320, 240, PI / 3.f);
+    camera.SetTransform(matrix::View(Point(0.f, gridSize * .5f, -gridSize * .75f), Point(0.f, 0.f, 0.f), Vector(0.f, 1.f, 0.f)));
+
+    RenderSettings settings;
+    settings.m_packetSize = 1u;
+    Benchmark("Bvh", world, World::AcceleratorType::Bvh, camera, settings);
+    Benchmark("LinearBvh", world, World::AcceleratorType::LinearBvh, camera, settings);
+    Benchmark("Bvh4", world, World::AcceleratorType::Bvh4, camera, settings);
+    Benchmark("Bvh8", world, World::AcceleratorType::Bvh8, camera, settings);
+    world.UseOccluderCache(false);
+    Benchmark("LinearBvh without occluder cache", world, World::AcceleratorType::LinearBvh, camera, settings);
+    world.UseOccluderCache(true);
+    for (uint32_t packetSize : { 4u, 8u, 16u })
+    {
+        settings.m_packetSize = packetSize;
+        Benchmark("LinearBvh with packets of " + std::to_string(packetSize) + " rays", world, World::AcceleratorType::LinearBvh, camera, settings);
+    }
+    settings.m_frustumCulling = false;
+    Benchmark("LinearBvh with packets of 16 rays without frustum culling", world, World::AcceleratorType::LinearBvh, camera, settings);
+    settings.m_frustumCulling = true;
+    settings.m_maxSamplesPerPixel = 16u;
+    Benchmark("LinearBvh with packets of 16 rays and adaptive sampling", world, World::AcceleratorType::LinearBvh, camera, settings);
+    settings.m_maxSamplesPerPixel = 0u;
+    settings.m_packetSize = 1u;
+    if (gridSize <= 32)
+    {
+        Benchmark("None", world, World::AcceleratorType::None, camera, settings);
+    }
+
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <RayTracer/Camera.h>
+#include <RayTracer/Distributed.h>
+#include <RayTracer/Transformations.h>
+#include <RayTracer/World.h>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Renders the scene of chapter 13 with worker processes:
+//   00_DistributedRender [workers] [address]  forks the workers on this host, then coordinates them
+//   00_DistributedRender --worker <address>   joins a coordinator running elsewhere
+int main(int argc, char** argv)
+{
+    if ((argc > 2) && (std::string(argv[1]) == "--worker"))
+    {
+        return RunRenderWorker(argv[2]) ? 0 : 1;
+    }
+
+    uint32_t const workers = (argc > 1) ? std::stoul(argv[1]) : 4u;
+    std::string const address = (argc > 2) ? argv[2] : "unix:/tmp/raytracer-" + std::to_string(getpid()) + ".sock";
+
+    std::ifstream ifs("Resources/Ch13_CylindersAndCones.scene.json");
+    std::stringstream scene;
+    scene << ifs.rdbuf();
+
+    auto camera = Camera(800, 600, PI / 3.f);
+    camera.SetTransform(matrix::View(Point(29.f, 10.f, -29.f), Point(-5.f, 9.f, 0.f), Vector(0.f, 1.f, 0.f)));
+
+    // Workers are forked before any thread is started, each of them renders
+    // its tiles with one thread so they share the host. They quit once the
+    // coordinator is destroyed.
+    std::vector<pid_t> children;
+    {
+        RenderCoordinator coordinator(address);
+        for (uint32_t i = 0u; i < workers; i++)
+        {
+            pid_t const pid = fork();
+            if (pid == 0)
+            {
+                _exit(RunRenderWorker(coordinator.Address(), 1u) ? 0 : 1);
+            }
+            children.push_back(pid);
+        }
+
+        std::cout << coordinator.WaitForWorkers(workers, 10.) << " workers joined " << coordinator.Address() << std::endl;
+        using hrc = std::chrono::high_resolution_clock;
+        auto const t1 = hrc::now();
+        auto const canvas = coordinator.Render(scene.str(), camera);
+        auto const t2 = hrc::now();
+        std::cout << "Scene rendered in " << std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1).count() << " seconds." << std::endl;
+
+        std::ofstream ppmFile("DistributedRender.ppm");
+        ppmFile << canvas.GetAsPPM();
+    }
+
+    for (pid_t child : children)
+    {
+        waitpid(child, nullptr, 0);
+    }
+    return 0;
+}
@@ -43,7 +43,8 @@ int main()
                 auto const hitPos = ray.Position(hit.Distance());
                 auto const normal = hit.Object()->NormalAt(hitPos);
                 auto const eye = -ray.Direction();
-                auto const color = Lighting(hit.Object()->GetMaterial(), hit.Object(), light, hitPos, eye, normal);
+                auto const& material = hit.Object()->GetMaterial();
+                auto const color = Lighting(material, material.ColorAt(hit.Object(), hitPos), light, hitPos, eye, normal);
                 canvas.WritePixel(x, y, color);
             }
         }
@@ -0,0 +1,103 @@
+#include <RayTracer/MathIntrinsics.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Times the scalar and SSE kernels behind Tuple and Mat44 arithmetic
+namespace
+{
+
+constexpr int kIterations = 10000000;
+
+template<typename F>
+void Time(std::string const& name, F const& f)
+{
+    using hrc = std::chrono::high_resolution_clock;
+    auto const t1 = hrc::now();
+    float const sink = f();
+    auto const t2 = hrc::now();
+    auto const timeSpan = std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1);
+    std::cout << name << ": " << timeSpan.count() << " seconds. (" << sink << ")" << std::endl;
+}
+
+template<typename Kernels>
+void Benchmark(std::string const& prefix)
+{
+    // Rotation, so repeated products neither vanish nor overflow
+    float m[16] = { .8f, -.6f, 0.f, 0.f, .6f, .8f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f };
+    float v[4] = { 1.f, 2.f, 3.f, 1.f };
+
+    Time(prefix + " dot", [&]() {
+        float sum = 0.f;
+        for (int i = 0; i < kIterations; i++)
+        {
+            v[0] = static_cast<float>(i & 7);
+            sum += Kernels::Dot(v, v);
+        }
+        return sum;
+    });
+
+    Time(prefix + " cross", [&]() {
+        float r[4] = { 1.f, 0.f, 0.f, 0.f };
+        for (int i = 0; i < kIterations; i++)
+        {
+            Kernels::Cross(r, v, r);
+            Kernels::Normalize(r, r);
+        }
+        return r[0];
+    });
+
+    Time(prefix + " matrix * vector", [&]() {
+        float r[4] = { 1.f, 1.f, 1.f, 1.f };
+        for (int i = 0; i < kIterations; i++)
+        {
+            Kernels::MulMat44Vec(m, r, r);
+        }
+        return r[0];
+    });
+
+    Time(prefix + " matrix * matrix", [&]() {
+        float r[16];
+        Kernels::MulMat44(m, m, r);
+        for (int i = 0; i < kIterations / 4; i++)
+        {
+            Kernels::MulMat44(m, r, r);
+        }
+        return r[0];
+    });
+}
+
+struct Scalar
+{
+    static float Dot(float const* a, float const* b) { return math::scalar::Dot(a, b); }
+    static void Cross(float const* a, float const* b, float* r) { math::scalar::Cross(a, b, r); }
+    static void Normalize(float const* a, float* r) { math::scalar::Normalize(a, r); }
+    static void MulMat44Vec(float const* m, float const* v, float* r) { math::scalar::MulMat44Vec(m, v, r); }
+    static void MulMat44(float const* a, float const* b, float* r) { math::scalar::MulMat44(a, b, r); }
+};
+
+#ifdef USE_SSE
+struct Sse
+{
+    static float Dot(float const* a, float const* b) { return math::sse::Dot(a, b); }
+    static void Cross(float const* a, float const* b, float* r) { math::sse::Cross(a, b, r); }
+    static void Normalize(float const* a, float* r) { math::sse::Normalize(a, r); }
+    static void MulMat44Vec(float const* m, float const* v, float* r) { math::sse::MulMat44Vec(m, v, r); }
+    static void MulMat44(float const* a, float const* b, float* r) { math::sse::MulMat44(a, b, r); }
+};
+#endif
+
+}
+
+int main()
+{
+    Benchmark<Scalar>("Scalar");
+#ifdef USE_SSE
+    Benchmark<Sse>("SSE");
+#else
+    std::cout << "Built without USE_SSE, only the scalar kernels are available." << std::endl;
+#endif
+    return 0;
+}
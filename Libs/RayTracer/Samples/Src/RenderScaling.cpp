@@ -0,0 +1,98 @@
+#include <RayTracer/Camera.h>
+#include <RayTracer/Shapes/Plane.h>
+#include <RayTracer/Shapes/Sphere.h>
+#include <RayTracer/Transformations.h>
+#include <RayTracer/World.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// Glass spheres over a grid of matte ones, so some tiles cost far more than others
+World BuildScene(int gridSize)
+{
+    World world;
+    world.Add(PointLight(Point(-10.f, 20.f, -10.f), Color(1.f, 1.f, 1.f)));
+    world.Add(std::make_shared<Plane>());
+
+    float const offset = gridSize * .5f;
+    for (int i = 0; i < gridSize; i++)
+    {
+        for (int j = 0; j < gridSize; j++)
+        {
+            auto sphere = std::make_shared<Sphere>();
+            sphere->SetTransform(matrix::Translation(i - offset, .25f, j - offset) * matrix::Scaling(.25f, .25f, .25f));
+            sphere->ModifyMaterial().SetColor(Color((float)i / gridSize, .5f, (float)j / gridSize));
+            world.Add(sphere);
+        }
+    }
+
+    auto glass = std::make_shared<Sphere>();
+    glass->SetTransform(matrix::Translation(-offset * .25f, 2.f, -offset * .25f) * matrix::Scaling(2.f, 2.f, 2.f));
+    glass->ModifyMaterial().Transparency(1.f);
+    glass->ModifyMaterial().RefractiveIndex(1.5f);
+    glass->ModifyMaterial().Reflective(.9f);
+    world.Add(glass);
+
+    world.BuildAccelerator();
+    world.SetAcceleratorType(World::AcceleratorType::LinearBvh);
+    return world;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    int const gridSize = (argc > 1) ? std::stoi(argv[1]) : 100;
+    uint32_t const maxWorkers = (argc > 2) ? std::stoul(argv[2]) : std::max(std::thread::hardware_concurrency(), 1u);
+    std::cout << "Building scene with " << (gridSize * gridSize) << " spheres..." << std::endl;
+    auto const world = BuildScene(gridSize);
+
+    auto camera = Camera(640, 480, PI / 3.f);
+    camera.SetTransform(matrix::View(Point(0.f, gridSize * .5f, -gridSize * .75f), Point(0.f, 0.f, 0.f), Vector(0.f, 1.f, 0.f)));
+
+    // Powers of two, then every hardware thread
+    std::vector<uint32_t> workerCounts;
+    for (uint32_t workers = 1u; workers < maxWorkers; workers *= 2u)
+    {
+        workerCounts.push_back(workers);
+    }
+    workerCounts.push_back(maxWorkers);
+
+    double baseline = 0.;
+    for (uint32_t workers : workerCounts)
+    {
+        RenderSettings settings;
+        settings.m_threads = workers;
+        settings.m_workerStats = true;
+        RenderStats renderStats;
+        auto const canvas = camera.Render(world, settings, &renderStats);
+        auto const& stats = renderStats.m_workers;
+        double const seconds = renderStats.m_seconds;
+        baseline = (workers == 1u) ? seconds : baseline;
+
+        double busy = 0.;
+        double idle = 0.;
+        uint32_t steals = 0u;
+        for (auto const& s : stats)
+        {
+            busy += s.m_busySeconds;
+            idle += s.m_idleSeconds;
+            steals += s.m_steals;
+        }
+        std::cout << workers << " workers: " << seconds << " seconds, speedup " << (baseline / seconds)
+            << ", busy " << (100. * busy / (busy + idle)) << "%, " << steals << " steals" << std::endl;
+        for (size_t i = 0; i < stats.size(); i++)
+        {
+            std::cout << "  worker " << i << ": " << stats[i].m_tasks << " tiles, busy " << stats[i].m_busySeconds
+                << "s, idle " << stats[i].m_idleSeconds << "s" << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -65,12 +65,12 @@ void RenderScene(Canvas const &canvas, std::string const &outputFile)
     ShowCanvas(canvas);
 }
 
-void RenderScene(Camera const& camera, World const& world, std::string const& outputFile)
+void RenderScene(Camera const& camera, World const& world, std::string const& outputFile, RenderSettings const& settings)
 {
     std::cout << "Rendering scene..." << std::endl;
     using hrc = std::chrono::high_resolution_clock;
     auto t1 = hrc::now();
-    auto const canvas = camera.Render(world);
+    auto const canvas = camera.Render(world, settings);
     auto t2 = hrc::now();
 
     auto time_span = std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1);
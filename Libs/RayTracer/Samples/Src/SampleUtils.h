@@ -2,16 +2,17 @@
 
 #include "sampleutils_export.h"
 
+#include <RayTracer/RenderSettings.h>
+
 #include <string>
 
 class Camera;
 class Canvas;
-class World;
 
 namespace SampleUtils
 {
 
 SAMPLEUTILS_EXPORT void RenderScene(Canvas const &canvas, std::string const &outputFile="");
-SAMPLEUTILS_EXPORT void RenderScene(Camera const& camera, World const& world, std::string const& outputFile="");
+SAMPLEUTILS_EXPORT void RenderScene(Camera const& camera, World const& world, std::string const& outputFile="", RenderSettings const& settings=RenderSettings());
 
 }
@@ -0,0 +1,33 @@
+#include "Accelerator.h"
+
+#include "Ray.h"
+#include "RayPacket.h"
+#include "TileCandidates.h"
+
+uint32_t IAccelerator::IntersectClosest(RayPacket const& packet, uint32_t mask, Intersection* hits) const
+{
+    uint32_t found = 0u;
+    ForEachLane(mask, [&](uint32_t lane) {
+        Ray const ray = packet.At(lane);
+        if (IntersectClosest(ray, hits[lane]))
+        {
+            packet.TMax(lane, ray.TMax());
+            found |= 1u << lane;
+        }
+    });
+    return found;
+}
+
+uint32_t IAccelerator::FindOccluders(RayPacket const& packet, uint32_t mask, float const* distances) const
+{
+    uint32_t occluded = 0u;
+    ForEachLane(mask, [&](uint32_t lane) {
+        occluded |= IntersectsBefore(packet.At(lane), distances[lane]) ? (1u << lane) : 0u;
+    });
+    return occluded;
+}
+
+void IAccelerator::CollectCandidates(Frustum const&, TileCandidates& candidates) const
+{
+    candidates.SetFallback(this);
+}
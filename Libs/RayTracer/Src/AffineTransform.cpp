@@ -0,0 +1,177 @@
+#include "AffineTransform.h"
+
+#include <stdexcept>
+
+AffineTransform::AffineTransform()
+    : m_data{
+        { 1.f, 0.f, 0.f, 0.f },
+        { 0.f, 1.f, 0.f, 0.f },
+        { 0.f, 0.f, 1.f, 0.f } }
+    , m_kind(Kind::Identity)
+{
+}
+
+AffineTransform::AffineTransform(Mat44 const& m)
+{
+    if ((m.At(3, 0) != 0.f) || (m.At(3, 1) != 0.f) || (m.At(3, 2) != 0.f) || (m.At(3, 3) != 1.f))
+    {
+        throw std::runtime_error("Only affine transforms are supported!");
+    }
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        for (uint8_t j = 0; j < 4; j++)
+        {
+            m_data[i][j] = m.At(i, j);
+        }
+    }
+    Classify();
+}
+
+void AffineTransform::Classify()
+{
+    auto const& d = m_data;
+    bool const diagonal = (d[0][1] == 0.f) && (d[0][2] == 0.f)
+        && (d[1][0] == 0.f) && (d[1][2] == 0.f)
+        && (d[2][0] == 0.f) && (d[2][1] == 0.f);
+    bool const uniform = diagonal && (d[0][0] == d[1][1]) && (d[0][0] == d[2][2]);
+    bool const translates = (d[0][3] != 0.f) || (d[1][3] != 0.f) || (d[2][3] != 0.f);
+
+    if (uniform && (d[0][0] == 1.f))
+    {
+        m_kind = translates ? Kind::Translation : Kind::Identity;
+    }
+    else
+    {
+        m_kind = uniform ? Kind::UniformScale : Kind::General;
+    }
+}
+
+Mat44 AffineTransform::ToMat44() const
+{
+    return Mat44{
+        { m_data[0][0], m_data[0][1], m_data[0][2], m_data[0][3] },
+        { m_data[1][0], m_data[1][1], m_data[1][2], m_data[1][3] },
+        { m_data[2][0], m_data[2][1], m_data[2][2], m_data[2][3] },
+        { 0.f, 0.f, 0.f, 1.f } };
+}
+
+AffineTransform AffineTransform::Inverse() const
+{
+    AffineTransform inverse;
+    auto& r = inverse.m_data;
+    auto const& d = m_data;
+    switch (m_kind)
+    {
+    case Kind::Identity:
+        return inverse;
+
+    case Kind::Translation:
+        r[0][3] = -d[0][3];
+        r[1][3] = -d[1][3];
+        r[2][3] = -d[2][3];
+        break;
+
+    case Kind::UniformScale:
+    {
+        float const invScale = 1.f / d[0][0];
+        r[0][0] = r[1][1] = r[2][2] = invScale;
+        r[0][3] = -d[0][3] * invScale;
+        r[1][3] = -d[1][3] * invScale;
+        r[2][3] = -d[2][3] * invScale;
+        break;
+    }
+
+    default:
+    {
+        // Inverse of the linear part from its adjugate, then the translation
+        // is undone in the inverted space
+        r[0][0] = (d[1][1] * d[2][2]) - (d[1][2] * d[2][1]);
+        r[0][1] = (d[0][2] * d[2][1]) - (d[0][1] * d[2][2]);
+        r[0][2] = (d[0][1] * d[1][2]) - (d[0][2] * d[1][1]);
+        r[1][0] = (d[1][2] * d[2][0]) - (d[1][0] * d[2][2]);
+        r[1][1] = (d[0][0] * d[2][2]) - (d[0][2] * d[2][0]);
+        r[1][2] = (d[0][2] * d[1][0]) - (d[0][0] * d[1][2]);
+        r[2][0] = (d[1][0] * d[2][1]) - (d[1][1] * d[2][0]);
+        r[2][1] = (d[0][1] * d[2][0]) - (d[0][0] * d[2][1]);
+        r[2][2] = (d[0][0] * d[1][1]) - (d[0][1] * d[1][0]);
+
+        float const invDet = 1.f / ((d[0][0] * r[0][0]) + (d[0][1] * r[1][0]) + (d[0][2] * r[2][0]));
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            r[i][0] *= invDet;
+            r[i][1] *= invDet;
+            r[i][2] *= invDet;
+        }
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            r[i][3] = -((r[i][0] * d[0][3]) + (r[i][1] * d[1][3]) + (r[i][2] * d[2][3]));
+        }
+        break;
+    }
+    }
+
+    inverse.Classify();
+    return inverse;
+}
+
+AffineTransform AffineTransform::NormalMatrix() const
+{
+    AffineTransform normal;
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        for (uint8_t j = 0; j < 3; j++)
+        {
+            normal.m_data[i][j] = m_data[j][i];
+        }
+    }
+    normal.Classify();
+    return normal;
+}
+
+AffineTransform AffineTransform::operator*(AffineTransform const& other) const
+{
+    if (m_kind == Kind::Identity)
+    {
+        return other;
+    }
+    if (other.m_kind == Kind::Identity)
+    {
+        return *this;
+    }
+
+    AffineTransform c;
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        for (uint8_t j = 0; j < 4; j++)
+        {
+            c.m_data[i][j]
+                = (m_data[i][0] * other.m_data[0][j])
+                + (m_data[i][1] * other.m_data[1][j])
+                + (m_data[i][2] * other.m_data[2][j]);
+        }
+        c.m_data[i][3] += m_data[i][3];
+    }
+    c.Classify();
+    return c;
+}
+
+bool AffineTransform::operator==(AffineTransform const& other) const
+{
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        for (uint8_t j = 0; j < 4; j++)
+        {
+            if (!Equals(m_data[i][j], other.m_data[i][j]))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+std::ostream& operator<<(std::ostream& os, AffineTransform const& t)
+{
+    return os << t.ToMat44();
+}
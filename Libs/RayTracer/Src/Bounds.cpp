@@ -30,6 +30,44 @@ Bounds operator*(Mat44 const& m, Bounds const& b)
     return Bounds(min, max);
 }
 
+Bounds operator*(AffineTransform const& t, Bounds const& b)
+{
+    switch (t.GetKind())
+    {
+    case AffineTransform::Kind::Identity:
+        return b;
+    case AffineTransform::Kind::Translation:
+    {
+        auto const offset = Vector(t.At(0, 3), t.At(1, 3), t.At(2, 3));
+        return Bounds(b.Min() + offset, b.Max() + offset);
+    }
+    default:
+        break;
+    }
+
+    // Each axis of the result spans the extremes of every term contributing
+    // to it, which gives the same box as transforming the eight corners.
+    // Null terms are skipped so infinite bounds don't produce NaNs.
+    Tuple min = Point(t.At(0, 3), t.At(1, 3), t.At(2, 3));
+    Tuple max = min;
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        for (uint8_t j = 0; j < 3; j++)
+        {
+            float const m = t.At(i, j);
+            if (m == 0.f)
+            {
+                continue;
+            }
+            float const a = m * b.Min()[j];
+            float const c = m * b.Max()[j];
+            min[i] += std::min(a, c);
+            max[i] += std::max(a, c);
+        }
+    }
+    return Bounds(min, max);
+}
+
 std::ostream& operator<<(std::ostream& os, Bounds const& b)
 {
     os << "[" << b.Min() << ", " << b.Max() << "]";
@@ -47,6 +85,12 @@ Bounds::Bounds(Tuple const& min, Tuple const& max)
 {
 }
 
+// static
+Bounds Bounds::Empty()
+{
+    return Bounds(Point(INF, INF, INF), Point(-INF, -INF, -INF));
+}
+
 bool Bounds::operator==(Bounds const& other) const
 {
     return m_min == other.m_min
@@ -63,6 +107,74 @@ void Bounds::Merge(Bounds const& other)
                  , std::max(m_max.Z(), other.m_max.Z()) );
 }
 
+void Bounds::Merge(Tuple const& point)
+{
+    m_min = Point( std::min(m_min.X(), point.X())
+                 , std::min(m_min.Y(), point.Y())
+                 , std::min(m_min.Z(), point.Z()) );
+    m_max = Point( std::max(m_max.X(), point.X())
+                 , std::max(m_max.Y(), point.Y())
+                 , std::max(m_max.Z(), point.Z()) );
+}
+
+bool Bounds::IsFinite() const
+{
+    for (size_t i = 0; i < 3; i++)
+    {
+        if (!std::isfinite(m_min[i]) || !std::isfinite(m_max[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+Tuple Bounds::Center() const
+{
+    return Point( (m_min.X() + m_max.X()) * .5f
+                , (m_min.Y() + m_max.Y()) * .5f
+                , (m_min.Z() + m_max.Z()) * .5f );
+}
+
+float Bounds::SurfaceArea() const
+{
+    auto const dx = m_max.X() - m_min.X();
+    auto const dy = m_max.Y() - m_min.Y();
+    auto const dz = m_max.Z() - m_min.Z();
+    if ((dx < 0.f) || (dy < 0.f) || (dz < 0.f))
+    {
+        return 0.f;
+    }
+    return 2.f * ((dx * dy) + (dy * dz) + (dz * dx));
+}
+
+bool Bounds::Contains(Tuple const& point) const
+{
+    return (m_min.X() <= point.X()) && (point.X() <= m_max.X())
+        && (m_min.Y() <= point.Y()) && (point.Y() <= m_max.Y())
+        && (m_min.Z() <= point.Z()) && (point.Z() <= m_max.Z());
+}
+
+bool Bounds::Contains(Bounds const& other) const
+{
+    return Contains(other.m_min) && Contains(other.m_max);
+}
+
+std::pair<Bounds, Bounds> Bounds::Split() const
+{
+    auto const dx = m_max.X() - m_min.X();
+    auto const dy = m_max.Y() - m_min.Y();
+    auto const dz = m_max.Z() - m_min.Z();
+    auto const greatest = std::max(dx, std::max(dy, dz));
+
+    size_t const axis = (greatest == dx) ? 0 : ((greatest == dy) ? 1 : 2);
+    auto midMin = m_min;
+    auto midMax = m_max;
+    midMin[axis] = midMax[axis] = m_min[axis] + (greatest * .5f);
+
+    return { Bounds(m_min, midMax), Bounds(midMin, m_max) };
+}
+
 bool Bounds::Intersects(Ray const& ray, float& t1, float& t2) const
 {
     auto[xtMin, xtMax] = CheckAxis(ray.Origin().X(), ray.Direction().X(), m_min.X(), m_max.X());
@@ -0,0 +1,401 @@
+#include "Bvh.h"
+
+#include "Ray.h"
+#include "Shapes/Shape.h"
+
+#include <algorithm>
+#include <array>
+
+namespace
+{
+
+constexpr uint32_t kSahBins = 12u;
+constexpr uint32_t kMaxLeafSize = 4u;
+constexpr float kTraversalCost = 1.f;
+constexpr float kIntersectionCost = 1.f;
+
+struct SahBin
+{
+    Bounds m_bounds = Bounds::Empty();
+    uint32_t m_count = 0u;
+};
+
+uint32_t BinIndex(float centroid, float min, float extent)
+{
+    auto const idx = static_cast<uint32_t>(kSahBins * ((centroid - min) / extent));
+    return std::min(idx, kSahBins - 1u);
+}
+
+}
+
+Bvh::Bvh()
+{
+}
+
+Bvh::Bvh(std::vector<ShapePtr> const& objects)
+{
+    Build(objects);
+}
+
+void Bvh::Build(std::vector<ShapePtr> const& objects)
+{
+    m_nodes.clear();
+    m_objects.clear();
+    m_unbounded.clear();
+    m_objectLeaves.clear();
+    m_areaCost = 0.f;
+    m_buildSahCost = 0.f;
+
+    std::vector<BuildEntry> entries;
+    entries.reserve(objects.size());
+    for (auto const& obj : objects)
+    {
+        auto const bounds = obj->Transform() * obj->GetBounds();
+        if (bounds.IsFinite())
+        {
+            entries.push_back({ bounds, bounds.Center(), obj });
+        }
+        else
+        {
+            m_unbounded.push_back(obj);
+        }
+    }
+
+    if (entries.empty())
+    {
+        return;
+    }
+
+    m_nodes.reserve(2 * entries.size());
+    m_objects.reserve(entries.size());
+    BuildNode(entries, 0u, static_cast<uint32_t>(entries.size()), kNoParent, 1u);
+
+    for (auto const& node : m_nodes)
+    {
+        m_areaCost += NodeCost(node);
+    }
+    m_buildSahCost = SahCost();
+}
+
+uint32_t Bvh::BuildNode(std::vector<BuildEntry>& entries, uint32_t first, uint32_t count, uint32_t parent, uint32_t depth)
+{
+    auto const nodeIdx = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.push_back({ Bounds::Empty(), parent, 0u, 0u, 0u, 0u, false });
+
+    Bounds bounds = Bounds::Empty();
+    Bounds centroidBounds = Bounds::Empty();
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        bounds.Merge(entries[i].m_bounds);
+        centroidBounds.Merge(entries[i].m_centroid);
+    }
+    m_nodes[nodeIdx].m_bounds = bounds;
+
+    if ((count <= 1u) || (depth >= kMaxDepth))
+    {
+        MakeLeaf(nodeIdx, entries, first, count);
+        return nodeIdx;
+    }
+
+    // Evaluate the SAH cost of splitting at every bin boundary of every axis
+    float bestCost = INF;
+    uint32_t bestAxis = 0u;
+    uint32_t bestSplit = 0u;
+    for (uint32_t axis = 0u; axis < 3u; axis++)
+    {
+        float const min = centroidBounds.Min()[axis];
+        float const extent = centroidBounds.Max()[axis] - min;
+        if (extent < EPSILON)
+        {
+            continue;
+        }
+
+        std::array<SahBin, kSahBins> bins;
+        for (uint32_t i = first; i < first + count; i++)
+        {
+            auto& bin = bins[BinIndex(entries[i].m_centroid[axis], min, extent)];
+            bin.m_bounds.Merge(entries[i].m_bounds);
+            bin.m_count++;
+        }
+
+        // Sweep from the right to get the area and count of every right side
+        std::array<float, kSahBins> rightArea;
+        std::array<uint32_t, kSahBins> rightCount;
+        Bounds right = Bounds::Empty();
+        uint32_t rightAccum = 0u;
+        for (uint32_t b = kSahBins - 1u; b > 0u; b--)
+        {
+            right.Merge(bins[b].m_bounds);
+            rightAccum += bins[b].m_count;
+            rightArea[b] = right.SurfaceArea();
+            rightCount[b] = rightAccum;
+        }
+
+        Bounds left = Bounds::Empty();
+        uint32_t leftCount = 0u;
+        for (uint32_t b = 1u; b < kSahBins; b++)
+        {
+            left.Merge(bins[b - 1u].m_bounds);
+            leftCount += bins[b - 1u].m_count;
+            if ((leftCount == 0u) || (rightCount[b] == 0u))
+            {
+                continue;
+            }
+
+            float const cost = (left.SurfaceArea() * leftCount) + (rightArea[b] * rightCount[b]);
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = b;
+            }
+        }
+    }
+
+    float const area = bounds.SurfaceArea();
+    float const leafCost = kIntersectionCost * count;
+    float const splitCost = (area > 0.f)
+        ? kTraversalCost + ((kIntersectionCost * bestCost) / area)
+        : INF;
+
+    uint32_t mid = first;
+    if (bestCost < INF)
+    {
+        if ((splitCost >= leafCost) && (count <= kMaxLeafSize))
+        {
+            MakeLeaf(nodeIdx, entries, first, count);
+            return nodeIdx;
+        }
+
+        float const min = centroidBounds.Min()[bestAxis];
+        float const extent = centroidBounds.Max()[bestAxis] - min;
+        auto const it = std::partition(entries.begin() + first, entries.begin() + first + count,
+            [&](BuildEntry const& e) { return BinIndex(e.m_centroid[bestAxis], min, extent) < bestSplit; });
+        mid = static_cast<uint32_t>(it - entries.begin());
+    }
+    else if (count <= kMaxLeafSize)
+    {
+        // All centroids overlap, there is no way to separate them spatially
+        MakeLeaf(nodeIdx, entries, first, count);
+        return nodeIdx;
+    }
+
+    if ((mid == first) || (mid == (first + count)))
+    {
+        // No usable split found, halve the range to keep the tree balanced
+        mid = first + (count / 2u);
+    }
+
+    uint32_t const left = BuildNode(entries, first, mid - first, nodeIdx, depth + 1u);
+    uint32_t const right = BuildNode(entries, mid, first + count - mid, nodeIdx, depth + 1u);
+    m_nodes[nodeIdx].m_left = left;
+    m_nodes[nodeIdx].m_right = right;
+    m_nodes[nodeIdx].m_castsShadows = m_nodes[left].m_castsShadows || m_nodes[right].m_castsShadows;
+    return nodeIdx;
+}
+
+void Bvh::MakeLeaf(uint32_t nodeIdx, std::vector<BuildEntry> const& entries, uint32_t first, uint32_t count)
+{
+    auto& node = m_nodes[nodeIdx];
+    node.m_first = static_cast<uint32_t>(m_objects.size());
+    node.m_count = count;
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        m_objectLeaves[entries[i].m_shape.get()] = nodeIdx;
+        m_objects.push_back(entries[i].m_shape);
+        node.m_castsShadows |= entries[i].m_shape->CastShadows();
+    }
+}
+
+bool Bvh::Refit(std::vector<ShapePtr> const& shapes)
+{
+    for (auto const& shape : shapes)
+    {
+        auto const it = m_objectLeaves.find(shape.get());
+        if (it == m_objectLeaves.end())
+        {
+            return false;
+        }
+
+        uint32_t nodeIdx = it->second;
+        auto const& leaf = m_nodes[nodeIdx];
+        Bounds bounds = Bounds::Empty();
+        for (uint32_t i = leaf.m_first; i < leaf.m_first + leaf.m_count; i++)
+        {
+            bounds.Merge(m_objects[i]->Transform() * m_objects[i]->GetBounds());
+        }
+        if (!bounds.IsFinite())
+        {
+            return false;
+        }
+
+        // Only the path from the leaf up to the root is affected
+        while (nodeIdx != kNoParent)
+        {
+            SetNodeBounds(nodeIdx, bounds);
+            nodeIdx = m_nodes[nodeIdx].m_parent;
+            if (nodeIdx != kNoParent)
+            {
+                auto const& node = m_nodes[nodeIdx];
+                bounds = m_nodes[node.m_left].m_bounds;
+                bounds.Merge(m_nodes[node.m_right].m_bounds);
+            }
+        }
+    }
+    return true;
+}
+
+float Bvh::SahCost() const
+{
+    if (m_nodes.empty())
+    {
+        return 0.f;
+    }
+    float const rootArea = m_nodes.front().m_bounds.SurfaceArea();
+    return (rootArea > 0.f) ? (m_areaCost / rootArea) : 0.f;
+}
+
+float Bvh::NodeCost(Node const& node) const
+{
+    float const weight = node.IsLeaf() ? (kIntersectionCost * node.m_count) : kTraversalCost;
+    return weight * node.m_bounds.SurfaceArea();
+}
+
+void Bvh::SetNodeBounds(uint32_t nodeIdx, Bounds const& bounds)
+{
+    auto& node = m_nodes[nodeIdx];
+    m_areaCost -= NodeCost(node);
+    node.m_bounds = bounds;
+    m_areaCost += NodeCost(node);
+}
+
+size_t Bvh::Depth() const
+{
+    return m_nodes.empty() ? 0u : Depth(0u);
+}
+
+size_t Bvh::Depth(uint32_t nodeIdx) const
+{
+    auto const& node = m_nodes[nodeIdx];
+    if (node.IsLeaf())
+    {
+        return 1u;
+    }
+    return 1u + std::max(Depth(node.m_left), Depth(node.m_right));
+}
+
+void Bvh::Intersect(Ray const& ray, std::vector<Intersection>& xs) const
+{
+    for (auto const& obj : m_unbounded)
+    {
+        ray.Intersect(obj, xs);
+    }
+
+    if (!m_nodes.empty())
+    {
+        Intersect(ray, 0u, xs);
+    }
+}
+
+void Bvh::Intersect(Ray const& ray, uint32_t nodeIdx, std::vector<Intersection>& xs) const
+{
+    auto const& node = m_nodes[nodeIdx];
+    if (!node.m_bounds.Intersects(ray))
+    {
+        return;
+    }
+
+    if (node.IsLeaf())
+    {
+        for (uint32_t i = node.m_first; i < node.m_first + node.m_count; i++)
+        {
+            ray.Intersect(m_objects[i], xs);
+        }
+    }
+    else
+    {
+        Intersect(ray, node.m_left, xs);
+        Intersect(ray, node.m_right, xs);
+    }
+}
+
+bool Bvh::IntersectClosest(Ray const& ray, Intersection& hit) const
+{
+    bool found = false;
+    for (auto const& obj : m_unbounded)
+    {
+        found |= ray.IntersectClosest(obj, hit);
+    }
+
+    if (!m_nodes.empty())
+    {
+        found |= IntersectClosest(ray, 0u, hit);
+    }
+    return found;
+}
+
+bool Bvh::IntersectClosest(Ray const& ray, uint32_t nodeIdx, Intersection& hit) const
+{
+    auto const& node = m_nodes[nodeIdx];
+    float t1, t2;
+    if (!node.m_bounds.Intersects(ray, t1, t2) || (t2 < 0.f) || (t1 >= ray.TMax()))
+    {
+        return false;
+    }
+
+    bool found = false;
+    if (node.IsLeaf())
+    {
+        for (uint32_t i = node.m_first; i < node.m_first + node.m_count; i++)
+        {
+            found |= ray.IntersectClosest(m_objects[i], hit);
+        }
+        return found;
+    }
+
+    // Visiting the nearest child first lets its hits cull the other one
+    auto const& left = m_nodes[node.m_left];
+    auto const& right = m_nodes[node.m_right];
+    bool const rightIsNearest = (right.m_bounds.Center() - left.m_bounds.Center()).Dot(ray.Direction()) < 0.f;
+    found |= IntersectClosest(ray, rightIsNearest ? node.m_right : node.m_left, hit);
+    found |= IntersectClosest(ray, rightIsNearest ? node.m_left : node.m_right, hit);
+    return found;
+}
+
+ShapePtr const* Bvh::FindOccluder(Ray const& ray, float distance) const
+{
+    for (auto const& obj : m_unbounded)
+    {
+        if (ray.IntersectsBefore(obj, distance))
+        {
+            return &obj;
+        }
+    }
+
+    return m_nodes.empty() ? nullptr : FindOccluder(ray, distance, 0u);
+}
+
+ShapePtr const* Bvh::FindOccluder(Ray const& ray, float distance, uint32_t nodeIdx) const
+{
+    auto const& node = m_nodes[nodeIdx];
+    float t1, t2;
+    if (!node.m_castsShadows || !node.m_bounds.Intersects(ray, t1, t2) || (t2 < EPSILON) || (t1 >= distance))
+    {
+        return nullptr;
+    }
+
+    if (node.IsLeaf())
+    {
+        for (uint32_t i = node.m_first; i < node.m_first + node.m_count; i++)
+        {
+            if (ray.IntersectsBefore(m_objects[i], distance))
+            {
+                return &m_objects[i];
+            }
+        }
+        return nullptr;
+    }
+
+    auto const* occluder = FindOccluder(ray, distance, node.m_left);
+    return (occluder != nullptr) ? occluder : FindOccluder(ray, distance, node.m_right);
+}
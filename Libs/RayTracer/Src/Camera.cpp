@@ -1,33 +1,277 @@
 #include "Camera.h"
 
-#include <thread>
+#include "RayPacket.h"
+#include "ThreadPool.h"
+#include "TileCandidates.h"
 
-#ifndef RENDER_TASKS
-#   define RENDER_TASKS 1
-#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace
 {
-    constexpr uint32_t kRenderTasks = RENDER_TASKS;
-    void RenderRow(Camera const& camera, World const& world, Canvas &canvas, uint32_t rowBegin, uint32_t rowEnd, uint32_t cols)
+    using Clock = std::chrono::steady_clock;
+
+    // Spreads any number of first samples evenly over the pixel, so more can
+    // be added later on, the first one at the center
+    R2Sampler const kDefaultSampler;
+
+    float Luminance(Color const& c)
+    {
+        return (.2126f * c.R()) + (.7152f * c.G()) + (.0722f * c.B());
+    }
+
+    // Storage reused by every tile rendered by a thread, indexed by cell of
+    // the grid of the pass
+    struct TileScratch
+    {
+        TileCandidates m_candidates;
+        std::vector<Color> m_sums;
+        std::vector<float> m_luminances;        // sum over the samples
+        std::vector<float> m_squaredLuminances; // sum of the squares over the samples
+        std::vector<uint32_t> m_counts;
+        std::vector<std::pair<uint32_t, uint32_t>> m_samples; // cell and sample index to trace
+        std::vector<PixelBlock> m_blocks;
+        std::vector<Color> m_colors = std::vector<Color>(RayPacket::kMaxSize, Color(0.f, 0.f, 0.f)); // of the packet being traced
+    };
+
+    // Pool threads are persistent, so their scratch is only allocated by the
+    // first tiles they render
+    thread_local TileScratch t_scratch;
+
+    // Pixels of a tile traced by a pass, on a grid of the given stride from
+    // the corner of the tile. Each of them fills the stride x stride block of
+    // pixels it is the corner of. Passes after the first one skip the pixels
+    // traced by the previous one, on even columns and rows of their grid.
+    struct TilePass
+    {
+        uint32_t m_x0;
+        uint32_t m_y0;
+        uint32_t m_x1;
+        uint32_t m_y1;
+        uint32_t m_stride;
+        bool m_skipCoarser;
+
+        uint32_t Columns() const { return (m_x1 - m_x0 + m_stride - 1u) / m_stride; }
+        uint32_t Rows() const { return (m_y1 - m_y0 + m_stride - 1u) / m_stride; }
+        uint32_t X(uint32_t column) const { return m_x0 + (column * m_stride); }
+        uint32_t Y(uint32_t row) const { return m_y0 + (row * m_stride); }
+        bool Traces(uint32_t column, uint32_t row) const { return !m_skipCoarser || (((column | row) & 1u) != 0u); }
+    };
+
+    void AddSample(TileScratch& scratch, uint32_t cell, Color const& color)
+    {
+        float const luminance = Luminance(color);
+        scratch.m_sums[cell] = scratch.m_sums[cell] + color;
+        scratch.m_luminances[cell] += luminance;
+        scratch.m_squaredLuminances[cell] += luminance * luminance;
+        scratch.m_counts[cell]++;
+    }
+
+    // Traces the samples of the scratch in order, by packets of the size
+    // given by the settings
+    void TraceSamples(Camera const& camera, World const& world, RenderSettings const& settings, TilePass const& pass, TileCandidates const* candidates, TileScratch& scratch)
     {
-        for (uint32_t y = rowBegin; y < rowEnd; y++)
+        uint32_t const columns = pass.Columns();
+        ISampler const& sampler = (settings.m_sampler != nullptr) ? *settings.m_sampler : kDefaultSampler;
+        auto const ray = [&](std::pair<uint32_t, uint32_t> const& sample) {
+            uint32_t const x = pass.X(sample.first % columns);
+            uint32_t const y = pass.Y(sample.first / columns);
+            float dx = 0.f;
+            float dy = 0.f;
+            sampler.Get2D(x, y, sample.second, 0u, dx, dy);
+            return camera.RayForPixel(x, y, dx, dy);
+        };
+
+        auto const& samples = scratch.m_samples;
+        uint8_t const depth = settings.m_maxDepth;
+        if (settings.m_packetSize == 1u)
         {
-            for (uint32_t x = 0; x < cols; x++)
+            for (auto const& sample : samples)
+            {
+                Ray const r = ray(sample);
+                AddSample(scratch, sample.first, (candidates != nullptr) ? world.ColorAt(r, *candidates, depth) : world.ColorAt(r, depth));
+            }
+            return;
+        }
+
+        RayPacket packet;
+        auto& colors = scratch.m_colors;
+        for (size_t first = 0u; first < samples.size(); first += settings.m_packetSize)
+        {
+            size_t const last = std::min<size_t>(first + settings.m_packetSize, samples.size());
+            packet.Clear();
+            for (size_t i = first; i < last; i++)
+            {
+                packet.Add(ray(samples[i]));
+            }
+
+            if (candidates != nullptr)
+            {
+                world.ColorAt(packet, *candidates, colors.data(), depth);
+            }
+            else
+            {
+                world.ColorAt(packet, colors.data(), depth);
+            }
+            for (size_t i = first; i < last; i++)
             {
-                Ray const r = camera.RayForPixel(x, y);
-                canvas.WritePixel(x, y, world.ColorAt(r));
+                AddSample(scratch, samples[i].first, colors[i - first]);
             }
         }
     }
+
+    // The standard error of the luminance of the pixel, or its difference
+    // with the one of a neighbour traced by the same pass, exceeds the
+    // threshold. Neighbours in other tiles aren't known.
+    bool NeedsSamples(TileScratch const& scratch, TilePass const& pass, uint32_t column, uint32_t row, float threshold)
+    {
+        uint32_t const columns = pass.Columns();
+        auto const mean = [&](uint32_t cell) { return scratch.m_luminances[cell] / scratch.m_counts[cell]; };
+
+        uint32_t const cell = (row * columns) + column;
+        uint32_t const count = scratch.m_counts[cell];
+        float const m = mean(cell);
+        float const variance = std::max((scratch.m_squaredLuminances[cell] / count) - (m * m), 0.f);
+        if ((count > 1u) && (std::sqrt(variance / count) > threshold))
+        {
+            return true;
+        }
+
+        auto const differs = [&](uint32_t c, uint32_t r) {
+            return pass.Traces(c, r) && (std::abs(mean((r * columns) + c) - m) > threshold);
+        };
+        return ((column > 0u) && differs(column - 1u, row))
+            || ((column + 1u < columns) && differs(column + 1u, row))
+            || ((row > 0u) && differs(column, row - 1u))
+            || ((row + 1u < pass.Rows()) && differs(column, row + 1u));
+    }
+
+    // Pixels needing more samples get as many again, up to the max, until
+    // none of them does
+    void Refine(Camera const& camera, World const& world, RenderSettings const& settings, TilePass const& pass, TileCandidates const* candidates, TileScratch& scratch)
+    {
+        uint32_t const columns = pass.Columns();
+        uint32_t const maxSamples = settings.m_maxSamplesPerPixel;
+        auto& samples = scratch.m_samples;
+        while (true)
+        {
+            // Every pixel is checked before any of them gets new samples
+            samples.clear();
+            for (uint32_t row = 0u; row < pass.Rows(); row++)
+            {
+                for (uint32_t column = 0u; column < columns; column++)
+                {
+                    uint32_t const cell = (row * columns) + column;
+                    uint32_t const count = scratch.m_counts[cell];
+                    if (!pass.Traces(column, row) || (count >= maxSamples) || !NeedsSamples(scratch, pass, column, row, settings.m_adaptiveThreshold))
+                    {
+                        continue;
+                    }
+                    for (uint32_t sample = count; sample < std::min(2u * count, maxSamples); sample++)
+                    {
+                        samples.emplace_back(cell, sample);
+                    }
+                }
+            }
+            if (samples.empty())
+            {
+                return;
+            }
+            TraceSamples(camera, world, settings, pass, candidates, scratch);
+        }
+    }
+
+    // Base samples are traced in the same blocks of pixels for every
+    // sample, a packet each, so packets are coherent. The pixels to write are
+    // left in the blocks of the scratch. Returns the number of samples traced.
+    uint64_t RenderTile(Camera const& camera, World const& world, RenderSettings const& settings, TilePass const& pass, TileCandidates const* candidates, TileScratch& scratch)
+    {
+        uint32_t const columns = pass.Columns();
+        uint32_t const rows = pass.Rows();
+        scratch.m_sums.assign(columns * rows, Color(0.f, 0.f, 0.f));
+        scratch.m_luminances.assign(columns * rows, 0.f);
+        scratch.m_squaredLuminances.assign(columns * rows, 0.f);
+        scratch.m_counts.assign(columns * rows, 0u);
+
+        uint32_t const packetSize = settings.m_packetSize;
+        // Blocks are clipped at the edges of the tile, packets are then
+        // smaller. Single rays go through the whole tile at once.
+        uint32_t const blockWidth = (packetSize == 1u) ? columns : ((packetSize >= 8u) ? 4u : 2u);
+        uint32_t const blockHeight = (packetSize == 1u) ? rows : (packetSize / blockWidth);
+        auto& samples = scratch.m_samples;
+        for (uint32_t sample = 0u; sample < settings.m_samplesPerPixel; sample++)
+        {
+            for (uint32_t by = 0u; by < rows; by += blockHeight)
+            {
+                for (uint32_t bx = 0u; bx < columns; bx += blockWidth)
+                {
+                    samples.clear();
+                    for (uint32_t row = by; row < std::min(by + blockHeight, rows); row++)
+                    {
+                        for (uint32_t column = bx; column < std::min(bx + blockWidth, columns); column++)
+                        {
+                            if (pass.Traces(column, row))
+                            {
+                                samples.emplace_back((row * columns) + column, sample);
+                            }
+                        }
+                    }
+                    TraceSamples(camera, world, settings, pass, candidates, scratch);
+                }
+            }
+        }
+
+        if (settings.m_maxSamplesPerPixel > settings.m_samplesPerPixel)
+        {
+            Refine(camera, world, settings, pass, candidates, scratch);
+        }
+
+        uint64_t traced = 0u;
+        scratch.m_blocks.clear();
+        for (uint32_t row = 0u; row < rows; row++)
+        {
+            for (uint32_t column = 0u; column < columns; column++)
+            {
+                if (pass.Traces(column, row))
+                {
+                    uint32_t const cell = (row * columns) + column;
+                    uint32_t const x = pass.X(column);
+                    uint32_t const y = pass.Y(row);
+                    uint32_t const count = scratch.m_counts[cell];
+                    scratch.m_blocks.push_back({ x, y, std::min(x + pass.m_stride, pass.m_x1), std::min(y + pass.m_stride, pass.m_y1),
+                        scratch.m_sums[cell] * (1.f / count), count });
+                    traced += count;
+                }
+            }
+        }
+        return traced;
+    }
+
+    void Accumulate(std::vector<WorkerStats>& total, std::vector<WorkerStats> const& pass)
+    {
+        for (size_t i = 0; i < pass.size(); i++)
+        {
+            total[i].m_busySeconds += pass[i].m_busySeconds;
+            total[i].m_idleSeconds += pass[i].m_idleSeconds;
+            total[i].m_tasks += pass[i].m_tasks;
+            total[i].m_steals += pass[i].m_steals;
+        }
+    }
 }
 
 Camera::Camera(uint32_t hSize, uint32_t vSize, float fov)
     : m_hSize(hSize)
     , m_vSize(vSize)
     , m_fov(fov)
-    , m_transform(Mat44::Identity())
-    , m_invTransform(Mat44::Identity())
+    , m_transform()
+    , m_invTransform()
 {
     float const halfView = std::tanf(m_fov / 2.f);
     float const aspect = (float)m_hSize / (float)m_vSize;
@@ -38,8 +282,13 @@ Camera::Camera(uint32_t hSize, uint32_t vSize, float fov)
 
 Ray Camera::RayForPixel(uint32_t x, uint32_t y) const
 {
-    float const xOffset = (x + .5f) * m_pixelSize;
-    float const yOffset = (y + .5f) * m_pixelSize;
+    return RayForPixel(x, y, .5f, .5f);
+}
+
+Ray Camera::RayForPixel(uint32_t x, uint32_t y, float dx, float dy) const
+{
+    float const xOffset = (x + dx) * m_pixelSize;
+    float const yOffset = (y + dy) * m_pixelSize;
     float const worldX = m_halfWidth - xOffset;
     float const worldY = m_halfHeight - yOffset;
     auto const pixel = m_invTransform * Point(worldX, worldY, -1.f);
@@ -48,29 +297,147 @@ Ray Camera::RayForPixel(uint32_t x, uint32_t y) const
     return Ray(origin, direction);
 }
 
-Canvas Camera::Render(World const& world) const
+Frustum Camera::TileFrustum(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) const
 {
-    Canvas c(m_hSize, m_vSize);
+    // Corners of the tile on the image plane, at the outer edges of its pixels
+    auto const corner = [this](uint32_t x, uint32_t y) {
+        return m_invTransform * Point(m_halfWidth - (x * m_pixelSize), m_halfHeight - (y * m_pixelSize), -1.f);
+    };
+    auto const origin = m_invTransform * Point(0.f, 0.f, 0.f);
+    return Frustum(origin, { corner(x0, y0), corner(x1, y0), corner(x1, y1), corner(x0, y1) });
+}
 
-    std::vector<std::thread> threadPool;
-    uint32_t const rowsPerThread = m_vSize / kRenderTasks;
+uint32_t Camera::TileCount(uint32_t tileSize) const
+{
+    return ((m_hSize + tileSize - 1u) / tileSize) * ((m_vSize + tileSize - 1u) / tileSize);
+}
+
+void Camera::TileBounds(uint32_t tile, uint32_t tileSize, uint32_t& x0, uint32_t& y0, uint32_t& x1, uint32_t& y1) const
+{
+    uint32_t const tilesX = (m_hSize + tileSize - 1u) / tileSize;
+    x0 = (tile % tilesX) * tileSize;
+    y0 = (tile / tilesX) * tileSize;
+    x1 = std::min(x0 + tileSize, m_hSize);
+    y1 = std::min(y0 + tileSize, m_vSize);
+}
+
+Canvas Camera::Render(World const& world, RenderSettings const& settings, RenderStats* stats) const
+{
+    RenderTarget target(m_hSize, m_vSize);
+    Render(world, settings, target, nullptr, stats);
+    return target.TakeCanvas();
+}
+
+bool Camera::Render(World const& world, RenderSettings const& settings, RenderTarget& target, ProgressCallback const& onProgress, RenderStats* stats) const
+{
+    settings.Validate();
+    if ((target.Width() != m_hSize) || (target.Height() != m_vSize))
+    {
+        throw std::runtime_error("Render targets must have the size of the image!");
+    }
+    auto const start = Clock::now();
+    auto const deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(settings.m_timeBudget));
+    std::atomic<bool> stopped = false;
+    auto const mustStop = [&]() {
+        return ((settings.m_cancellation != nullptr) && settings.m_cancellation->IsCancelled())
+            || ((settings.m_timeBudget > 0.) && (Clock::now() >= deadline));
+    };
 
-    // Divide work between kRenderTasks - 1 threads
-    for (uint32_t y = 0; y < (kRenderTasks - 1); y++)
+    // Another accelerator is used through a copy of the world, which shares
+    // its bvh and builds that accelerator from it if the world has not
+    std::optional<World> copy;
+    if (settings.m_accelerator.has_value() && (*settings.m_accelerator != world.GetAcceleratorType()))
     {
-        uint32_t const begin = y * rowsPerThread;
-        uint32_t const end = begin + rowsPerThread;
-        threadPool.push_back(std::thread(RenderRow, std::ref(*this), std::ref(world), std::ref(c), begin, end, m_hSize));
+        copy.emplace(world);
+        copy->SetAcceleratorType(*settings.m_accelerator);
     }
+    World const& scene = copy.has_value() ? *copy : world;
 
-    // Last task is run on main thread
-    uint32_t const begin = (kRenderTasks - 1) * rowsPerThread;
-    RenderRow(*this, world, c, begin, m_vSize, m_hSize);
+    bool const occluderCacheStats = (stats != nullptr) && settings.m_occluderCacheStats;
+    World::OccluderCacheStats const before = occluderCacheStats ? scene.GetOccluderCacheStats() : World::OccluderCacheStats();
 
-    for (auto& t : threadPool)
+    auto& pool = ThreadPool::Shared(settings.m_threads);
+    uint32_t const tileCount = TileCount(settings.m_tileSize);
+    uint32_t const firstTile = settings.m_tiles.has_value() ? std::min(settings.m_tiles->first, tileCount) : 0u;
+    uint32_t const lastTile = settings.m_tiles.has_value() ? std::min(settings.m_tiles->second, tileCount) : tileCount;
+
+    bool const workerStats = (stats != nullptr) && settings.m_workerStats;
+    std::vector<WorkerStats> passStats;
+    if (workerStats)
     {
-        t.join();
+        stats->m_workers.assign(pool.WorkerCount(), WorkerStats());
+    }
+
+    std::atomic<uint64_t> samples = 0u;
+    std::mutex progressMutex;
+    RenderProgress progress;
+    progress.m_passCount = settings.m_passes;
+    progress.m_tileCount = lastTile - firstTile;
+    for (uint32_t pass = 0u; pass < settings.m_passes; pass++)
+    {
+        progress.m_pass = pass;
+        progress.m_tilesDone = 0u;
+        uint32_t const stride = 1u << (settings.m_passes - 1u - pass);
+        pool.ParallelFor(lastTile - firstTile, [&](uint32_t tile, uint32_t /*worker*/) {
+            if (mustStop())
+            {
+                stopped = true;
+                pool.Cancel();
+                return;
+            }
+
+            TilePass tilePass;
+            TileBounds(firstTile + tile, settings.m_tileSize, tilePass.m_x0, tilePass.m_y0, tilePass.m_x1, tilePass.m_y1);
+            tilePass.m_stride = stride;
+            tilePass.m_skipCoarser = pass > 0u;
+
+            auto& s = t_scratch;
+            TileCandidates const* candidates = nullptr;
+            if (settings.m_frustumCulling)
+            {
+                scene.CollectCandidates(TileFrustum(tilePass.m_x0, tilePass.m_y0, tilePass.m_x1, tilePass.m_y1), s.m_candidates);
+                candidates = &s.m_candidates;
+            }
+            samples.fetch_add(RenderTile(*this, scene, settings, tilePass, candidates, s), std::memory_order_relaxed);
+            target.Write(s.m_blocks, stride);
+            s.m_candidates.Clear(); // not to keep the shapes alive after the render
+            if (occluderCacheStats)
+            {
+                scene.FlushOccluderCacheStats();
+            }
+
+            if (onProgress)
+            {
+                std::lock_guard<std::mutex> lock(progressMutex);
+                progress.m_tilesDone++;
+                progress.m_x0 = tilePass.m_x0;
+                progress.m_y0 = tilePass.m_y0;
+                progress.m_x1 = tilePass.m_x1;
+                progress.m_y1 = tilePass.m_y1;
+                onProgress(progress, target);
+            }
+        }, workerStats ? &passStats : nullptr);
+
+        if (workerStats)
+        {
+            Accumulate(stats->m_workers, passStats);
+        }
+        if (stopped)
+        {
+            break;
+        }
     }
 
-    return c;
+    if (stats != nullptr)
+    {
+        if (occluderCacheStats)
+        {
+            auto const after = scene.GetOccluderCacheStats();
+            stats->m_occluderCache.m_queries = after.m_queries - before.m_queries;
+            stats->m_occluderCache.m_hits = after.m_hits - before.m_hits;
+        }
+        stats->m_samples = samples;
+        stats->m_seconds = std::chrono::duration_cast<std::chrono::duration<double>>(Clock::now() - start).count();
+    }
+    return !stopped;
 }
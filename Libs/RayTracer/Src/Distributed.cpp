@@ -0,0 +1,850 @@
+#include "Distributed.h"
+
+#include "World.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr uint32_t kMaxPayload = 1u << 30u;
+    constexpr size_t kHeaderSize = 8u; // type and payload size
+    constexpr int kPollMilliseconds = 50; // how often renders check whether they must stop
+
+    // Payloads are little endian whatever the host
+    class PayloadWriter
+    {
+    public:
+        explicit PayloadWriter(std::vector<uint8_t>& bytes) : m_bytes(bytes) {}
+
+        void Put(uint32_t value)
+        {
+            for (uint32_t i = 0u; i < 4u; i++)
+            {
+                m_bytes.push_back(static_cast<uint8_t>(value >> (8u * i)));
+            }
+        }
+
+        void Put(float value)
+        {
+            uint32_t bits = 0u;
+            std::memcpy(&bits, &value, sizeof(bits));
+            Put(bits);
+        }
+
+        void Put(std::string const& value)
+        {
+            Put(static_cast<uint32_t>(value.size()));
+            m_bytes.insert(m_bytes.end(), value.begin(), value.end());
+        }
+
+    private:
+        std::vector<uint8_t>& m_bytes;
+    };
+
+    // Throws if the payload is shorter than what is read
+    class PayloadReader
+    {
+    public:
+        explicit PayloadReader(std::vector<uint8_t> const& bytes) : m_bytes(bytes) {}
+
+        uint32_t GetUInt()
+        {
+            Require(4u);
+            uint32_t value = 0u;
+            for (uint32_t i = 0u; i < 4u; i++)
+            {
+                value |= uint32_t(m_bytes[m_offset++]) << (8u * i);
+            }
+            return value;
+        }
+
+        float GetFloat()
+        {
+            uint32_t const bits = GetUInt();
+            float value = 0.f;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        std::string GetString()
+        {
+            uint32_t const size = GetUInt();
+            Require(size);
+            std::string value(m_bytes.begin() + m_offset, m_bytes.begin() + m_offset + size);
+            m_offset += size;
+            return value;
+        }
+
+    private:
+        void Require(size_t size) const
+        {
+            if (m_bytes.size() - m_offset < size)
+            {
+                throw std::runtime_error("Render messages can't be truncated!");
+            }
+        }
+
+        std::vector<uint8_t> const& m_bytes;
+        size_t m_offset = 0u;
+    };
+
+    // Settings which change the image, the number of threads is up to every
+    // worker
+    RenderMessage JobMessage(std::string const& scene, Camera const& camera, RenderSettings const& settings)
+    {
+        RenderMessage message;
+        message.m_type = RenderMessage::Type::Job;
+        PayloadWriter writer(message.m_payload);
+        writer.Put(scene);
+        writer.Put(camera.HorizontalSize());
+        writer.Put(camera.VerticalSize());
+        writer.Put(camera.FieldOfView());
+        auto const transform = camera.Transform().ToMat44();
+        for (uint8_t row = 0u; row < 4u; row++)
+        {
+            for (uint8_t col = 0u; col < 4u; col++)
+            {
+                writer.Put(transform.At(row, col));
+            }
+        }
+        writer.Put(settings.m_tileSize);
+        writer.Put(uint32_t(settings.m_maxDepth));
+        writer.Put(settings.m_samplesPerPixel);
+        writer.Put(settings.m_maxSamplesPerPixel);
+        writer.Put(settings.m_adaptiveThreshold);
+        writer.Put(settings.m_packetSize);
+        writer.Put(settings.m_frustumCulling ? 1u : 0u);
+        writer.Put(settings.m_accelerator.has_value() ? static_cast<uint32_t>(*settings.m_accelerator) + 1u : 0u);
+        return message;
+    }
+
+    void ReadJob(RenderMessage const& message, std::string& scene, std::optional<Camera>& camera, RenderSettings& settings)
+    {
+        PayloadReader reader(message.m_payload);
+        scene = reader.GetString();
+        uint32_t const width = reader.GetUInt();
+        uint32_t const height = reader.GetUInt();
+        float const fov = reader.GetFloat();
+        Mat44 transform;
+        for (uint8_t row = 0u; row < 4u; row++)
+        {
+            for (uint8_t col = 0u; col < 4u; col++)
+            {
+                transform.At(row, col) = reader.GetFloat();
+            }
+        }
+        camera.emplace(width, height, fov);
+        camera->SetTransform(transform);
+
+        settings.m_tileSize = reader.GetUInt();
+        settings.m_maxDepth = static_cast<uint8_t>(reader.GetUInt());
+        settings.m_samplesPerPixel = reader.GetUInt();
+        settings.m_maxSamplesPerPixel = reader.GetUInt();
+        settings.m_adaptiveThreshold = reader.GetFloat();
+        settings.m_packetSize = reader.GetUInt();
+        settings.m_frustumCulling = reader.GetUInt() != 0u;
+        uint32_t const accelerator = reader.GetUInt();
+        settings.m_accelerator.reset();
+        if (accelerator != 0u)
+        {
+            settings.m_accelerator = static_cast<World::AcceleratorType>(accelerator - 1u);
+        }
+    }
+
+    RenderMessage TilesMessage(std::pair<uint32_t, uint32_t> const& tiles)
+    {
+        RenderMessage message;
+        message.m_type = RenderMessage::Type::Tiles;
+        PayloadWriter writer(message.m_payload);
+        writer.Put(tiles.first);
+        writer.Put(tiles.second);
+        return message;
+    }
+
+    RenderMessage PixelsMessage(std::pair<uint32_t, uint32_t> const& tiles, std::vector<PixelBlock> const& blocks)
+    {
+        RenderMessage message;
+        message.m_type = RenderMessage::Type::Pixels;
+        message.m_payload.reserve(12u + (blocks.size() * 32u));
+        PayloadWriter writer(message.m_payload);
+        writer.Put(tiles.first);
+        writer.Put(tiles.second);
+        writer.Put(static_cast<uint32_t>(blocks.size()));
+        for (auto const& block : blocks)
+        {
+            writer.Put(block.m_x0);
+            writer.Put(block.m_y0);
+            writer.Put(block.m_x1);
+            writer.Put(block.m_y1);
+            writer.Put(block.m_color.R());
+            writer.Put(block.m_color.G());
+            writer.Put(block.m_color.B());
+            writer.Put(block.m_samples);
+        }
+        return message;
+    }
+
+    // Throws if the pixels aren't those of the given tiles
+    std::vector<PixelBlock> ReadPixels(RenderMessage const& message, std::pair<uint32_t, uint32_t> const& tiles)
+    {
+        PayloadReader reader(message.m_payload);
+        uint32_t const first = reader.GetUInt();
+        uint32_t const last = reader.GetUInt();
+        if ((first != tiles.first) || (last != tiles.second))
+        {
+            throw std::runtime_error("Render workers must send the tiles they were given!");
+        }
+
+        uint32_t const count = reader.GetUInt();
+        std::vector<PixelBlock> blocks;
+        blocks.reserve(std::min<size_t>(count, message.m_payload.size() / 32u));
+        for (uint32_t i = 0u; i < count; i++)
+        {
+            uint32_t const x0 = reader.GetUInt();
+            uint32_t const y0 = reader.GetUInt();
+            uint32_t const x1 = reader.GetUInt();
+            uint32_t const y1 = reader.GetUInt();
+            float const r = reader.GetFloat();
+            float const g = reader.GetFloat();
+            float const b = reader.GetFloat();
+            blocks.push_back({ x0, y0, x1, y1, Color(r, g, b), reader.GetUInt() });
+        }
+        return blocks;
+    }
+
+#if !defined(_WIN32)
+    struct SocketAddress
+    {
+        bool m_unix = false;
+        std::string m_path;
+        std::string m_host;
+        std::string m_port;
+    };
+
+    SocketAddress ParseAddress(std::string const& address)
+    {
+        SocketAddress parsed;
+        if (address.rfind("unix:", 0u) == 0u)
+        {
+            parsed.m_unix = true;
+            parsed.m_path = address.substr(5u);
+            if (parsed.m_path.empty() || (parsed.m_path.size() >= sizeof(sockaddr_un::sun_path)))
+            {
+                throw std::runtime_error("Unix socket paths must hold 1 to 107 characters!");
+            }
+            return parsed;
+        }
+
+        auto const colon = address.rfind(':');
+        if ((address.rfind("tcp:", 0u) != 0u) || (colon <= 4u) || (colon + 1u == address.size()))
+        {
+            throw std::runtime_error("Addresses are unix:<path> or tcp:<host>:<port>!");
+        }
+        parsed.m_host = address.substr(4u, colon - 4u);
+        parsed.m_port = address.substr(colon + 1u);
+        return parsed;
+    }
+
+    sockaddr_un UnixAddress(std::string const& path)
+    {
+        sockaddr_un unixAddress = {};
+        unixAddress.sun_family = AF_UNIX;
+        std::memcpy(unixAddress.sun_path, path.c_str(), path.size() + 1u);
+        return unixAddress;
+    }
+
+    // Calls f with every address host:port resolves to until it returns a
+    // socket, -1 if none does
+    template <typename F>
+    int ForEachTcpAddress(SocketAddress const& address, bool passive, F const& f)
+    {
+        addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = passive ? AI_PASSIVE : 0;
+        addrinfo* infos = nullptr;
+        if (getaddrinfo(address.m_host.c_str(), address.m_port.c_str(), &hints, &infos) != 0)
+        {
+            return -1;
+        }
+
+        int s = -1;
+        for (addrinfo* info = infos; (info != nullptr) && (s < 0); info = info->ai_next)
+        {
+            s = f(*info);
+        }
+        freeaddrinfo(infos);
+        return s;
+    }
+
+    // Small messages such as tile ranges go out at once
+    void DisableNagle(int s)
+    {
+        int const on = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+
+    int ConnectSocket(std::string const& address)
+    {
+        auto const parsed = ParseAddress(address);
+        if (parsed.m_unix)
+        {
+            int const s = socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un const unixAddress = UnixAddress(parsed.m_path);
+            if ((s >= 0) && (connect(s, reinterpret_cast<sockaddr const*>(&unixAddress), sizeof(unixAddress)) != 0))
+            {
+                close(s);
+                return -1;
+            }
+            return s;
+        }
+
+        return ForEachTcpAddress(parsed, false, [](addrinfo const& info) {
+            int const s = socket(info.ai_family, info.ai_socktype, info.ai_protocol);
+            if ((s >= 0) && (connect(s, info.ai_addr, info.ai_addrlen) != 0))
+            {
+                close(s);
+                return -1;
+            }
+            if (s >= 0)
+            {
+                DisableNagle(s);
+            }
+            return s;
+        });
+    }
+
+    // Writes the address actually bound to, with the port picked for port 0
+    int ListenSocket(std::string const& address, std::string& bound, std::string& socketPath)
+    {
+        auto const parsed = ParseAddress(address);
+        if (parsed.m_unix)
+        {
+            // Left behind by a coordinator which didn't exit cleanly
+            unlink(parsed.m_path.c_str());
+            int const s = socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un const unixAddress = UnixAddress(parsed.m_path);
+            if ((s >= 0) && ((bind(s, reinterpret_cast<sockaddr const*>(&unixAddress), sizeof(unixAddress)) != 0) || (listen(s, SOMAXCONN) != 0)))
+            {
+                close(s);
+                return -1;
+            }
+            bound = address;
+            socketPath = parsed.m_path;
+            return s;
+        }
+
+        int const s = ForEachTcpAddress(parsed, true, [](addrinfo const& info) {
+            int const s = socket(info.ai_family, info.ai_socktype, info.ai_protocol);
+            int const on = 1;
+            if ((s >= 0) && ((setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0)
+                || (bind(s, info.ai_addr, info.ai_addrlen) != 0) || (listen(s, SOMAXCONN) != 0)))
+            {
+                close(s);
+                return -1;
+            }
+            return s;
+        });
+        if (s < 0)
+        {
+            return -1;
+        }
+
+        sockaddr_storage local = {};
+        socklen_t size = sizeof(local);
+        getsockname(s, reinterpret_cast<sockaddr*>(&local), &size);
+        uint16_t const port = (local.ss_family == AF_INET6)
+            ? ntohs(reinterpret_cast<sockaddr_in6 const&>(local).sin6_port)
+            : ntohs(reinterpret_cast<sockaddr_in const&>(local).sin_port);
+        bound = "tcp:" + parsed.m_host + ":" + std::to_string(port);
+        return s;
+    }
+
+    int AcceptSocket(int listener)
+    {
+        int const s = accept(listener, nullptr, nullptr);
+        if (s >= 0)
+        {
+            DisableNagle(s);
+        }
+        return s;
+    }
+
+    void CloseSocket(int s)
+    {
+        close(s);
+    }
+
+    void RemoveSocketPath(std::string const& path)
+    {
+        unlink(path.c_str());
+    }
+
+    bool SendAll(int s, uint8_t const* bytes, size_t size)
+    {
+#if defined(MSG_NOSIGNAL)
+        int const flags = MSG_NOSIGNAL; // a worker gone must not kill the coordinator with SIGPIPE
+#else
+        int const flags = 0;
+#endif
+        while (size > 0u)
+        {
+            ssize_t const sent = send(s, bytes, size, flags);
+            if ((sent < 0) && (errno == EINTR))
+            {
+                continue;
+            }
+            if (sent <= 0)
+            {
+                return false;
+            }
+            bytes += sent;
+            size -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    // Reads up to size bytes of those which already arrived, without
+    // waiting. Returns how many, -1 once the peer is gone.
+    long ReceiveSome(int s, uint8_t* bytes, size_t size)
+    {
+        while (true)
+        {
+            ssize_t const received = recv(s, bytes, size, MSG_DONTWAIT);
+            if ((received < 0) && (errno == EINTR))
+            {
+                continue;
+            }
+            if ((received < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+            {
+                return 0;
+            }
+            return (received > 0) ? static_cast<long>(received) : -1;
+        }
+    }
+
+    // Waits up to the given time for any of the sockets to be readable or
+    // closed by its peer
+    std::vector<bool> WaitReadable(std::vector<int> const& sockets, int milliseconds)
+    {
+        std::vector<pollfd> polled(sockets.size());
+        for (size_t i = 0u; i < sockets.size(); i++)
+        {
+            polled[i].fd = sockets[i];
+            polled[i].events = POLLIN;
+        }
+        std::vector<bool> readable(sockets.size(), false);
+        if (poll(polled.data(), polled.size(), milliseconds) > 0)
+        {
+            for (size_t i = 0u; i < sockets.size(); i++)
+            {
+                readable[i] = (polled[i].revents & (POLLIN | POLLHUP | POLLERR)) != 0;
+            }
+        }
+        return readable;
+    }
+#else
+    [[noreturn]] void Unsupported()
+    {
+        throw std::runtime_error("Distributed renders need POSIX sockets!");
+    }
+
+    int ConnectSocket(std::string const&) { Unsupported(); }
+    int ListenSocket(std::string const&, std::string&, std::string&) { Unsupported(); }
+    int AcceptSocket(int) { Unsupported(); }
+    void CloseSocket(int) {}
+    void RemoveSocketPath(std::string const&) {}
+    bool SendAll(int, uint8_t const*, size_t) { Unsupported(); }
+    long ReceiveSome(int, uint8_t*, size_t) { Unsupported(); }
+    std::vector<bool> WaitReadable(std::vector<int> const&, int) { Unsupported(); }
+#endif
+}
+
+// static
+std::unique_ptr<RenderConnection> RenderConnection::Connect(std::string const& address)
+{
+    int const s = ConnectSocket(address);
+    if (s < 0)
+    {
+        throw std::runtime_error("Nothing listens at " + address + "!");
+    }
+    return std::make_unique<RenderConnection>(s);
+}
+
+RenderConnection::RenderConnection(int socket)
+    : m_socket(socket)
+{
+}
+
+RenderConnection::~RenderConnection()
+{
+    CloseSocket(m_socket);
+}
+
+bool RenderConnection::Send(RenderMessage const& message)
+{
+    std::vector<uint8_t> header;
+    PayloadWriter writer(header);
+    writer.Put(static_cast<uint32_t>(message.m_type));
+    writer.Put(static_cast<uint32_t>(message.m_payload.size()));
+    return SendAll(m_socket, header.data(), header.size())
+        && SendAll(m_socket, message.m_payload.data(), message.m_payload.size());
+}
+
+bool RenderConnection::Receive(RenderMessage& message)
+{
+    bool complete = false;
+    while (TryReceive(message, complete))
+    {
+        if (complete)
+        {
+            return true;
+        }
+        WaitReadable({ m_socket }, -1);
+    }
+    return false;
+}
+
+bool RenderConnection::TryReceive(RenderMessage& message, bool& complete)
+{
+    complete = false;
+    // Never reads past the end of the message, the next one stays queued
+    size_t needed = kHeaderSize;
+    while (true)
+    {
+        if (m_received.size() >= kHeaderSize)
+        {
+            PayloadReader reader(m_received);
+            uint32_t const type = reader.GetUInt();
+            uint32_t const size = reader.GetUInt();
+            if ((type > static_cast<uint32_t>(RenderMessage::Type::Quit)) || (size > kMaxPayload))
+            {
+                return false;
+            }
+            needed = kHeaderSize + size;
+            if (m_received.size() == needed)
+            {
+                message.m_type = static_cast<RenderMessage::Type>(type);
+                message.m_payload.assign(m_received.begin() + kHeaderSize, m_received.end());
+                m_received.clear();
+                complete = true;
+                return true;
+            }
+        }
+
+        size_t const offset = m_received.size();
+        m_received.resize(needed);
+        long const received = ReceiveSome(m_socket, m_received.data() + offset, needed - offset);
+        m_received.resize(offset + static_cast<size_t>(std::max(received, 0L)));
+        if (received <= 0)
+        {
+            return received == 0;
+        }
+    }
+}
+
+RenderCoordinator::RenderCoordinator(std::string const& address, uint32_t tilesPerAssignment, double replyTimeout)
+    : m_listener(-1)
+    , m_tilesPerAssignment(std::max(tilesPerAssignment, 1u))
+    , m_replyTimeout(std::max(replyTimeout, 0.))
+{
+    m_listener = ListenSocket(address, m_address, m_socketPath);
+    if (m_listener < 0)
+    {
+        throw std::runtime_error("Can't listen at " + address + "!");
+    }
+}
+
+RenderCoordinator::~RenderCoordinator()
+{
+    RenderMessage quit;
+    quit.m_type = RenderMessage::Type::Quit;
+    for (auto& worker : m_workers)
+    {
+        worker.m_connection->Send(quit);
+    }
+    m_workers.clear();
+    CloseSocket(m_listener);
+    if (!m_socketPath.empty())
+    {
+        RemoveSocketPath(m_socketPath);
+    }
+}
+
+bool RenderCoordinator::Accept()
+{
+    int const s = AcceptSocket(m_listener);
+    if (s < 0)
+    {
+        return false;
+    }
+    Worker worker;
+    worker.m_connection = std::make_unique<RenderConnection>(s);
+    m_workers.push_back(std::move(worker));
+    return true;
+}
+
+uint32_t RenderCoordinator::WaitForWorkers(uint32_t count, double timeout)
+{
+    auto const deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(timeout));
+    while (m_workers.size() < count)
+    {
+        auto const left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        if (left <= 0)
+        {
+            break;
+        }
+        if (WaitReadable({ m_listener }, static_cast<int>(std::min<long long>(left, kPollMilliseconds)))[0])
+        {
+            Accept();
+        }
+    }
+    return WorkerCount();
+}
+
+Canvas RenderCoordinator::Render(std::string const& scene, Camera const& camera, RenderSettings const& settings)
+{
+    RenderTarget target(camera.HorizontalSize(), camera.VerticalSize());
+    Render(scene, camera, settings, target);
+    return target.TakeCanvas();
+}
+
+bool RenderCoordinator::Render(std::string const& scene, Camera const& camera, RenderSettings const& settings, RenderTarget& target)
+{
+    settings.Validate();
+    if (settings.m_sampler != nullptr)
+    {
+        throw std::runtime_error("Distributed renders can't send samplers to their workers!");
+    }
+    if ((target.Width() != camera.HorizontalSize()) || (target.Height() != camera.VerticalSize()))
+    {
+        throw std::runtime_error("Render targets must have the size of the image!");
+    }
+    // Only parsed, workers load the scene. Those which can't are dropped.
+    auto const data = json::parse(scene, nullptr, false);
+    if ((data == json::value_t::discarded) || (data.type() != json::value_t::object))
+    {
+        throw std::runtime_error("Distributed renders need a scene in JSON!");
+    }
+    if (m_workers.empty())
+    {
+        throw std::runtime_error("Distributed renders need at least one worker!");
+    }
+
+    auto const deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(settings.m_timeBudget));
+    auto const mustStop = [&]() {
+        return ((settings.m_cancellation != nullptr) && settings.m_cancellation->IsCancelled())
+            || ((settings.m_timeBudget > 0.) && (Clock::now() >= deadline));
+    };
+
+    // Workers which fail to receive the job are dropped, like those which
+    // disconnect later on
+    RenderMessage const job = JobMessage(scene, camera, settings);
+    auto const start = [&job](Worker& worker) {
+        worker.m_busy = false;
+        return worker.m_connection->Send(job);
+    };
+    m_workers.erase(std::remove_if(m_workers.begin(), m_workers.end(), [&](Worker& worker) { return !start(worker); }), m_workers.end());
+
+    uint32_t const tileCount = camera.TileCount(settings.m_tileSize);
+    uint32_t const firstTile = settings.m_tiles.has_value() ? std::min(settings.m_tiles->first, tileCount) : 0u;
+    uint32_t const lastTile = settings.m_tiles.has_value() ? std::min(settings.m_tiles->second, tileCount) : tileCount;
+    std::deque<std::pair<uint32_t, uint32_t>> pending;
+    for (uint32_t first = firstTile; first < lastTile; first += m_tilesPerAssignment)
+    {
+        pending.emplace_back(first, std::min(first + m_tilesPerAssignment, lastTile));
+    }
+
+    auto const replyTimeout = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_replyTimeout));
+
+    // Tiles of a worker gone are handed out again first
+    auto const drop = [&](size_t index) {
+        if (m_workers[index].m_busy)
+        {
+            pending.push_front(m_workers[index].m_tiles);
+        }
+        m_workers.erase(m_workers.begin() + index);
+    };
+
+    bool stopped = false;
+    while (true)
+    {
+        if (!stopped && mustStop())
+        {
+            stopped = true;
+        }
+        if (stopped)
+        {
+            pending.clear();
+        }
+
+        for (size_t i = m_workers.size(); i-- > 0u;)
+        {
+            auto& worker = m_workers[i];
+            if (!worker.m_busy && !pending.empty())
+            {
+                worker.m_tiles = pending.front();
+                pending.pop_front();
+                worker.m_busy = true;
+                worker.m_deadline = Clock::now() + replyTimeout;
+                if (!worker.m_connection->Send(TilesMessage(worker.m_tiles)))
+                {
+                    drop(i);
+                }
+            }
+        }
+
+        bool const busy = std::any_of(m_workers.begin(), m_workers.end(), [](Worker const& worker) { return worker.m_busy; });
+        if (!busy && pending.empty())
+        {
+            break;
+        }
+        if (m_workers.empty())
+        {
+            throw std::runtime_error("Every render worker is gone!");
+        }
+
+        std::vector<int> sockets = { m_listener };
+        for (auto const& worker : m_workers)
+        {
+            sockets.push_back(worker.m_connection->Socket());
+        }
+        auto const readable = WaitReadable(sockets, kPollMilliseconds);
+
+        for (size_t i = m_workers.size(); i-- > 0u;)
+        {
+            if (!readable[i + 1u])
+            {
+                continue;
+            }
+
+            auto& worker = m_workers[i];
+            RenderMessage reply;
+            bool complete = false;
+            if (!worker.m_busy || !worker.m_connection->TryReceive(reply, complete)
+                || (complete && (reply.m_type != RenderMessage::Type::Pixels)))
+            {
+                drop(i);
+                continue;
+            }
+            if (!complete)
+            {
+                continue;
+            }
+            try
+            {
+                target.Write(ReadPixels(reply, worker.m_tiles));
+                worker.m_busy = false;
+            }
+            catch (std::runtime_error const&)
+            {
+                drop(i);
+            }
+        }
+
+        // Workers connected but not replying, maybe stuck mid message
+        auto const now = Clock::now();
+        for (size_t i = m_workers.size(); i-- > 0u;)
+        {
+            if (m_workers[i].m_busy && (m_replyTimeout > 0.) && (now >= m_workers[i].m_deadline))
+            {
+                drop(i);
+            }
+        }
+
+        // Workers joining meanwhile get the job right away
+        if (readable[0] && Accept())
+        {
+            if (!start(m_workers.back()))
+            {
+                m_workers.pop_back();
+            }
+        }
+    }
+    return !stopped;
+}
+
+bool RunRenderWorker(std::string const& address, uint32_t threads)
+{
+    auto const connection = RenderConnection::Connect(address);
+    std::optional<World> world;
+    std::optional<Camera> camera;
+    std::unique_ptr<RenderTarget> target;
+    RenderSettings settings;
+    settings.m_threads = threads;
+
+    RenderMessage message;
+    while (connection->Receive(message))
+    {
+        switch (message.m_type)
+        {
+        case RenderMessage::Type::Job:
+        {
+            std::string scene;
+            ReadJob(message, scene, camera, settings);
+            world.emplace();
+            std::istringstream is(scene);
+            if (!world->Load(is))
+            {
+                throw std::runtime_error("Render workers must be able to load their scene!");
+            }
+            target = std::make_unique<RenderTarget>(camera->HorizontalSize(), camera->VerticalSize());
+            break;
+        }
+        case RenderMessage::Type::Tiles:
+        {
+            if (target == nullptr)
+            {
+                throw std::runtime_error("Render workers must get a job before its tiles!");
+            }
+            PayloadReader reader(message.m_payload);
+            uint32_t const first = reader.GetUInt();
+            uint32_t const last = reader.GetUInt();
+            settings.m_tiles = std::make_pair(first, last);
+            camera->Render(*world, settings, *target);
+
+            std::vector<PixelBlock> blocks;
+            for (uint32_t tile = first; tile < std::min(last, camera->TileCount(settings.m_tileSize)); tile++)
+            {
+                uint32_t x0 = 0u;
+                uint32_t y0 = 0u;
+                uint32_t x1 = 0u;
+                uint32_t y1 = 0u;
+                camera->TileBounds(tile, settings.m_tileSize, x0, y0, x1, y1);
+                auto const tileBlocks = target->Read(x0, y0, x1, y1);
+                blocks.insert(blocks.end(), tileBlocks.begin(), tileBlocks.end());
+            }
+            if (!connection->Send(PixelsMessage(settings.m_tiles.value(), blocks)))
+            {
+                return false;
+            }
+            break;
+        }
+        case RenderMessage::Type::Quit:
+            return true;
+        default:
+            throw std::runtime_error("Render workers only handle jobs, tiles and quit messages!");
+        }
+    }
+    return false;
+}
@@ -0,0 +1,75 @@
+#include "Frustum.h"
+
+#include <algorithm>
+
+Frustum::Frustum(Tuple const& origin, std::array<Tuple, 4> const& corners)
+    : m_origin(origin)
+    , m_normals()
+    , m_offsets()
+{
+    Tuple forward = Vector(0.f, 0.f, 0.f);
+    for (auto const& corner : corners)
+    {
+        forward = forward + (corner - origin);
+    }
+
+    for (size_t i = 0; i < corners.size(); i++)
+    {
+        auto normal = (corners[i] - origin).Cross(corners[(i + 1) % corners.size()] - origin);
+        if (normal.Dot(forward) < 0.f)
+        {
+            normal = -normal;
+        }
+        m_normals[i] = normal;
+    }
+    m_normals[kPlaneCount - 1] = forward;
+
+    for (size_t i = 0; i < kPlaneCount; i++)
+    {
+        m_offsets[i] = -m_normals[i].Dot(origin);
+    }
+}
+
+Frustum::Overlap Frustum::Classify(float const* min, float const* max) const
+{
+    // A box is outside once its corner farthest along the normal of a plane
+    // is behind it, and inside when its nearest corner is in front of all
+    bool inside = true;
+    for (size_t i = 0; i < kPlaneCount; i++)
+    {
+        auto const& n = m_normals[i];
+        float farthest = m_offsets[i];
+        float nearest = m_offsets[i];
+        for (uint32_t axis = 0u; axis < 3u; axis++)
+        {
+            farthest += n[axis] * ((n[axis] >= 0.f) ? max[axis] : min[axis]);
+            nearest += n[axis] * ((n[axis] >= 0.f) ? min[axis] : max[axis]);
+        }
+        if (farthest < 0.f)
+        {
+            return Overlap::Outside;
+        }
+        inside &= (nearest >= 0.f);
+    }
+    return inside ? Overlap::Inside : Overlap::Partial;
+}
+
+Frustum::Overlap Frustum::Classify(Bounds const& bounds) const
+{
+    auto const min = bounds.Min();
+    auto const max = bounds.Max();
+    float const minCoords[3] = { min.X(), min.Y(), min.Z() };
+    float const maxCoords[3] = { max.X(), max.Y(), max.Z() };
+    return Classify(minCoords, maxCoords);
+}
+
+float Frustum::SquaredDistance(float const* min, float const* max) const
+{
+    float distance = 0.f;
+    for (uint32_t axis = 0u; axis < 3u; axis++)
+    {
+        float const delta = std::max(std::max(min[axis] - m_origin[axis], 0.f), m_origin[axis] - max[axis]);
+        distance += delta * delta;
+    }
+    return distance;
+}
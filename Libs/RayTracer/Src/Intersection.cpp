@@ -1,13 +1,34 @@
 #include "Intersection.h"
+#include "Shapes/Instance.h"
+#include "Util.h"
 
-Intersection::Intersection(float distance, ShapeConstPtr const& s)
+namespace
+{
+
+Material const& HitMaterial(Shape const* object, Instance const* instance)
+{
+    return ((instance != nullptr) && instance->OverridesMaterial())
+        ? instance->GetMaterial()
+        : object->GetMaterial();
+}
+
+}
+
+Intersection::Intersection()
+    : Intersection(INF, nullptr)
+{}
+
+Intersection::Intersection(float distance, Shape const* s)
     : m_distance(distance)
     , m_shape(s)
+    , m_instance(nullptr)
 {}
 
 bool Intersection::operator==(Intersection const& other) const
 {
-    return m_distance == other.m_distance && m_shape == other.m_shape;
+    return m_distance == other.m_distance
+        && m_shape == other.m_shape
+        && m_instance == other.m_instance;
 }
 
 bool Intersection::operator<(Intersection const& other) const
@@ -15,6 +36,47 @@ bool Intersection::operator<(Intersection const& other) const
     return m_distance < other.m_distance;
 }
 
+Material const& Intersection::GetMaterial() const
+{
+    return HitMaterial(m_shape, m_instance);
+}
+
+Material const& IntersectionData::GetMaterial() const
+{
+    return HitMaterial(m_object, m_instance);
+}
+
+namespace
+{
+
+struct ArenaLists
+{
+    std::vector<std::unique_ptr<std::vector<Intersection>>> m_lists;
+    size_t m_inUse = 0u;
+};
+
+thread_local ArenaLists t_arena;
+
+}
+
+IntersectionArena::Lease::~Lease()
+{
+    m_list.clear();
+    t_arena.m_inUse--;
+}
+
+// static
+IntersectionArena::Lease IntersectionArena::Acquire()
+{
+    auto& arena = t_arena;
+    if (arena.m_inUse == arena.m_lists.size())
+    {
+        arena.m_lists.push_back(std::make_unique<std::vector<Intersection>>());
+        arena.m_lists.back()->reserve(16u);
+    }
+    return Lease(*arena.m_lists[arena.m_inUse++]);
+}
+
 Intersection Hit(std::vector<Intersection> const& xs)
 {
     for (auto const& i : xs)
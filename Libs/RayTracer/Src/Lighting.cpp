@@ -10,7 +10,12 @@ PointLight::PointLight(Tuple position, Color intensity)
 
 Color Lighting(Material const& m, ShapeConstPtr const& shape, PointLight const& light, Tuple const& position, Tuple const& eye, Tuple const& normal, bool inShadow)
 {
-    Color effectiveColor = m.ColorAt(shape, position) * light.Intensity();
+    return Lighting(m, m.ColorAt(shape.get(), position), light, position, eye, normal, inShadow);
+}
+
+Color Lighting(Material const& m, Color const& surfaceColor, PointLight const& light, Tuple const& position, Tuple const& eye, Tuple const& normal, bool inShadow)
+{
+    Color effectiveColor = surfaceColor * light.Intensity();
 
     Tuple const lightDir = (light.Position() - position).Normalized();
     Color const ambient = effectiveColor * m.Ambient();
@@ -0,0 +1,648 @@
+#include "LinearBvh.h"
+
+#include "Frustum.h"
+#include "Ray.h"
+#include "RayPacket.h"
+#include "Shapes/Shape.h"
+#include "TileCandidates.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+
+// Ray data needed by the slab test, computed once per query
+struct TraversalRay
+{
+    explicit TraversalRay(Ray const& ray)
+    {
+        for (size_t axis = 0; axis < 3; axis++)
+        {
+            m_origin[axis] = ray.Origin()[axis];
+            m_invDir[axis] = 1.f / ray.Direction()[axis];
+            m_dirIsNeg[axis] = m_invDir[axis] < 0.f;
+        }
+    }
+
+    float m_origin[3];
+    float m_invDir[3];
+    bool m_dirIsNeg[3];
+};
+
+template<typename NodeT>
+bool SlabTest(NodeT const& node, TraversalRay const& ray, float& tMin, float& tMax)
+{
+    for (size_t axis = 0; axis < 3; axis++)
+    {
+        float t1 = (node.m_min[axis] - ray.m_origin[axis]) * ray.m_invDir[axis];
+        float t2 = (node.m_max[axis] - ray.m_origin[axis]) * ray.m_invDir[axis];
+        if (t1 > t2) std::swap(t1, t2);
+        tMin = std::max(tMin, t1);
+        tMax = std::min(tMax, t2);
+    }
+    return tMin <= tMax;
+}
+
+bool IsSingleLane(uint32_t mask)
+{
+    return (mask & (mask - 1u)) == 0u;
+}
+
+uint32_t FirstLane(uint32_t mask)
+{
+    uint32_t lane = 0u;
+    while ((mask & (1u << lane)) == 0u)
+    {
+        lane++;
+    }
+    return lane;
+}
+
+}
+
+LinearBvh::LinearBvh()
+{
+}
+
+LinearBvh::LinearBvh(Bvh const& bvh)
+{
+    Build(bvh);
+}
+
+void LinearBvh::Build(Bvh const& bvh)
+{
+    m_nodes.clear();
+    m_objects = bvh.m_objects;
+    m_unbounded = bvh.m_unbounded;
+    m_linearIndices.assign(bvh.m_nodes.size(), kCollapsed);
+    m_batches.clear();
+    m_batchLanes.clear();
+
+    if (!bvh.m_nodes.empty())
+    {
+        m_nodes.reserve(bvh.m_nodes.size());
+        Flatten(bvh, 0u);
+    }
+}
+
+void LinearBvh::Refit(Bvh const& bvh, std::vector<ShapePtr> const& shapes)
+{
+    if (bvh.m_nodes.size() != m_linearIndices.size())
+    {
+        throw std::runtime_error("A linear bvh can only be refitted from the bvh it was built from!");
+    }
+
+    for (auto const& shape : shapes)
+    {
+        auto const it = bvh.m_objectLeaves.find(shape.get());
+        for (uint32_t nodeIdx = (it != bvh.m_objectLeaves.end()) ? it->second : Bvh::kNoParent;
+             nodeIdx != Bvh::kNoParent;
+             nodeIdx = bvh.m_nodes[nodeIdx].m_parent)
+        {
+            if (m_linearIndices[nodeIdx] != kCollapsed)
+            {
+                SetNodeBounds(m_linearIndices[nodeIdx], bvh.m_nodes[nodeIdx].m_bounds);
+            }
+        }
+
+        auto const lane = m_batchLanes.find(shape.get());
+        if (lane != m_batchLanes.end())
+        {
+            m_batches[lane->second / PrimitiveBatch::kWidth].Update(lane->second % PrimitiveBatch::kWidth, *shape);
+        }
+    }
+}
+
+void LinearBvh::SetNodeBounds(uint32_t nodeIdx, Bounds const& bounds)
+{
+    auto& node = m_nodes[nodeIdx];
+    for (size_t axis = 0; axis < 3; axis++)
+    {
+        node.m_min[axis] = bounds.Min()[axis];
+        node.m_max[axis] = bounds.Max()[axis];
+    }
+}
+
+uint32_t LinearBvh::Flatten(Bvh const& bvh, uint32_t nodeIdx)
+{
+    auto const& src = bvh.m_nodes[nodeIdx];
+    auto const linearIdx = static_cast<uint32_t>(m_nodes.size());
+    m_linearIndices[nodeIdx] = linearIdx;
+
+    Node node;
+    node.m_offset = 0u;
+    node.m_count = 0u;
+    node.m_axis = 0u;
+    node.m_flags = src.m_castsShadows ? kCastsShadows : uint8_t(0u);
+    m_nodes.push_back(node);
+    SetNodeBounds(linearIdx, src.m_bounds);
+
+    // Small subtrees of spheres and cubes become a single batched leaf
+    uint32_t batchCount = 0u;
+    if (FitsInBatch(bvh, nodeIdx, batchCount) && (batchCount > 1u))
+    {
+        MakeBatch(bvh, nodeIdx, linearIdx, batchCount);
+        return linearIdx;
+    }
+
+    if (src.IsLeaf())
+    {
+        if (src.m_count > std::numeric_limits<uint16_t>::max())
+        {
+            throw std::runtime_error("Too many objects in a single bvh leaf to be flattened!");
+        }
+        m_nodes[linearIdx].m_offset = src.m_first;
+        m_nodes[linearIdx].m_count = static_cast<uint16_t>(src.m_count);
+        return linearIdx;
+    }
+
+    // Children are visited nearest first along the axis that separates them the most
+    auto const delta = bvh.m_nodes[src.m_right].m_bounds.Center() - bvh.m_nodes[src.m_left].m_bounds.Center();
+    auto const absX = std::abs(delta.X());
+    auto const absY = std::abs(delta.Y());
+    auto const absZ = std::abs(delta.Z());
+    m_nodes[linearIdx].m_axis = (absX >= absY && absX >= absZ) ? 0u : ((absY >= absZ) ? 1u : 2u);
+
+    Flatten(bvh, src.m_left);
+    m_nodes[linearIdx].m_offset = Flatten(bvh, src.m_right);
+    return linearIdx;
+}
+
+bool LinearBvh::FitsInBatch(Bvh const& bvh, uint32_t nodeIdx, uint32_t& count) const
+{
+    // Objects are counted left to right, so only a few nodes are visited
+    // before giving up on large subtrees
+    auto const& src = bvh.m_nodes[nodeIdx];
+    if (!src.IsLeaf())
+    {
+        return FitsInBatch(bvh, src.m_left, count) && FitsInBatch(bvh, src.m_right, count);
+    }
+
+    count += src.m_count;
+    if (count > PrimitiveBatch::kWidth)
+    {
+        return false;
+    }
+    for (uint32_t i = src.m_first; i < src.m_first + src.m_count; i++)
+    {
+        if (!PrimitiveBatch::CanBatch(*bvh.m_objects[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void LinearBvh::MakeBatch(Bvh const& bvh, uint32_t nodeIdx, uint32_t linearIdx, uint32_t count)
+{
+    // Leaves are created depth first, so the objects of a subtree are
+    // contiguous and start with those of its leftmost leaf
+    uint32_t first = nodeIdx;
+    while (!bvh.m_nodes[first].IsLeaf())
+    {
+        first = bvh.m_nodes[first].m_left;
+    }
+    first = bvh.m_nodes[first].m_first;
+
+    auto const batchIdx = static_cast<uint32_t>(m_batches.size());
+    PrimitiveBatch batch;
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        m_batchLanes[m_objects[i].get()] = (batchIdx * PrimitiveBatch::kWidth) + batch.m_count;
+        batch.Add(i, *m_objects[i]);
+    }
+    m_batches.push_back(batch);
+
+    auto& node = m_nodes[linearIdx];
+    node.m_offset = batchIdx;
+    node.m_count = static_cast<uint16_t>(count);
+    node.m_flags |= kBatch;
+}
+
+Bounds LinearBvh::GetBounds() const
+{
+    if (m_nodes.empty())
+    {
+        return Bounds::Empty();
+    }
+    auto const& root = m_nodes.front();
+    return Bounds(Point(root.m_min[0], root.m_min[1], root.m_min[2]), Point(root.m_max[0], root.m_max[1], root.m_max[2]));
+}
+
+void LinearBvh::CollectCandidates(Frustum const& frustum, TileCandidates& candidates) const
+{
+    candidates.Clear();
+    for (auto const& obj : m_unbounded)
+    {
+        candidates.Add(obj);
+    }
+
+    if (m_nodes.empty())
+    {
+        return;
+    }
+
+    // Breadth first, so the list is spent on the largest nodes. Nodes still
+    // to classify wrap around the queue, which never holds more than the
+    // final list.
+    std::array<uint32_t, kMaxCandidates> queue;
+    uint32_t queueBegin = 0u;
+    uint32_t queueSize = 0u;
+    std::array<std::pair<float, uint32_t>, kMaxCandidates> kept;
+    uint32_t keptSize = 0u;
+    queue[queueSize++] = 0u;
+    while (queueSize > 0u)
+    {
+        uint32_t const nodeIdx = queue[queueBegin];
+        queueBegin = (queueBegin + 1u) % kMaxCandidates;
+        queueSize--;
+
+        auto const& node = m_nodes[nodeIdx];
+        auto const overlap = frustum.Classify(node.m_min, node.m_max);
+        if (overlap == Frustum::Overlap::Outside)
+        {
+            continue;
+        }
+
+        if ((overlap == Frustum::Overlap::Inside) || node.IsLeaf() || (keptSize + queueSize + 2u > kMaxCandidates))
+        {
+            // Inserted nearest first, so closest hit queries cull most of the
+            // others
+            std::pair<float, uint32_t> const entry = { frustum.SquaredDistance(node.m_min, node.m_max), nodeIdx };
+            uint32_t j = keptSize++;
+            for (; (j > 0u) && (entry < kept[j - 1u]); j--)
+            {
+                kept[j] = kept[j - 1u];
+            }
+            kept[j] = entry;
+            continue;
+        }
+        queue[(queueBegin + queueSize++) % kMaxCandidates] = nodeIdx + 1u;
+        queue[(queueBegin + queueSize++) % kMaxCandidates] = node.m_offset;
+    }
+
+    for (uint32_t i = 0u; i < keptSize; i++)
+    {
+        candidates.Add(*this, kept[i].second);
+    }
+}
+
+void LinearBvh::Intersect(Ray const& ray, std::vector<Intersection>& xs) const
+{
+    for (auto const& obj : m_unbounded)
+    {
+        ray.Intersect(obj, xs);
+    }
+
+    if (!m_nodes.empty())
+    {
+        Intersect(ray, xs, 0u);
+    }
+}
+
+void LinearBvh::Intersect(Ray const& ray, std::vector<Intersection>& xs, uint32_t rootIdx) const
+{
+    TraversalRay const tRay(ray);
+    std::array<uint32_t, Bvh::kMaxDepth> stack;
+    uint32_t stackSize = 0u;
+    uint32_t nodeIdx = rootIdx;
+    while (true)
+    {
+        auto const& node = m_nodes[nodeIdx];
+        float tMin = -INF;
+        float tMax = INF;
+        if (SlabTest(node, tRay, tMin, tMax))
+        {
+            if (node.IsBatch())
+            {
+                auto const& batch = m_batches[node.m_offset];
+                float t1[PrimitiveBatch::kWidth];
+                float t2[PrimitiveBatch::kWidth];
+                ForEachLane(batch.Intersect(ray, t1, t2), [&](uint32_t lane) {
+                    Shape const* obj = m_objects[batch.m_objects[lane]].get();
+                    xs.push_back({ t1[lane], obj });
+                    xs.push_back({ t2[lane], obj });
+                });
+            }
+            else if (node.IsLeaf())
+            {
+                for (uint32_t i = node.m_offset; i < node.m_offset + node.m_count; i++)
+                {
+                    ray.Intersect(m_objects[i], xs);
+                }
+            }
+            else
+            {
+                bool const secondIsNearest = tRay.m_dirIsNeg[node.m_axis];
+                stack[stackSize++] = secondIsNearest ? nodeIdx + 1u : node.m_offset;
+                nodeIdx = secondIsNearest ? node.m_offset : nodeIdx + 1u;
+                continue;
+            }
+        }
+
+        if (stackSize == 0u)
+        {
+            break;
+        }
+        nodeIdx = stack[--stackSize];
+    }
+}
+
+bool LinearBvh::IntersectClosest(Ray const& ray, Intersection& hit) const
+{
+    bool found = false;
+    for (auto const& obj : m_unbounded)
+    {
+        found |= ray.IntersectClosest(obj, hit);
+    }
+
+    if (!m_nodes.empty())
+    {
+        found |= IntersectClosest(ray, hit, 0u);
+    }
+    return found;
+}
+
+bool LinearBvh::IntersectClosest(Ray const& ray, Intersection& hit, uint32_t rootIdx) const
+{
+    bool found = false;
+    TraversalRay const tRay(ray);
+    std::array<uint32_t, Bvh::kMaxDepth> stack;
+    uint32_t stackSize = 0u;
+    uint32_t nodeIdx = rootIdx;
+    while (true)
+    {
+        auto const& node = m_nodes[nodeIdx];
+        // The bound shrinks with every hit, culling nodes still on the stack
+        float tMin = 0.f;
+        float tMax = ray.TMax();
+        if (SlabTest(node, tRay, tMin, tMax))
+        {
+            if (node.IsBatch())
+            {
+                found |= IntersectClosest(m_batches[node.m_offset], ray, hit);
+            }
+            else if (node.IsLeaf())
+            {
+                for (uint32_t i = node.m_offset; i < node.m_offset + node.m_count; i++)
+                {
+                    found |= ray.IntersectClosest(m_objects[i], hit);
+                }
+            }
+            else
+            {
+                bool const secondIsNearest = tRay.m_dirIsNeg[node.m_axis];
+                stack[stackSize++] = secondIsNearest ? nodeIdx + 1u : node.m_offset;
+                nodeIdx = secondIsNearest ? node.m_offset : nodeIdx + 1u;
+                continue;
+            }
+        }
+
+        if (stackSize == 0u)
+        {
+            break;
+        }
+        nodeIdx = stack[--stackSize];
+    }
+    return found;
+}
+
+bool LinearBvh::IntersectClosest(PrimitiveBatch const& batch, Ray const& ray, Intersection& hit) const
+{
+    float t1[PrimitiveBatch::kWidth];
+    float t2[PrimitiveBatch::kWidth];
+    bool found = false;
+    ForEachLane(batch.Intersect(ray, t1, t2), [&](uint32_t lane) {
+        Shape const* obj = m_objects[batch.m_objects[lane]].get();
+        found |= ray.UpdateClosest({ t1[lane], obj }, hit) || ray.UpdateClosest({ t2[lane], obj }, hit);
+    });
+    return found;
+}
+
+uint32_t LinearBvh::IntersectClosest(RayPacket const& packet, uint32_t mask, Intersection* hits) const
+{
+    uint32_t found = 0u;
+    for (auto const& obj : m_unbounded)
+    {
+        found |= packet.IntersectClosest(obj, mask, hits);
+    }
+
+    if (!m_nodes.empty())
+    {
+        found |= IntersectClosest(packet, mask, hits, 0u);
+    }
+    return found;
+}
+
+uint32_t LinearBvh::IntersectClosest(RayPacket const& packet, uint32_t mask, Intersection* hits, uint32_t rootIdx) const
+{
+    uint32_t found = 0u;
+    if (mask == 0u)
+    {
+        return found;
+    }
+
+    // Nodes are pushed with the lanes that reached their parent, every lane
+    // leaves the packet once it misses a node or has it all to itself
+    std::array<PacketEntry, Bvh::kMaxDepth + 1u> stack;
+    uint32_t stackSize = 0u;
+    stack[stackSize++] = { rootIdx, mask };
+    while (stackSize > 0u)
+    {
+        auto const entry = stack[--stackSize];
+        auto const& node = m_nodes[entry.m_nodeIdx];
+        uint32_t const active = entry.m_mask & packet.SlabTest(node.m_min, node.m_max, 0.f, packet.TMax());
+        if (active == 0u)
+        {
+            continue;
+        }
+
+        if (IsSingleLane(active))
+        {
+            ForEachLane(active, [&](uint32_t lane) {
+                Ray const ray = packet.At(lane);
+                if (IntersectClosest(ray, hits[lane], entry.m_nodeIdx))
+                {
+                    packet.TMax(lane, ray.TMax());
+                    found |= 1u << lane;
+                }
+            });
+        }
+        else if (node.IsBatch())
+        {
+            ForEachLane(active, [&](uint32_t lane) {
+                Ray const ray = packet.At(lane);
+                if (IntersectClosest(m_batches[node.m_offset], ray, hits[lane]))
+                {
+                    packet.TMax(lane, ray.TMax());
+                    found |= 1u << lane;
+                }
+            });
+        }
+        else if (node.IsLeaf())
+        {
+            for (uint32_t i = node.m_offset; i < node.m_offset + node.m_count; i++)
+            {
+                found |= packet.IntersectClosest(m_objects[i], active, hits);
+            }
+        }
+        else
+        {
+            // Rays of a packet are expected to go the same way, the first one decides
+            uint32_t const first = FirstLane(active);
+            bool const secondIsNearest = packet.DirIsNeg(first, node.m_axis);
+            uint32_t const nearIdx = secondIsNearest ? node.m_offset : entry.m_nodeIdx + 1u;
+            uint32_t const farIdx = secondIsNearest ? entry.m_nodeIdx + 1u : node.m_offset;
+            stack[stackSize++] = { farIdx, active };
+            stack[stackSize++] = { nearIdx, active };
+        }
+    }
+    return found;
+}
+
+ShapePtr const* LinearBvh::FindOccluder(Ray const& ray, float distance) const
+{
+    for (auto const& obj : m_unbounded)
+    {
+        if (ray.IntersectsBefore(obj, distance))
+        {
+            return &obj;
+        }
+    }
+
+    return m_nodes.empty() ? nullptr : FindOccluder(ray, distance, 0u);
+}
+
+ShapePtr const* LinearBvh::FindOccluder(Ray const& ray, float distance, uint32_t rootIdx) const
+{
+    TraversalRay const tRay(ray);
+    std::array<uint32_t, Bvh::kMaxDepth> stack;
+    uint32_t stackSize = 0u;
+    uint32_t nodeIdx = rootIdx;
+    while (true)
+    {
+        auto const& node = m_nodes[nodeIdx];
+        float tMin = EPSILON;
+        float tMax = distance;
+        if (node.CastsShadows() && SlabTest(node, tRay, tMin, tMax))
+        {
+            if (node.IsBatch())
+            {
+                if (auto const* occluder = FindOccluder(m_batches[node.m_offset], ray, distance))
+                {
+                    return occluder;
+                }
+            }
+            else if (node.IsLeaf())
+            {
+                for (uint32_t i = node.m_offset; i < node.m_offset + node.m_count; i++)
+                {
+                    if (ray.IntersectsBefore(m_objects[i], distance))
+                    {
+                        return &m_objects[i];
+                    }
+                }
+            }
+            else
+            {
+                bool const secondIsNearest = tRay.m_dirIsNeg[node.m_axis];
+                stack[stackSize++] = secondIsNearest ? nodeIdx + 1u : node.m_offset;
+                nodeIdx = secondIsNearest ? node.m_offset : nodeIdx + 1u;
+                continue;
+            }
+        }
+
+        if (stackSize == 0u)
+        {
+            break;
+        }
+        nodeIdx = stack[--stackSize];
+    }
+    return nullptr;
+}
+
+ShapePtr const* LinearBvh::FindOccluder(PrimitiveBatch const& batch, Ray const& ray, float distance) const
+{
+    float t1[PrimitiveBatch::kWidth];
+    float t2[PrimitiveBatch::kWidth];
+    ShapePtr const* occluder = nullptr;
+    ForEachLane(batch.Intersect(ray, t1, t2) & batch.m_shadowCasters, [&](uint32_t lane) {
+        if ((occluder == nullptr) && (IsOccluding(t1[lane], distance) || IsOccluding(t2[lane], distance)))
+        {
+            occluder = &m_objects[batch.m_objects[lane]];
+        }
+    });
+    return occluder;
+}
+
+uint32_t LinearBvh::FindOccluders(RayPacket const& packet, uint32_t mask, float const* distances) const
+{
+    uint32_t occluded = 0u;
+    for (auto const& obj : m_unbounded)
+    {
+        occluded |= packet.IntersectsBefore(obj, mask & ~occluded, distances);
+    }
+
+    if (!m_nodes.empty())
+    {
+        occluded |= FindOccluders(packet, mask & ~occluded, distances, 0u);
+    }
+    return occluded;
+}
+
+uint32_t LinearBvh::FindOccluders(RayPacket const& packet, uint32_t mask, float const* distances, uint32_t rootIdx) const
+{
+    // Same as closest hits, except that lanes are done once occluded
+    uint32_t occluded = 0u;
+    std::array<PacketEntry, Bvh::kMaxDepth + 1u> stack;
+    uint32_t stackSize = 0u;
+    stack[stackSize++] = { rootIdx, mask };
+    while (stackSize > 0u)
+    {
+        auto const entry = stack[--stackSize];
+        auto const& node = m_nodes[entry.m_nodeIdx];
+        uint32_t active = entry.m_mask & ~occluded;
+        if ((active == 0u) || !node.CastsShadows())
+        {
+            continue;
+        }
+        active &= packet.SlabTest(node.m_min, node.m_max, EPSILON, distances);
+        if (active == 0u)
+        {
+            continue;
+        }
+
+        if (IsSingleLane(active))
+        {
+            ForEachLane(active, [&](uint32_t lane) {
+                occluded |= (FindOccluder(packet.At(lane), distances[lane], entry.m_nodeIdx) != nullptr) ? (1u << lane) : 0u;
+            });
+        }
+        else if (node.IsBatch())
+        {
+            ForEachLane(active, [&](uint32_t lane) {
+                occluded |= (FindOccluder(m_batches[node.m_offset], packet.At(lane), distances[lane]) != nullptr) ? (1u << lane) : 0u;
+            });
+        }
+        else if (node.IsLeaf())
+        {
+            for (uint32_t i = node.m_offset; (i < node.m_offset + node.m_count) && ((active & ~occluded) != 0u); i++)
+            {
+                occluded |= packet.IntersectsBefore(m_objects[i], active & ~occluded, distances);
+            }
+        }
+        else
+        {
+            uint32_t const first = FirstLane(active);
+            bool const secondIsNearest = packet.DirIsNeg(first, node.m_axis);
+            uint32_t const nearIdx = secondIsNearest ? node.m_offset : entry.m_nodeIdx + 1u;
+            uint32_t const farIdx = secondIsNearest ? entry.m_nodeIdx + 1u : node.m_offset;
+            stack[stackSize++] = { farIdx, active };
+            stack[stackSize++] = { nearIdx, active };
+        }
+    }
+    return occluded;
+}
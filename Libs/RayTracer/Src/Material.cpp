@@ -60,7 +60,7 @@ bool Material::operator==(Material const& other) const
         && Pattern()->operator==(other.Pattern());
 }
 
-Color Material::ColorAt(ShapeConstPtr const& shape, Tuple const& point) const
+Color Material::ColorAt(Shape const* shape, Tuple const& point) const
 {
     return m_pattern->ShapeColorAt(shape, point);
 }
@@ -104,12 +104,12 @@ PatternPtr IPattern::FromJSON(json const& data)
 }
 
 IPattern::IPattern()
-    : m_transform(Mat44::Identity())
-    , m_invTransform(Mat44::Identity())
+    : m_transform()
+    , m_invTransform()
 {
 }
 
-Color IPattern::ShapeColorAt(ShapeConstPtr const& shape, Tuple const& point) const
+Color IPattern::ShapeColorAt(Shape const* shape, Tuple const& point) const
 {
     Tuple const objectPoint = shape->WorldToLocal(point);
     Tuple const patternPoint = InvTransform() * objectPoint;
@@ -0,0 +1,190 @@
+#include "PrimitiveBatch.h"
+
+#include "Ray.h"
+#include "Shapes/Cube.h"
+#include "Shapes/Sphere.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <typeinfo>
+
+#ifdef USE_AVX
+#include <immintrin.h>
+#endif
+
+// static
+bool PrimitiveBatch::CanBatch(Shape const& shape)
+{
+    auto const& type = typeid(shape);
+    return (type == typeid(Sphere)) || (type == typeid(Cube));
+}
+
+void PrimitiveBatch::Add(uint32_t objectIdx, Shape const& shape)
+{
+    if (m_count >= kWidth)
+    {
+        throw std::runtime_error("Primitive batch is full!");
+    }
+
+    uint32_t const lane = m_count++;
+    m_objects[lane] = objectIdx;
+    Update(lane, shape);
+}
+
+void PrimitiveBatch::Update(uint32_t lane, Shape const& shape)
+{
+    auto const& invTransform = shape.InvTransform();
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        for (uint8_t j = 0; j < 4; j++)
+        {
+            m_invTransform[(i * 4) + j][lane] = invTransform.At(i, j);
+        }
+    }
+
+    uint32_t const bit = 1u << lane;
+    m_cubes = (typeid(shape) == typeid(Cube)) ? (m_cubes | bit) : (m_cubes & ~bit);
+    m_shadowCasters = shape.CastShadows() ? (m_shadowCasters | bit) : (m_shadowCasters & ~bit);
+}
+
+uint32_t PrimitiveBatch::Intersect(Ray const& ray, float* t1, float* t2) const
+{
+#ifdef USE_AVX
+    return batch::IntersectAvx(*this, ray, t1, t2);
+#else
+    return batch::IntersectScalar(*this, ray, t1, t2);
+#endif
+}
+
+namespace
+{
+
+// Same as Bounds::CheckAxis for the unit cube, including how rays lying in
+// the plane of a face produce NaNs that the min and max then discard
+void Slab(float origin, float direction, float& lo, float& hi)
+{
+    float const oneOverDir = 1.f / direction;
+    float const tMin = (-1.f - origin) * oneOverDir;
+    float const tMax = (1.f - origin) * oneOverDir;
+    lo = (tMin > tMax) ? tMax : tMin;
+    hi = (tMin > tMax) ? tMin : tMax;
+}
+
+}
+
+namespace batch
+{
+
+// Mirrors Sphere::Intersect and Cube::Intersect, lane by lane
+uint32_t IntersectScalar(PrimitiveBatch const& batch, Ray const& ray, float* t1, float* t2)
+{
+    auto const& m = batch.m_invTransform;
+    auto const& o = ray.Origin();
+    auto const& d = ray.Direction();
+
+    uint32_t hits = 0u;
+    for (uint32_t lane = 0u; lane < batch.m_count; lane++)
+    {
+        float const ox = (m[0][lane] * o.X()) + (m[1][lane] * o.Y()) + (m[2][lane] * o.Z()) + m[3][lane];
+        float const oy = (m[4][lane] * o.X()) + (m[5][lane] * o.Y()) + (m[6][lane] * o.Z()) + m[7][lane];
+        float const oz = (m[8][lane] * o.X()) + (m[9][lane] * o.Y()) + (m[10][lane] * o.Z()) + m[11][lane];
+        float const dx = (m[0][lane] * d.X()) + (m[1][lane] * d.Y()) + (m[2][lane] * d.Z());
+        float const dy = (m[4][lane] * d.X()) + (m[5][lane] * d.Y()) + (m[6][lane] * d.Z());
+        float const dz = (m[8][lane] * d.X()) + (m[9][lane] * d.Y()) + (m[10][lane] * d.Z());
+
+        bool hit;
+        if ((batch.m_cubes & (1u << lane)) != 0u)
+        {
+            float xLo, xHi, yLo, yHi, zLo, zHi;
+            Slab(ox, dx, xLo, xHi);
+            Slab(oy, dy, yLo, yHi);
+            Slab(oz, dz, zLo, zHi);
+            t1[lane] = std::max(xLo, std::max(yLo, zLo));
+            t2[lane] = std::min(xHi, std::min(yHi, zHi));
+            hit = t1[lane] <= t2[lane];
+        }
+        else
+        {
+            float const a = (dx * dx) + (dy * dy) + (dz * dz);
+            float const b = 2.f * ((dx * ox) + (dy * oy) + (dz * oz));
+            float const c = (ox * ox) + (oy * oy) + (oz * oz) - 1.f;
+            hit = SolveQuadratic(a, b, c, t1[lane], t2[lane]);
+        }
+
+        hits |= hit ? (1u << lane) : 0u;
+    }
+    return hits;
+}
+
+#ifdef USE_AVX
+uint32_t IntersectAvx(PrimitiveBatch const& batch, Ray const& ray, float* t1, float* t2)
+{
+    auto const& m = batch.m_invTransform;
+    auto const& o = ray.Origin();
+    auto const& d = ray.Direction();
+    auto const row = [&m](int i) { return _mm256_load_ps(m[i]); };
+
+    __m256 const oX = _mm256_set1_ps(o.X()), oY = _mm256_set1_ps(o.Y()), oZ = _mm256_set1_ps(o.Z());
+    __m256 const dX = _mm256_set1_ps(d.X()), dY = _mm256_set1_ps(d.Y()), dZ = _mm256_set1_ps(d.Z());
+    auto const transform = [&](int i, __m256 x, __m256 y, __m256 z) {
+        return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(row(i), x), _mm256_mul_ps(row(i + 1), y)), _mm256_mul_ps(row(i + 2), z));
+    };
+    __m256 const ox = _mm256_add_ps(transform(0, oX, oY, oZ), row(3));
+    __m256 const oy = _mm256_add_ps(transform(4, oX, oY, oZ), row(7));
+    __m256 const oz = _mm256_add_ps(transform(8, oX, oY, oZ), row(11));
+    __m256 const dx = transform(0, dX, dY, dZ);
+    __m256 const dy = transform(4, dX, dY, dZ);
+    __m256 const dz = transform(8, dX, dY, dZ);
+
+    __m256 const one = _mm256_set1_ps(1.f);
+    __m256 const minusOne = _mm256_set1_ps(-1.f);
+
+    // Cubes, eight lanes of Slab above with operands ordered as in
+    // math::sse::Slab so NaNs are discarded the same way
+    auto const slab = [&](__m256 origin, __m256 direction, __m256& lo, __m256& hi) {
+        __m256 const inv = _mm256_div_ps(one, direction);
+        __m256 const tMin = _mm256_mul_ps(_mm256_sub_ps(minusOne, origin), inv);
+        __m256 const tMax = _mm256_mul_ps(_mm256_sub_ps(one, origin), inv);
+        lo = _mm256_min_ps(tMax, tMin);
+        hi = _mm256_max_ps(tMin, tMax);
+    };
+    __m256 xLo, xHi, yLo, yHi, zLo, zHi;
+    slab(ox, dx, xLo, xHi);
+    slab(oy, dy, yLo, yHi);
+    slab(oz, dz, zLo, zHi);
+    __m256 const cubeT1 = _mm256_max_ps(_mm256_max_ps(zLo, yLo), xLo);
+    __m256 const cubeT2 = _mm256_min_ps(_mm256_min_ps(zHi, yHi), xHi);
+    __m256 const cubeHit = _mm256_cmp_ps(cubeT1, cubeT2, _CMP_LE_OQ);
+
+    // Spheres, same roots as SolveQuadratic for the unit sphere
+    __m256 const a = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+    __m256 const b = _mm256_mul_ps(_mm256_set1_ps(2.f),
+        _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, ox), _mm256_mul_ps(dy, oy)), _mm256_mul_ps(dz, oz)));
+    __m256 const c = _mm256_sub_ps(
+        _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ox, ox), _mm256_mul_ps(oy, oy)), _mm256_mul_ps(oz, oz)), one);
+    __m256 const discriminant = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(4.f), a), c));
+    __m256 const absDiscriminant = _mm256_andnot_ps(_mm256_set1_ps(-0.f), discriminant);
+    __m256 const tangent = _mm256_cmp_ps(absDiscriminant, _mm256_set1_ps(EPSILON), _CMP_LT_OQ);
+    __m256 const sqrtD = _mm256_andnot_ps(tangent, _mm256_sqrt_ps(_mm256_max_ps(discriminant, _mm256_setzero_ps())));
+    __m256 const den = _mm256_div_ps(one, _mm256_mul_ps(_mm256_set1_ps(2.f), a));
+    __m256 const minusB = _mm256_sub_ps(_mm256_setzero_ps(), b);
+    __m256 const r1 = _mm256_mul_ps(_mm256_sub_ps(minusB, sqrtD), den);
+    __m256 const r2 = _mm256_mul_ps(_mm256_add_ps(minusB, sqrtD), den);
+    __m256 const sphereHit = _mm256_or_ps(tangent, _mm256_cmp_ps(discriminant, _mm256_setzero_ps(), _CMP_GE_OQ));
+
+    // Each lane picks the results of its kind of shape. Integer compares
+    // need AVX2, so the mask is expanded with scalar code.
+    auto const laneMask = [&batch](int lane) { return -static_cast<int>((batch.m_cubes >> lane) & 1u); };
+    __m256 const isCube = _mm256_castsi256_ps(_mm256_set_epi32(
+        laneMask(7), laneMask(6), laneMask(5), laneMask(4), laneMask(3), laneMask(2), laneMask(1), laneMask(0)));
+
+    _mm256_storeu_ps(t1, _mm256_blendv_ps(_mm256_min_ps(r1, r2), cubeT1, isCube));
+    _mm256_storeu_ps(t2, _mm256_blendv_ps(_mm256_max_ps(r1, r2), cubeT2, isCube));
+    uint32_t const hits = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_blendv_ps(sphereHit, cubeHit, isCube)));
+    return hits & ((1u << batch.m_count) - 1u);
+}
+#endif
+
+}
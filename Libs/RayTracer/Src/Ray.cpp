@@ -1,9 +1,55 @@
 #include "Ray.h"
+#include "Shapes/Instance.h"
 #include "Util.h"
 
-Ray::Ray(Tuple const& origin, Tuple const& direction)
+#include <array>
+
+namespace
+{
+
+// Objects a ray is inside of, innermost last. It's bounded so it never
+// allocates, objects entered once it's full are not tracked.
+class ContainerStack
+{
+public:
+    static constexpr uint32_t kCapacity = 32u;
+
+    // Enters the surface that was hit, or exits it if already inside
+    void Toggle(Intersection const& i)
+    {
+        // The same object may be hit through different instances, so both
+        // have to match. Surfaces exited are usually the innermost ones.
+        for (uint32_t idx = m_size; idx-- > 0u;)
+        {
+            if ((m_entries[idx]->Object() == i.Object()) && (m_entries[idx]->Instance() == i.Instance()))
+            {
+                std::copy(m_entries.begin() + idx + 1u, m_entries.begin() + m_size, m_entries.begin() + idx);
+                m_size--;
+                return;
+            }
+        }
+        if (m_size < kCapacity)
+        {
+            m_entries[m_size++] = &i;
+        }
+    }
+
+    float RefractiveIndex() const
+    {
+        return (m_size == 0u) ? 1.f : m_entries[m_size - 1u]->GetMaterial().RefractiveIndex();
+    }
+
+private:
+    std::array<Intersection const*, kCapacity> m_entries;
+    uint32_t m_size = 0u;
+};
+
+}
+
+Ray::Ray(Tuple const& origin, Tuple const& direction, float tMax)
     : m_origin(origin)
     , m_direction(direction)
+    , m_tMax(tMax)
 {
 }
 
@@ -15,29 +61,72 @@ void Ray::Intersect(ShapePtr const& shape, std::vector<Intersection>& xs) const
 
 void Ray::Intersect(World const& world, std::vector<Intersection>& xs) const
 {
-    for (auto const& obj : world.Objects())
+    if (auto const* accelerator = world.GetAccelerator())
     {
-        Intersect(obj, xs);
+        accelerator->Intersect(*this, xs);
+    }
+    else
+    {
+        for (auto const& obj : world.Objects())
+        {
+            Intersect(obj, xs);
+        }
     }
     std::sort(xs.begin(), xs.end());
 }
 
-bool Ray::IntersectsBefore(ShapePtr const& shape, float distance) const
+bool Ray::IntersectClosest(ShapePtr const& shape, Intersection& hit) const
 {
+    // Transforms keep distances along the ray, so the bound carries over as is
     Ray const r = shape->InvTransform() * (*this);
-    return shape->CastShadows() && shape->IntersectsBefore(r, distance);
+    if (!shape->IntersectClosest(r, hit))
+    {
+        return false;
+    }
+    m_tMax = r.TMax();
+    return true;
+}
+
+bool Ray::IntersectClosest(World const& world, Intersection& hit) const
+{
+    if (auto const* accelerator = world.GetAccelerator())
+    {
+        return accelerator->IntersectClosest(*this, hit);
+    }
+
+    bool found = false;
+    for (auto const& obj : world.Objects())
+    {
+        found |= IntersectClosest(obj, hit);
+    }
+    return found;
+}
+
+bool Ray::IntersectsBefore(Shape const& shape, float distance) const
+{
+    if (!shape.CastShadows())
+    {
+        return false;
+    }
+    Ray const r = shape.InvTransform() * (*this);
+    return shape.IntersectsBefore(r, distance);
 }
 
-bool Ray::HasIntersectionNearThan(World const& world, float distance) const
+ShapePtr const* Ray::FindOccluder(World const& world, float distance) const
 {
+    if (auto const* accelerator = world.GetAccelerator())
+    {
+        return accelerator->FindOccluder(*this, distance);
+    }
+
     for (auto const& obj : world.Objects())
     {
         if (IntersectsBefore(obj, distance))
         {
-            return true;
+            return &obj;
         }
     }
-    return false;
+    return nullptr;
 }
 
 IntersectionData Ray::Precompute(Intersection const& i, std::vector<Intersection> const& xs) const
@@ -45,9 +134,12 @@ IntersectionData Ray::Precompute(Intersection const& i, std::vector<Intersection
     IntersectionData data;
     data.m_distance = i.Distance();
     data.m_object = i.Object();
+    data.m_instance = i.Instance();
     data.m_point = Position(data.m_distance);
     data.m_eyev = -m_direction;
-    data.m_normalv = data.m_object->NormalAt(data.m_point);
+    data.m_normalv = (data.m_instance != nullptr)
+        ? data.m_instance->PrototypeNormalAt(data.m_object, data.m_point)
+        : data.m_object->NormalAt(data.m_point);
     data.m_inside = data.m_normalv.Dot(data.m_eyev) < 0.f;
     if (data.m_inside)
     {
@@ -56,29 +148,29 @@ IntersectionData Ray::Precompute(Intersection const& i, std::vector<Intersection
     data.m_overPoint = data.m_point + (data.m_normalv * EPSILON);
     data.m_underPoint = data.m_point - (data.m_normalv * EPSILON);
     data.m_reflectv = m_direction.Reflect(data.m_normalv);
+    data.m_n1 = 1.f;
+    data.m_n2 = 1.f;
 
-    std::vector<ShapeConstPtr> containers;
+    // Refractive indices are only used to refract through transparent hits
+    if (data.GetMaterial().Transparency() == 0.f)
+    {
+        return data;
+    }
+
+    ContainerStack containers;
     for (auto const& current : xs)
     {
         bool const currentIsHit = current == i;
         if (currentIsHit)
         {
-            data.m_n1 = containers.empty() ? 1.f : containers.back()->GetMaterial().RefractiveIndex();
+            data.m_n1 = containers.RefractiveIndex();
         }
 
-        auto it = std::find(containers.begin(), containers.end(), current.Object());
-        if (it != containers.end())
-        {
-            containers.erase(it);
-        }
-        else
-        {
-            containers.push_back(current.Object());
-        }
+        containers.Toggle(current);
 
         if (currentIsHit)
         {
-            data.m_n2 = containers.empty() ? 1.f : containers.back()->GetMaterial().RefractiveIndex();
+            data.m_n2 = containers.RefractiveIndex();
             break;
         }
     }
@@ -88,5 +180,10 @@ IntersectionData Ray::Precompute(Intersection const& i, std::vector<Intersection
 
 Ray operator*(Mat44 const& m, Ray const& r)
 {
-    return Ray{ m * r.Origin(), m * r.Direction() };
+    return Ray{ m * r.Origin(), m * r.Direction(), r.TMax() };
+}
+
+Ray operator*(AffineTransform const& t, Ray const& r)
+{
+    return t.IsIdentity() ? r : Ray{ t * r.Origin(), t * r.Direction(), r.TMax() };
 }
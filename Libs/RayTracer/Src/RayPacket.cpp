@@ -0,0 +1,153 @@
+#include "RayPacket.h"
+
+#include "MathIntrinsics.h"
+#include "Shapes/Shape.h"
+#include "World.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef USE_SSE
+#include <emmintrin.h>
+#endif
+
+RayPacket::RayPacket()
+    : m_origin()
+    , m_direction()
+    , m_invDir()
+    , m_tMax()
+    , m_size(0u)
+{
+}
+
+void RayPacket::Add(Ray const& ray)
+{
+    if (m_size >= kMaxSize)
+    {
+        throw std::runtime_error("Ray packet is full!");
+    }
+
+    uint32_t const lane = m_size++;
+    for (uint32_t axis = 0u; axis < 3u; axis++)
+    {
+        m_origin[axis][lane] = ray.Origin()[axis];
+        m_direction[axis][lane] = ray.Direction()[axis];
+        m_invDir[axis][lane] = 1.f / ray.Direction()[axis];
+    }
+    m_tMax[lane] = ray.TMax();
+}
+
+Ray RayPacket::At(uint32_t lane) const
+{
+    return Ray(
+        Point(m_origin[0][lane], m_origin[1][lane], m_origin[2][lane]),
+        Vector(m_direction[0][lane], m_direction[1][lane], m_direction[2][lane]),
+        m_tMax[lane]);
+}
+
+void RayPacket::ResetTMax() const
+{
+    std::fill(m_tMax, m_tMax + kMaxSize, INF);
+}
+
+uint32_t RayPacket::SlabTest(float const* min, float const* max, float tMin, float const* tMax) const
+{
+    uint32_t hits = 0u;
+#ifdef USE_SSE
+    for (uint32_t lane = 0u; lane < m_size; lane += 4u)
+    {
+        __m128 lo = _mm_set1_ps(tMin);
+        __m128 hi = _mm_loadu_ps(tMax + lane);
+        for (uint32_t axis = 0u; axis < 3u; axis++)
+        {
+            math::sse::Slab(_mm_set1_ps(min[axis]), _mm_set1_ps(max[axis]),
+                _mm_load_ps(m_origin[axis] + lane), _mm_load_ps(m_invDir[axis] + lane), lo, hi);
+        }
+        hits |= math::sse::SlabHits(lo, hi) << lane;
+    }
+#else
+    for (uint32_t lane = 0u; lane < m_size; lane++)
+    {
+        float lo = tMin;
+        float hi = tMax[lane];
+        for (uint32_t axis = 0u; axis < 3u; axis++)
+        {
+            math::scalar::Slab(min[axis], max[axis], m_origin[axis][lane], m_invDir[axis][lane], lo, hi);
+        }
+        hits |= (lo <= hi) ? (1u << lane) : 0u;
+    }
+#endif
+    return hits;
+}
+
+uint32_t RayPacket::IntersectClosest(ShapePtr const& shape, uint32_t mask, Intersection* hits) const
+{
+    // Transforms keep distances along the rays, so the bounds carry over as is
+    RayPacket const local = shape->InvTransform() * (*this);
+    uint32_t const found = shape->IntersectClosest(local, mask, hits);
+    ForEachLane(found, [&](uint32_t lane) { m_tMax[lane] = local.m_tMax[lane]; });
+    return found;
+}
+
+uint32_t RayPacket::IntersectClosest(World const& world, uint32_t mask, Intersection* hits) const
+{
+    if (auto const* accelerator = world.GetAccelerator())
+    {
+        return accelerator->IntersectClosest(*this, mask, hits);
+    }
+
+    uint32_t found = 0u;
+    for (auto const& obj : world.Objects())
+    {
+        found |= IntersectClosest(obj, mask, hits);
+    }
+    return found;
+}
+
+uint32_t RayPacket::IntersectsBefore(ShapePtr const& shape, uint32_t mask, float const* distances) const
+{
+    if (!shape->CastShadows())
+    {
+        return 0u;
+    }
+    RayPacket const local = shape->InvTransform() * (*this);
+    return shape->IntersectsBefore(local, mask, distances);
+}
+
+uint32_t RayPacket::FindOccluders(World const& world, uint32_t mask, float const* distances) const
+{
+    if (auto const* accelerator = world.GetAccelerator())
+    {
+        return accelerator->FindOccluders(*this, mask, distances);
+    }
+
+    uint32_t occluded = 0u;
+    for (auto const& obj : world.Objects())
+    {
+        occluded |= IntersectsBefore(obj, mask & ~occluded, distances);
+    }
+    return occluded;
+}
+
+RayPacket operator*(AffineTransform const& t, RayPacket const& packet)
+{
+    if (t.IsIdentity())
+    {
+        return packet;
+    }
+
+    // Same arithmetic as transforming every ray on its own
+    RayPacket result = packet;
+    for (uint32_t lane = 0u; lane < packet.m_size; lane++)
+    {
+        auto const origin = t * Point(packet.m_origin[0][lane], packet.m_origin[1][lane], packet.m_origin[2][lane]);
+        auto const direction = t * Vector(packet.m_direction[0][lane], packet.m_direction[1][lane], packet.m_direction[2][lane]);
+        for (uint32_t axis = 0u; axis < 3u; axis++)
+        {
+            result.m_origin[axis][lane] = origin[axis];
+            result.m_direction[axis][lane] = direction[axis];
+            result.m_invDir[axis][lane] = 1.f / direction[axis];
+        }
+    }
+    return result;
+}
@@ -0,0 +1,39 @@
+#include "RenderSettings.h"
+
+#include <stdexcept>
+
+void RenderSettings::Validate() const
+{
+    if (m_tileSize == 0u)
+    {
+        throw std::runtime_error("Tiles must hold at least one pixel!");
+    }
+    if (m_tiles.has_value() && (m_tiles->first >= m_tiles->second))
+    {
+        throw std::runtime_error("Tile ranges can't be empty!");
+    }
+    if (m_samplesPerPixel == 0u)
+    {
+        throw std::runtime_error("Pixels must have at least one sample!");
+    }
+    if ((m_maxSamplesPerPixel != 0u) && (m_maxSamplesPerPixel < m_samplesPerPixel))
+    {
+        throw std::runtime_error("Pixels can't have more samples than their max!");
+    }
+    if (m_adaptiveThreshold < 0.f)
+    {
+        throw std::runtime_error("Adaptive thresholds can't be negative!");
+    }
+    if ((m_passes == 0u) || (m_passes > kMaxPasses))
+    {
+        throw std::runtime_error("Progressive renders have 1 to 8 passes!");
+    }
+    if (m_timeBudget < 0.)
+    {
+        throw std::runtime_error("Time budgets can't be negative!");
+    }
+    if ((m_packetSize != 1u) && (m_packetSize != 4u) && (m_packetSize != 8u) && (m_packetSize != 16u))
+    {
+        throw std::runtime_error("Packets hold 1, 4, 8 or 16 rays!");
+    }
+}
@@ -0,0 +1,86 @@
+#include "RenderTarget.h"
+
+#include <algorithm>
+
+RenderTarget::RenderTarget(uint32_t width, uint32_t height)
+    : m_width(width)
+    , m_height(height)
+    , m_canvas(width, height)
+    , m_coverage(size_t(width) * height, 0u)
+    , m_samples(size_t(width) * height, 0u)
+{
+}
+
+Canvas RenderTarget::Snapshot(std::vector<uint8_t>* coverage, std::vector<uint32_t>* samples) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (coverage != nullptr)
+    {
+        *coverage = m_coverage;
+    }
+    if (samples != nullptr)
+    {
+        *samples = m_samples;
+    }
+
+    Canvas snapshot(m_width, m_height);
+    for (uint32_t y = 0u; y < m_height; y++)
+    {
+        for (uint32_t x = 0u; x < m_width; x++)
+        {
+            snapshot.WritePixel(x, y, m_canvas.PixelAt(x, y));
+        }
+    }
+    return snapshot;
+}
+
+bool RenderTarget::IsComplete() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_traced == m_coverage.size();
+}
+
+void RenderTarget::Write(std::vector<PixelBlock> const& blocks, uint32_t blockSize)
+{
+    auto const size = static_cast<uint8_t>(std::min(blockSize, 255u));
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto const& block : blocks)
+    {
+        for (uint32_t y = block.m_y0; y < std::min(block.m_y1, m_height); y++)
+        {
+            for (uint32_t x = block.m_x0; x < std::min(block.m_x1, m_width); x++)
+            {
+                m_canvas.WritePixel(x, y, block.m_color);
+                m_samples[(size_t(y) * m_width) + x] = block.m_samples;
+                auto& coverage = m_coverage[(size_t(y) * m_width) + x];
+                m_traced += ((coverage != 1u) && (size == 1u)) ? 1u : 0u;
+                coverage = size;
+            }
+        }
+    }
+}
+
+std::vector<PixelBlock> RenderTarget::Read(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<PixelBlock> blocks;
+    for (uint32_t y = y0; y < std::min(y1, m_height); y++)
+    {
+        for (uint32_t x = x0; x < std::min(x1, m_width); x++)
+        {
+            blocks.push_back({ x, y, x + 1u, y + 1u, m_canvas.PixelAt(x, y), m_samples[(size_t(y) * m_width) + x] });
+        }
+    }
+    return blocks;
+}
+
+Canvas RenderTarget::TakeCanvas()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_width = 0u;
+    m_height = 0u;
+    m_coverage.clear();
+    m_samples.clear();
+    m_traced = 0u;
+    return std::move(m_canvas);
+}
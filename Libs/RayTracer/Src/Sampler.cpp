@@ -0,0 +1,199 @@
+#include "Sampler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr float kR2X = .7548777f;
+    constexpr float kR2Y = .5698403f;
+    constexpr float kGoldenRatio = .618034f; // shift of the R2 pairs of dimensions after the first one
+
+    // Samples of dimensions reusing a Halton base are shuffled by blocks of
+    // that many
+    constexpr uint32_t kPermutedBlock = 4096u;
+
+    // Largest float below 1
+    constexpr float kOneMinusEpsilon = 1.f - (1.f / 16777216.f);
+
+    constexpr uint32_t kPrimes[HaltonSampler::kBaseCount] = {
+        2u, 3u, 5u, 7u, 11u, 13u, 17u, 19u, 23u, 29u, 31u, 37u, 41u, 43u, 47u, 53u,
+        59u, 61u, 67u, 71u, 73u, 79u, 83u, 89u, 97u, 101u, 103u, 107u, 109u, 113u, 127u, 131u
+    };
+
+    uint32_t Hash(uint32_t x)
+    {
+        x ^= x >> 16u;
+        x *= 0x7feb352du;
+        x ^= x >> 15u;
+        x *= 0x846ca68bu;
+        x ^= x >> 16u;
+        return x;
+    }
+
+    uint32_t Hash(uint32_t a, uint32_t b)
+    {
+        return Hash(a ^ (Hash(b) + 0x9e3779b9u + (a << 6u) + (a >> 2u)));
+    }
+
+    uint32_t PixelSeed(uint32_t x, uint32_t y, uint32_t seed)
+    {
+        return Hash(Hash(x, y), seed);
+    }
+
+    // Top 24 bits as a float in [0, 1)
+    float ToUnit(uint32_t bits)
+    {
+        return (bits >> 8u) * (1.f / 16777216.f);
+    }
+
+    uint32_t ReverseBits(uint32_t x)
+    {
+        x = ((x >> 1u) & 0x55555555u) | ((x & 0x55555555u) << 1u);
+        x = ((x >> 2u) & 0x33333333u) | ((x & 0x33333333u) << 2u);
+        x = ((x >> 4u) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4u);
+        x = ((x >> 8u) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8u);
+        return (x >> 16u) | (x << 16u);
+    }
+
+    // Owen scrambling of the bits of a fraction: every bit is flipped
+    // depending on the seed and the bits above it only, so points in the same
+    // elementary intervals stay together. The original hash and constants of
+    // Laine and Karras' "Stratified Sampling for Stochastic Transparency",
+    // applied to the reversed bits as in Burley's "Practical Hash-based Owen
+    // Scrambling".
+    uint32_t OwenScramble(uint32_t bits, uint32_t seed)
+    {
+        uint32_t x = ReverseBits(bits);
+        x += seed;
+        x ^= x * 0x6c50b47cu;
+        x ^= x * 0xb82f1e52u;
+        x ^= x * 0xc7afe638u;
+        x ^= x * 0x8d22f6e6u;
+        return ReverseBits(x);
+    }
+
+    // Second dimension of the Sobol sequence, from the primitive polynomial
+    // x + 1. The first one is the van der Corput sequence, ReverseBits.
+    uint32_t SobolSecond(uint32_t index)
+    {
+        uint32_t bits = 0u;
+        for (uint32_t v = 1u << 31u; index != 0u; index >>= 1u, v ^= v >> 1u)
+        {
+            if ((index & 1u) != 0u)
+            {
+                bits ^= v;
+            }
+        }
+        return bits;
+    }
+
+    // Radical inverse with every digit shifted by a hash of its position,
+    // including the leading zeros up to the precision of a float
+    float ShiftedRadicalInverse(uint32_t base, uint32_t index, uint32_t seed)
+    {
+        double const invBase = 1. / base;
+        double scale = invBase;
+        double value = 0.;
+        for (uint32_t position = 0u; scale > 1e-8; position++)
+        {
+            uint32_t const digit = ((index % base) + (Hash(seed, position) % base)) % base;
+            value += digit * scale;
+            index /= base;
+            scale *= invBase;
+        }
+        return std::min(static_cast<float>(value), kOneMinusEpsilon);
+    }
+
+    // Element i of a random permutation of [0, count) picked by seed, from
+    // Kensler's "Correlated Multi-Jittered Sampling"
+    uint32_t Permute(uint32_t i, uint32_t count, uint32_t seed)
+    {
+        uint32_t w = count - 1u;
+        w |= w >> 1u;
+        w |= w >> 2u;
+        w |= w >> 4u;
+        w |= w >> 8u;
+        w |= w >> 16u;
+        do
+        {
+            i ^= seed;
+            i *= 0xe170893du;
+            i ^= seed >> 16u;
+            i ^= (i & w) >> 4u;
+            i ^= seed >> 8u;
+            i *= 0x0929eb3fu;
+            i ^= seed >> 23u;
+            i ^= (i & w) >> 1u;
+            i *= 1u | (seed >> 27u);
+            i *= 0x6935fa69u;
+            i ^= (i & w) >> 11u;
+            i *= 0x74dcb303u;
+            i ^= (i & w) >> 2u;
+            i *= 0x9e501cc3u;
+            i ^= (i & w) >> 2u;
+            i *= 0xc860a3dfu;
+            i &= w;
+            i ^= i >> 5u;
+        } while (i >= count);
+        return (i + seed) % count;
+    }
+}
+
+float R2Sampler::Get(uint32_t, uint32_t, uint32_t sample, uint32_t dimension) const
+{
+    float const shift = .5f + std::fmod((dimension / 2u) * kGoldenRatio, 1.f);
+    float const alpha = ((dimension % 2u) == 0u) ? kR2X : kR2Y;
+    return std::fmod(shift + (sample * alpha), 1.f);
+}
+
+float SobolSampler::Get(uint32_t x, uint32_t y, uint32_t sample, uint32_t dimension) const
+{
+    // Scrambling the indices the same way maps the first 2^m samples to an
+    // aligned block of 2^m points, still a net, but pairs no longer see them
+    // in the same order
+    uint32_t const pairSeed = Hash(PixelSeed(x, y, m_seed), dimension / 2u);
+    uint32_t const index = OwenScramble(sample, Hash(pairSeed, 0u));
+    uint32_t const bits = ((dimension % 2u) == 0u) ? ReverseBits(index) : SobolSecond(index);
+    return ToUnit(OwenScramble(bits, Hash(pairSeed, 1u + (dimension % 2u))));
+}
+
+float HaltonSampler::Get(uint32_t x, uint32_t y, uint32_t sample, uint32_t dimension) const
+{
+    // A base reused with the same index would only shift digits, a fixed
+    // function of the first dimension using it. Indices are shuffled within
+    // blocks instead, which keeps every block of points but pairs them
+    // differently.
+    uint32_t const pixel = PixelSeed(x, y, m_seed);
+    uint32_t const reuse = dimension / kBaseCount;
+    uint32_t index = sample;
+    if (reuse > 0u)
+    {
+        uint32_t const inBlock = Permute(sample % kPermutedBlock, kPermutedBlock, Hash(pixel, reuse));
+        index = (sample - (sample % kPermutedBlock)) + inBlock;
+    }
+    return ShiftedRadicalInverse(kPrimes[dimension % kBaseCount], index, Hash(pixel, dimension));
+}
+
+StratifiedSampler::StratifiedSampler(uint32_t samples, uint32_t seed)
+    : m_samples(std::max(samples, 1u))
+    , m_columns(std::max(static_cast<uint32_t>(std::sqrt(static_cast<double>(m_samples))), 1u))
+    , m_rows((m_samples + m_columns - 1u) / m_columns)
+    , m_seed(seed)
+{
+}
+
+float StratifiedSampler::Get(uint32_t x, uint32_t y, uint32_t sample, uint32_t dimension) const
+{
+    uint32_t const pixel = PixelSeed(x, y, m_seed);
+    float const jitter = ToUnit(Hash(Hash(pixel, dimension), sample));
+    if (sample >= m_samples)
+    {
+        return jitter;
+    }
+
+    uint32_t const stratum = Permute(sample, m_columns * m_rows, Hash(pixel, dimension / 2u));
+    return ((dimension % 2u) == 0u)
+        ? std::min((static_cast<float>(stratum % m_columns) + jitter) / m_columns, kOneMinusEpsilon)
+        : std::min((static_cast<float>(stratum / m_columns) + jitter) / m_rows, kOneMinusEpsilon);
+}
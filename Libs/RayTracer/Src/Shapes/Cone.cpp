@@ -38,7 +38,7 @@ float Cone::C(Ray const& ray) const
     return (o.X() * o.X()) - (o.Y() * o.Y()) + (o.Z() * o.Z());
 }
 
-void Cone::EarlyTest(Ray const& ray, std::vector<Intersection>& xs) const
+void Cone::EarlyTest(Ray const& ray, Hits& hits) const
 {
     Ray const normalizedRay(ray.Origin(), ray.Direction().Normalized());
     float const b = B(normalizedRay);
@@ -47,7 +47,7 @@ void Cone::EarlyTest(Ray const& ray, std::vector<Intersection>& xs) const
         float const localDistance = -C(normalizedRay) / (2.f * b);
         if (IsInRange(normalizedRay, localDistance))
         {
-            xs.push_back({ -C(ray) / (2.f * B(ray)), shared_from_this() });
+            hits.Add(-C(ray) / (2.f * B(ray)));
         }
     }
 }
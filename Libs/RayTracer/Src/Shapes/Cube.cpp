@@ -1,20 +1,87 @@
 #include "Shapes/Cube.h"
 
 #include "Ray.h"
+#include "RayPacket.h"
 #include "Shapes/ShapeFactory.h"
+#include "Util.h"
 
 REGISTER_SHAPE(Cube);
 
+namespace
+{
+
+// Same as Bounds::Intersects with the unit cube, for a single lane
+bool IntersectUnitCube(RayPacket const& packet, uint32_t lane, float& t1, float& t2)
+{
+    float tMin[3];
+    float tMax[3];
+    for (uint32_t axis = 0u; axis < 3u; axis++)
+    {
+        float const oneOverDir = 1.f / packet.Direction(axis)[lane];
+        float const a = (-1.f - packet.Origin(axis)[lane]) * oneOverDir;
+        float const b = (1.f - packet.Origin(axis)[lane]) * oneOverDir;
+        tMin[axis] = (a > b) ? b : a;
+        tMax[axis] = (a > b) ? a : b;
+    }
+    t1 = std::max(tMin[0], std::max(tMin[1], tMin[2]));
+    t2 = std::min(tMax[0], std::min(tMax[1], tMax[2]));
+    return t1 <= t2;
+}
+
+}
+
 void Cube::Intersect(Ray const& ray, std::vector<Intersection>& xs) const
 {
     float t1, t2;
     if (GetBounds().Intersects(ray, t1, t2))
     {
-        xs.push_back({ t1, shared_from_this() });
-        xs.push_back({ t2, shared_from_this() });
+        xs.push_back({ t1, this });
+        xs.push_back({ t2, this });
     }
 }
 
+bool Cube::IntersectsBefore(Ray const& ray, float distance) const
+{
+    float t1, t2;
+    return GetBounds().Intersects(ray, t1, t2)
+        && (IsOccluding(t1, distance) || IsOccluding(t2, distance));
+}
+
+bool Cube::IntersectClosest(Ray const& ray, Intersection& hit) const
+{
+    float t1, t2;
+    return GetBounds().Intersects(ray, t1, t2)
+        && (ray.UpdateClosest({ t1, this }, hit) || ray.UpdateClosest({ t2, this }, hit));
+}
+
+uint32_t Cube::IntersectsBefore(RayPacket const& packet, uint32_t mask, float const* distances) const
+{
+    uint32_t occluded = 0u;
+    ForEachLane(mask, [&](uint32_t lane) {
+        float t1, t2;
+        if (IntersectUnitCube(packet, lane, t1, t2)
+            && (IsOccluding(t1, distances[lane]) || IsOccluding(t2, distances[lane])))
+        {
+            occluded |= 1u << lane;
+        }
+    });
+    return occluded;
+}
+
+uint32_t Cube::IntersectClosest(RayPacket const& packet, uint32_t mask, Intersection* hits) const
+{
+    uint32_t found = 0u;
+    ForEachLane(mask, [&](uint32_t lane) {
+        float t1, t2;
+        if (IntersectUnitCube(packet, lane, t1, t2)
+            && (packet.UpdateClosest(lane, { t1, this }, hits[lane]) || packet.UpdateClosest(lane, { t2, this }, hits[lane])))
+        {
+            found |= 1u << lane;
+        }
+    });
+    return found;
+}
+
 Tuple Cube::NormalAtLocal(Tuple const& point) const
 {
     auto const absX = std::abs(point.X());
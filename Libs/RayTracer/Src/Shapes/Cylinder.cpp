@@ -2,7 +2,7 @@
 
 #include "Ray.h"
 #include "Shapes/ShapeFactory.h"
-
+#include "Util.h"
 
 #include <numeric>
 #include <utility>
@@ -64,21 +64,57 @@ void Cylinder::UpdateBounds()
 }
 
 void Cylinder::Intersect(Ray const& ray, std::vector<Intersection>& xs) const
+{
+    Hits hits;
+    IntersectLocal(ray, hits);
+    for (uint32_t i = 0u; i < hits.m_count; i++)
+    {
+        xs.push_back({ hits.m_t[i], this });
+    }
+}
+
+bool Cylinder::IntersectsBefore(Ray const& ray, float distance) const
+{
+    Hits hits;
+    IntersectLocal(ray, hits);
+    for (uint32_t i = 0u; i < hits.m_count; i++)
+    {
+        if (IsOccluding(hits.m_t[i], distance))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Cylinder::IntersectClosest(Ray const& ray, Intersection& hit) const
+{
+    Hits hits;
+    IntersectLocal(ray, hits);
+    bool found = false;
+    for (uint32_t i = 0u; i < hits.m_count; i++)
+    {
+        found |= ray.UpdateClosest({ hits.m_t[i], this }, hit);
+    }
+    return found;
+}
+
+void Cylinder::IntersectLocal(Ray const& ray, Hits& hits) const
 {
     Ray r(ray.Origin(), ray.Direction().Normalized());
     if (std::abs(A(r)) < EPSILON)
     {
-        EarlyTest(ray, xs);
+        EarlyTest(ray, hits);
     }
     else
     {
         float t1, t2;
         if (!SolveQuadratic(A(ray), B(ray), C(ray), t1, t2)) return;
 
-        if (IsInRange(ray, t1)) xs.push_back({ t1, shared_from_this() });
-        if (IsInRange(ray, t2)) xs.push_back({ t2, shared_from_this() });
+        if (IsInRange(ray, t1)) hits.Add(t1);
+        if (IsInRange(ray, t2)) hits.Add(t2);
     }
-    IntersectCaps(ray, xs);
+    IntersectCaps(ray, hits);
 }
 
 Tuple Cylinder::NormalAtLocal(Tuple const& point) const
@@ -100,7 +136,7 @@ Tuple Cylinder::NormalAtLocal(Tuple const& point) const
     return Vector(point.X(), y, point.Z());
 }
 
-void Cylinder::IntersectCaps(Ray const& ray, std::vector<Intersection>& xs) const
+void Cylinder::IntersectCaps(Ray const& ray, Hits& hits) const
 {
     if (!m_closed || (std::abs(ray.Direction().Y()) < EPSILON))
     {
@@ -110,13 +146,13 @@ void Cylinder::IntersectCaps(Ray const& ray, std::vector<Intersection>& xs) cons
     auto t = (m_min - ray.Origin().Y()) / ray.Direction().Y();
     if (CheckCap(ray, t, RadiusAt(m_min)))
     {
-        xs.push_back({ t, shared_from_this() });
+        hits.Add(t);
     }
 
     t = (m_max - ray.Origin().Y()) / ray.Direction().Y();
     if (CheckCap(ray, t, RadiusAt(m_max)))
     {
-        xs.push_back({ t, shared_from_this() });
+        hits.Add(t);
     }
 }
 
@@ -11,6 +11,7 @@ namespace
 constexpr static char const* json_key_children = "children";
 constexpr static char const* json_key_type = "type";
 constexpr static char const* json_key_archetype = "archetype";
+constexpr static char const* json_key_subdivide = "subdivide";
 
 }
 
@@ -37,6 +38,12 @@ void Group::Initialize(json const& data, json const& dataOverride, ArchetypeMap
             AddChild(instance);
         }
     }
+
+    uint32_t threshold = 0u;
+    if (GetProperty(json_key_subdivide, data, dataOverride, threshold) && (threshold > 0u))
+    {
+        Divide(threshold);
+    }
 }
 
 void Group::Intersect(Ray const& ray, std::vector<Intersection>& xs) const
@@ -51,6 +58,40 @@ void Group::Intersect(Ray const& ray, std::vector<Intersection>& xs) const
     }
 }
 
+bool Group::IntersectsBefore(Ray const& ray, float distance) const
+{
+    float t1, t2;
+    if (!GetBounds().Intersects(ray, t1, t2) || (t2 < EPSILON) || (t1 >= distance))
+    {
+        return false;
+    }
+
+    for (auto const& child : m_children)
+    {
+        if (ray.IntersectsBefore(child, distance))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Group::IntersectClosest(Ray const& ray, Intersection& hit) const
+{
+    float t1, t2;
+    if (!GetBounds().Intersects(ray, t1, t2) || (t2 < 0.f) || (t1 >= ray.TMax()))
+    {
+        return false;
+    }
+
+    bool found = false;
+    for (auto const& child : m_children)
+    {
+        found |= ray.IntersectClosest(child, hit);
+    }
+    return found;
+}
+
 Tuple Group::NormalAtLocal(Tuple const& point) const
 {
     throw std::runtime_error("Groups don't have normal by themselves. NormalAtLocal must be called directly on contained shapes.");
@@ -68,6 +109,96 @@ bool Group::Includes(ShapePtr child) const
     return std::find(m_children.begin(), m_children.end(), child) != m_children.end();
 }
 
+void Group::Divide(uint32_t threshold)
+{
+    if (threshold <= m_children.size())
+    {
+        auto const [left, right] = PartitionChildren();
+        if (!left.empty())
+        {
+            MakeSubgroup(left);
+        }
+        if (!right.empty())
+        {
+            MakeSubgroup(right);
+        }
+    }
+
+    for (auto const& child : m_children)
+    {
+        child->Divide(threshold);
+    }
+}
+
+std::pair<std::vector<ShapePtr>, std::vector<ShapePtr>> Group::PartitionChildren()
+{
+    // Children with infinite extents can't be placed in either half, and
+    // would make the split meaningless, so only finite bounds are considered
+    Bounds finiteBounds = Bounds::Empty();
+    for (auto const& child : m_children)
+    {
+        auto const childBounds = child->Transform() * child->GetBounds();
+        if (childBounds.IsFinite())
+        {
+            finiteBounds.Merge(childBounds);
+        }
+    }
+
+    std::vector<ShapePtr> left;
+    std::vector<ShapePtr> right;
+    if (!finiteBounds.IsFinite())
+    {
+        return { left, right };
+    }
+
+    auto const [leftBounds, rightBounds] = finiteBounds.Split();
+    std::vector<ShapePtr> remaining;
+    for (auto const& child : m_children)
+    {
+        auto const childBounds = child->Transform() * child->GetBounds();
+        if (!childBounds.IsFinite())
+        {
+            remaining.push_back(child);
+        }
+        else if (leftBounds.Contains(childBounds))
+        {
+            left.push_back(child);
+        }
+        else if (rightBounds.Contains(childBounds))
+        {
+            right.push_back(child);
+        }
+        else
+        {
+            remaining.push_back(child);
+        }
+    }
+
+    // Moving every child into a single subgroup only adds a level to the
+    // hierarchy, and would never end for children sharing the same bounds
+    if ((left.size() == m_children.size()) || (right.size() == m_children.size()))
+    {
+        return {};
+    }
+
+    m_children = std::move(remaining);
+    return { left, right };
+}
+
+void Group::MakeSubgroup(std::vector<ShapePtr> const& children)
+{
+    auto subgroup = std::make_shared<Group>();
+    for (auto const& child : children)
+    {
+        subgroup->AddChild(child);
+    }
+
+    // Lets shadow rays skip the whole subgroup when none of its children cast shadows
+    subgroup->CastShadows(std::any_of(children.begin(), children.end(),
+        [](ShapePtr const& child) { return child->CastShadows(); }));
+    AddChild(subgroup);
+}
+
 void Group::UpdateBounds(ShapePtr child)
 {
     auto childBounds = child->Transform() * child->GetBounds();
@@ -84,4 +215,19 @@ void Group::UpdateBounds()
     {
         UpdateBounds(child);
     }
+
+    // Nested groups have to be refreshed all the way up
+    if (auto parent = Parent())
+    {
+        std::static_pointer_cast<Group>(parent)->UpdateBounds();
+    }
+}
+
+void Group::UpdateWorldTransform()
+{
+    Shape::UpdateWorldTransform();
+    for (auto const& child : m_children)
+    {
+        child->UpdateWorldTransform();
+    }
 }
@@ -0,0 +1,117 @@
+#include "Shapes/Instance.h"
+
+#include "Ray.h"
+#include "Shapes/Group.h"
+
+#include <stdexcept>
+
+namespace
+{
+
+constexpr static char const* json_key_type = "type";
+constexpr static char const* json_key_material = "material";
+
+// Properties an archetype reference may override and still be instanced
+constexpr static char const* s_instanceKeys[] = {
+    "archetype", "name", "position", "rotation", "scaling", "material", "cast_shadows" };
+
+}
+
+Instance::Instance(InstancePrototypeConstPtr const& prototype)
+    : m_prototype(prototype)
+    , m_overridesMaterial(false)
+{
+    auto& bounds = ModifyBounds();
+    if (m_prototype->m_bvh.UnboundedCount() > 0)
+    {
+        bounds.Min(Point(-INF, -INF, -INF));
+        bounds.Max(Point(INF, INF, INF));
+    }
+    else
+    {
+        bounds = m_prototype->m_bvh.GetBounds();
+    }
+}
+
+void Instance::Initialize(json const& data, json const& dataOverride, ArchetypeMap const& archetypes)
+{
+    Shape::Initialize(data, dataOverride, archetypes);
+    m_overridesMaterial = dataOverride.contains(json_key_material);
+}
+
+void Instance::Intersect(Ray const& ray, std::vector<Intersection>& xs) const
+{
+    auto const first = xs.size();
+    m_prototype->m_bvh.Intersect(ray, xs);
+
+    for (auto i = first; i < xs.size(); i++)
+    {
+        xs[i].SetInstance(this);
+    }
+}
+
+bool Instance::IntersectsBefore(Ray const& ray, float distance) const
+{
+    return m_prototype->m_bvh.IntersectsBefore(ray, distance);
+}
+
+bool Instance::IntersectClosest(Ray const& ray, Intersection& hit) const
+{
+    if (!m_prototype->m_bvh.IntersectClosest(ray, hit))
+    {
+        return false;
+    }
+    hit.SetInstance(this);
+    return true;
+}
+
+Tuple Instance::NormalAtLocal(Tuple const& /*point*/) const
+{
+    throw std::runtime_error("Instances don't have normal by themselves. PrototypeNormalAt must be used instead.");
+}
+
+Tuple Instance::PrototypeNormalAt(Shape const* object, Tuple const& point) const
+{
+    auto const prototypeNormal = object->NormalAt(WorldToLocal(point));
+    return NormalToWorld(prototypeNormal);
+}
+
+// static
+InstancePrototypeConstPtr Instance::Compile(ShapePtr const& root)
+{
+    auto prototype = std::make_shared<InstancePrototype>();
+    prototype->m_root = root;
+    root->SetTransform(Mat44::Identity());
+
+    if (auto group = std::dynamic_pointer_cast<Group>(root))
+    {
+        prototype->m_bvh.Build(group->Children());
+    }
+    else
+    {
+        prototype->m_bvh.Build({ root });
+    }
+
+    return prototype;
+}
+
+// static
+bool Instance::CanInstance(json const& archetypeTemplate, json const& reference)
+{
+    if (!archetypeTemplate.contains(json_key_type))
+    {
+        return false;
+    }
+
+    for (auto const& item : reference.items())
+    {
+        auto const& key = item.key();
+        auto const isInstanceKey = std::find_if(std::begin(s_instanceKeys), std::end(s_instanceKeys),
+            [&key](char const* k) { return key == k; }) != std::end(s_instanceKeys);
+        if (!isInstanceKey)
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -1,6 +1,7 @@
 #include "Shapes/Plane.h"
 
 #include "Ray.h"
+#include "RayPacket.h"
 #include "Shapes/ShapeFactory.h"
 #include "Util.h"
 
@@ -25,5 +26,46 @@ void Plane::Intersect(Ray const& ray, std::vector<Intersection>& xs) const
     {
         return;
     }
-    xs.push_back({ (-ray.Origin().Y()) / yDirection, shared_from_this() });
+    xs.push_back({ (-ray.Origin().Y()) / yDirection, this });
+}
+
+bool Plane::IntersectsBefore(Ray const& ray, float distance) const
+{
+    float const yDirection = ray.Direction().Y();
+    return (std::abs(yDirection) >= EPSILON)
+        && IsOccluding((-ray.Origin().Y()) / yDirection, distance);
+}
+
+bool Plane::IntersectClosest(Ray const& ray, Intersection& hit) const
+{
+    float const yDirection = ray.Direction().Y();
+    return (std::abs(yDirection) >= EPSILON)
+        && ray.UpdateClosest({ (-ray.Origin().Y()) / yDirection, this }, hit);
+}
+
+uint32_t Plane::IntersectsBefore(RayPacket const& packet, uint32_t mask, float const* distances) const
+{
+    uint32_t occluded = 0u;
+    ForEachLane(mask, [&](uint32_t lane) {
+        float const yDirection = packet.Direction(1)[lane];
+        if ((std::abs(yDirection) >= EPSILON) && IsOccluding((-packet.Origin(1)[lane]) / yDirection, distances[lane]))
+        {
+            occluded |= 1u << lane;
+        }
+    });
+    return occluded;
+}
+
+uint32_t Plane::IntersectClosest(RayPacket const& packet, uint32_t mask, Intersection* hits) const
+{
+    uint32_t found = 0u;
+    ForEachLane(mask, [&](uint32_t lane) {
+        float const yDirection = packet.Direction(1)[lane];
+        if ((std::abs(yDirection) >= EPSILON)
+            && packet.UpdateClosest(lane, { (-packet.Origin(1)[lane]) / yDirection, this }, hits[lane]))
+        {
+            found |= 1u << lane;
+        }
+    });
+    return found;
 }
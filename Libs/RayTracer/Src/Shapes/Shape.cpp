@@ -1,5 +1,8 @@
 #include "Shapes/Shape.h"
+#include "Ray.h"
+#include "RayPacket.h"
 #include "Transformations.h"
+#include "Util.h"
 
 namespace
 {
@@ -15,8 +18,10 @@ constexpr static char const* json_key_cast_shadows = "cast_shadows";
 
 Shape::Shape()
     : m_name("<unnamed>")
-    , m_transform(Mat44::Identity())
-    , m_invTransform(Mat44::Identity())
+    , m_transform()
+    , m_invTransform()
+    , m_worldToObject()
+    , m_normalToWorld()
     , m_material()
     , m_castShadows(true)
     , m_parent()
@@ -63,12 +68,12 @@ bool Shape::operator==(Shape const& other) const
 
 bool Shape::IntersectsBefore(Ray const& ray, float distance) const
 {
-    std::vector<Intersection> xs;
-    xs.reserve(2);
+    auto lease = IntersectionArena::Acquire();
+    auto& xs = lease.List();
     Intersect(ray, xs);
     for (auto const& i : xs)
     {
-        if ((i.Distance() >= EPSILON) && (i.Distance() < distance))
+        if (IsOccluding(i.Distance(), distance))
         {
             return true;
         }
@@ -76,30 +81,71 @@ bool Shape::IntersectsBefore(Ray const& ray, float distance) const
     return false;
 }
 
+bool Shape::IntersectClosest(Ray const& ray, Intersection& hit) const
+{
+    auto lease = IntersectionArena::Acquire();
+    auto& xs = lease.List();
+    Intersect(ray, xs);
+    bool found = false;
+    for (auto const& i : xs)
+    {
+        found |= ray.UpdateClosest(i, hit);
+    }
+    return found;
+}
+
+uint32_t Shape::IntersectsBefore(RayPacket const& packet, uint32_t mask, float const* distances) const
+{
+    uint32_t occluded = 0u;
+    ForEachLane(mask, [&](uint32_t lane) {
+        occluded |= IntersectsBefore(packet.At(lane), distances[lane]) ? (1u << lane) : 0u;
+    });
+    return occluded;
+}
+
+uint32_t Shape::IntersectClosest(RayPacket const& packet, uint32_t mask, Intersection* hits) const
+{
+    uint32_t found = 0u;
+    ForEachLane(mask, [&](uint32_t lane) {
+        Ray const ray = packet.At(lane);
+        if (IntersectClosest(ray, hits[lane]))
+        {
+            packet.TMax(lane, ray.TMax());
+            found |= 1u << lane;
+        }
+    });
+    return found;
+}
+
 Tuple Shape::WorldToLocal(Tuple const& point) const
 {
-    auto localPnt = (m_parent != nullptr) ? m_parent->WorldToLocal(point) : point;
-    return m_invTransform * localPnt;
+    return m_worldToObject * point;
 }
 
 Tuple Shape::NormalToWorld(Tuple const& normal) const
 {
-    auto nParent = m_invTransform.Transposed() * normal;
-    nParent[3] = 0.f;
-    nParent.Normalize();
-    return (m_parent != nullptr) ? m_parent->NormalToWorld(nParent) : nParent;
+    auto n = m_normalToWorld * normal;
+    n[3] = 0.f;
+    return n.Normalized();
 }
 
 void Shape::SetTransform(Mat44 const& t)
 {
-    m_transform = t;
-    m_invTransform = t.Inverse();
+    m_transform = AffineTransform(t);
+    m_invTransform = m_transform.Inverse();
+    UpdateWorldTransform();
     if (m_parent != nullptr)
     {
         m_parent->UpdateBounds();
     }
 }
 
+void Shape::UpdateWorldTransform()
+{
+    m_worldToObject = (m_parent != nullptr) ? (m_invTransform * m_parent->m_worldToObject) : m_invTransform;
+    m_normalToWorld = m_worldToObject.NormalMatrix();
+}
+
 void Shape::UpdateBounds()
 {
     throw std::runtime_error("A concrete shape cannot be set as a parent of other shape. Only groups are allowed!");
@@ -2,6 +2,8 @@
 #include "Shapes/ShapeFactory.h"
 
 #include "Ray.h"
+#include "RayPacket.h"
+#include "Util.h"
 
 REGISTER_SHAPE(Sphere);
 
@@ -10,7 +12,10 @@ Tuple Sphere::NormalAtLocal(Tuple const& localPoint) const
     return { localPoint.X(), localPoint.Y(), localPoint.Z(), 0.f };
 }
 
-void Sphere::Intersect(Ray const& ray, std::vector<Intersection>& xs) const
+namespace
+{
+
+bool IntersectUnitSphere(Ray const& ray, float& t1, float& t2)
 {
     auto const& rayDir = ray.Direction();
     auto sphereToRay = ray.Origin();
@@ -18,12 +23,70 @@ void Sphere::Intersect(Ray const& ray, std::vector<Intersection>& xs) const
     float const a = rayDir.Dot(rayDir);
     float const b = 2.f * rayDir.Dot(sphereToRay);
     float const c = sphereToRay.Dot(sphereToRay) - 1.f;
+    return SolveQuadratic(a, b, c, t1, t2);
+}
+
+bool IntersectUnitSphere(RayPacket const& packet, uint32_t lane, float& t1, float& t2)
+{
+    float const dx = packet.Direction(0)[lane], dy = packet.Direction(1)[lane], dz = packet.Direction(2)[lane];
+    float const ox = packet.Origin(0)[lane], oy = packet.Origin(1)[lane], oz = packet.Origin(2)[lane];
+    float const a = (dx * dx) + (dy * dy) + (dz * dz);
+    float const b = 2.f * ((dx * ox) + (dy * oy) + (dz * oz));
+    float const c = (ox * ox) + (oy * oy) + (oz * oz) - 1.f;
+    return SolveQuadratic(a, b, c, t1, t2);
+}
 
+}
+
+void Sphere::Intersect(Ray const& ray, std::vector<Intersection>& xs) const
+{
     float t1, t2;
-    if (!SolveQuadratic(a, b, c, t1, t2)) return;
+    if (!IntersectUnitSphere(ray, t1, t2)) return;
+
+    xs.push_back({ t1, this });
+    xs.push_back({ t2, this });
+}
 
-    xs.push_back({ t1, shared_from_this() });
-    xs.push_back({ t2, shared_from_this() });
+bool Sphere::IntersectsBefore(Ray const& ray, float distance) const
+{
+    float t1, t2;
+    return IntersectUnitSphere(ray, t1, t2)
+        && (IsOccluding(t1, distance) || IsOccluding(t2, distance));
+}
+
+bool Sphere::IntersectClosest(Ray const& ray, Intersection& hit) const
+{
+    float t1, t2;
+    return IntersectUnitSphere(ray, t1, t2)
+        && (ray.UpdateClosest({ t1, this }, hit) || ray.UpdateClosest({ t2, this }, hit));
+}
+
+uint32_t Sphere::IntersectsBefore(RayPacket const& packet, uint32_t mask, float const* distances) const
+{
+    uint32_t occluded = 0u;
+    ForEachLane(mask, [&](uint32_t lane) {
+        float t1, t2;
+        if (IntersectUnitSphere(packet, lane, t1, t2)
+            && (IsOccluding(t1, distances[lane]) || IsOccluding(t2, distances[lane])))
+        {
+            occluded |= 1u << lane;
+        }
+    });
+    return occluded;
+}
+
+uint32_t Sphere::IntersectClosest(RayPacket const& packet, uint32_t mask, Intersection* hits) const
+{
+    uint32_t found = 0u;
+    ForEachLane(mask, [&](uint32_t lane) {
+        float t1, t2;
+        if (IntersectUnitSphere(packet, lane, t1, t2)
+            && (packet.UpdateClosest(lane, { t1, this }, hits[lane]) || packet.UpdateClosest(lane, { t2, this }, hits[lane])))
+        {
+            found |= 1u << lane;
+        }
+    });
+    return found;
 }
 
 bool Sphere::operator==(Shape const& other) const
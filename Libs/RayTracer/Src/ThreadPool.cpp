@@ -0,0 +1,198 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double Seconds(Clock::duration d)
+    {
+        return std::chrono::duration_cast<std::chrono::duration<double>>(d).count();
+    }
+}
+
+ThreadPool::ThreadPool(uint32_t workerCount)
+{
+    if (workerCount == 0u)
+    {
+        workerCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    m_queues.reset(new Queue[workerCount]);
+    m_stats.resize(workerCount);
+    m_threads.reserve(workerCount);
+    for (uint32_t worker = 0u; worker < workerCount; worker++)
+    {
+        m_threads.emplace_back(&ThreadPool::Work, this, worker);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+// static
+ThreadPool& ThreadPool::Shared(uint32_t workerCount)
+{
+    static std::mutex s_mutex;
+    static std::map<uint32_t, std::unique_ptr<ThreadPool>> s_pools;
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    auto& pool = s_pools[workerCount];
+    if (pool == nullptr)
+    {
+        pool = std::make_unique<ThreadPool>(workerCount);
+    }
+    return *pool;
+}
+
+void ThreadPool::ParallelFor(uint32_t count, Task const& task, std::vector<WorkerStats>* stats)
+{
+    std::lock_guard<std::mutex> run(m_runMutex);
+
+    auto const workerCount = WorkerCount();
+    auto const start = Clock::now();
+    {
+        // Published to the workers along with the new generation
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (uint32_t worker = 0u; worker < workerCount; worker++)
+        {
+            m_queues[worker].m_begin = static_cast<uint32_t>((uint64_t(count) * worker) / workerCount);
+            m_queues[worker].m_end = static_cast<uint32_t>((uint64_t(count) * (worker + 1u)) / workerCount);
+            m_stats[worker] = WorkerStats();
+        }
+        m_task = &task;
+        m_exception = nullptr;
+        m_cancelled = false;
+        m_running = workerCount;
+        m_generation++;
+    }
+    m_wake.notify_all();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_running == 0u; });
+    double const seconds = Seconds(Clock::now() - start);
+    m_task = nullptr;
+
+    if (stats != nullptr)
+    {
+        *stats = m_stats;
+        for (auto& s : *stats)
+        {
+            s.m_idleSeconds = std::max(seconds - s.m_busySeconds, 0.);
+        }
+    }
+
+    if (m_exception != nullptr)
+    {
+        std::rethrow_exception(m_exception);
+    }
+}
+
+void ThreadPool::Work(uint32_t worker)
+{
+    uint64_t generation = 0u;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&]() { return m_stop || (m_generation != generation); });
+            if (m_stop)
+            {
+                return;
+            }
+            generation = m_generation;
+        }
+
+        RunTasks(worker);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_running == 0u)
+        {
+            m_done.notify_all();
+        }
+    }
+}
+
+void ThreadPool::RunTasks(uint32_t worker)
+{
+    // Only this worker writes its stats until the batch is done
+    auto& stats = m_stats[worker];
+    uint32_t index = 0u;
+    while (!m_cancelled.load(std::memory_order_relaxed) && (Pop(worker, index) || Steal(worker, index)))
+    {
+        auto const start = Clock::now();
+        try
+        {
+            (*m_task)(index, worker);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_exception == nullptr)
+            {
+                m_exception = std::current_exception();
+            }
+        }
+        stats.m_busySeconds += Seconds(Clock::now() - start);
+        stats.m_tasks++;
+    }
+}
+
+bool ThreadPool::Pop(uint32_t worker, uint32_t& index)
+{
+    auto& queue = m_queues[worker];
+    std::lock_guard<std::mutex> lock(queue.m_mutex);
+    if (queue.m_begin == queue.m_end)
+    {
+        return false;
+    }
+    index = queue.m_begin++;
+    return true;
+}
+
+bool ThreadPool::Steal(uint32_t worker, uint32_t& index)
+{
+    auto const workerCount = WorkerCount();
+    for (uint32_t i = 1u; i < workerCount; i++)
+    {
+        auto& victim = m_queues[(worker + i) % workerCount];
+        uint32_t begin = 0u;
+        uint32_t end = 0u;
+        {
+            std::lock_guard<std::mutex> lock(victim.m_mutex);
+            uint32_t const half = (victim.m_end - victim.m_begin + 1u) / 2u;
+            if (half == 0u)
+            {
+                continue;
+            }
+            end = victim.m_end;
+            begin = end - half;
+            victim.m_end = begin;
+        }
+
+        // The own queue is empty, nobody can steal from it meanwhile
+        auto& queue = m_queues[worker];
+        {
+            std::lock_guard<std::mutex> lock(queue.m_mutex);
+            queue.m_begin = begin + 1u;
+            queue.m_end = end;
+        }
+        m_stats[worker].m_steals++;
+        index = begin;
+        return true;
+    }
+    return false;
+}
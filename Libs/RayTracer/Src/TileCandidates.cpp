@@ -0,0 +1,137 @@
+#include "TileCandidates.h"
+
+#include "LinearBvh.h"
+#include "Ray.h"
+#include "RayPacket.h"
+#include "Shapes/Shape.h"
+
+#include <stdexcept>
+
+TileCandidates::TileCandidates()
+{
+    // Linear bvhs never keep more, so the first tile allocates for the others
+    m_subtrees.reserve(LinearBvh::kMaxCandidates);
+}
+
+void TileCandidates::Clear()
+{
+    m_fallback = nullptr;
+    m_bvh = nullptr;
+    m_objects.clear();
+    m_subtrees.clear();
+}
+
+void TileCandidates::Add(LinearBvh const& bvh, uint32_t nodeIdx)
+{
+    if ((m_bvh != nullptr) && (m_bvh != &bvh))
+    {
+        throw std::runtime_error("Tile candidates can't reference more than one bvh!");
+    }
+    m_bvh = &bvh;
+    m_subtrees.push_back(nodeIdx);
+}
+
+void TileCandidates::SetFallback(IAccelerator const* accelerator)
+{
+    Clear();
+    m_fallback = accelerator;
+}
+
+void TileCandidates::Intersect(Ray const& ray, std::vector<Intersection>& xs) const
+{
+    if (m_fallback != nullptr)
+    {
+        m_fallback->Intersect(ray, xs);
+        return;
+    }
+
+    for (auto const& obj : m_objects)
+    {
+        ray.Intersect(obj, xs);
+    }
+    for (uint32_t nodeIdx : m_subtrees)
+    {
+        m_bvh->Intersect(ray, xs, nodeIdx);
+    }
+}
+
+bool TileCandidates::IntersectClosest(Ray const& ray, Intersection& hit) const
+{
+    if (m_fallback != nullptr)
+    {
+        return m_fallback->IntersectClosest(ray, hit);
+    }
+
+    bool found = false;
+    for (auto const& obj : m_objects)
+    {
+        found |= ray.IntersectClosest(obj, hit);
+    }
+    for (uint32_t nodeIdx : m_subtrees)
+    {
+        found |= m_bvh->IntersectClosest(ray, hit, nodeIdx);
+    }
+    return found;
+}
+
+ShapePtr const* TileCandidates::FindOccluder(Ray const& ray, float distance) const
+{
+    if (m_fallback != nullptr)
+    {
+        return m_fallback->FindOccluder(ray, distance);
+    }
+
+    for (auto const& obj : m_objects)
+    {
+        if (ray.IntersectsBefore(obj, distance))
+        {
+            return &obj;
+        }
+    }
+    for (uint32_t nodeIdx : m_subtrees)
+    {
+        if (auto const* occluder = m_bvh->FindOccluder(ray, distance, nodeIdx))
+        {
+            return occluder;
+        }
+    }
+    return nullptr;
+}
+
+uint32_t TileCandidates::IntersectClosest(RayPacket const& packet, uint32_t mask, Intersection* hits) const
+{
+    if (m_fallback != nullptr)
+    {
+        return m_fallback->IntersectClosest(packet, mask, hits);
+    }
+
+    uint32_t found = 0u;
+    for (auto const& obj : m_objects)
+    {
+        found |= packet.IntersectClosest(obj, mask, hits);
+    }
+    for (uint32_t nodeIdx : m_subtrees)
+    {
+        found |= m_bvh->IntersectClosest(packet, mask, hits, nodeIdx);
+    }
+    return found;
+}
+
+uint32_t TileCandidates::FindOccluders(RayPacket const& packet, uint32_t mask, float const* distances) const
+{
+    if (m_fallback != nullptr)
+    {
+        return m_fallback->FindOccluders(packet, mask, distances);
+    }
+
+    uint32_t occluded = 0u;
+    for (auto const& obj : m_objects)
+    {
+        occluded |= packet.IntersectsBefore(obj, mask & ~occluded, distances);
+    }
+    for (uint32_t nodeIdx : m_subtrees)
+    {
+        occluded |= m_bvh->FindOccluders(packet, mask & ~occluded, distances, nodeIdx);
+    }
+    return occluded;
+}
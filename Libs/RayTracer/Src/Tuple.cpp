@@ -88,41 +88,31 @@ bool Tuple::IsVector() const
 
 float Tuple::Length() const
 {
-    return std::sqrtf((m_x * m_x) + (m_y * m_y) + (m_z * m_z) + (m_w * m_w));
+    return std::sqrtf(Dot(*this));
 }
 
 void Tuple::Normalize()
 {
-    float const oneOverLength = 1.f / Length();
-    m_x *= oneOverLength;
-    m_y *= oneOverLength;
-    m_z *= oneOverLength;
-    m_w *= oneOverLength;
+    math::active::Normalize(Data(), Data());
 }
 
 Tuple Tuple::Normalized() const
 {
-    float const oneOverLength = 1.f / Length();
-    return {
-        m_x * oneOverLength,
-        m_y * oneOverLength,
-        m_z * oneOverLength,
-        m_w * oneOverLength
-    };
+    Tuple r;
+    math::active::Normalize(Data(), r.Data());
+    return r;
 }
 
 float Tuple::Dot(Tuple const& other) const
 {
-    return (X() * other.X()) + (Y() * other.Y()) + (Z() * other.Z()) + (W() * other.W());
+    return math::active::Dot(Data(), other.Data());
 }
 
 Tuple Tuple::Cross(Tuple const& other) const
 {
-    return Vector(
-        m_y * other[2] - m_z * other[1],
-        m_z * other[0] - m_x * other[2],
-        m_x * other[1] - m_y * other[0]
-    );
+    Tuple r;
+    math::active::Cross(Data(), other.Data(), r.Data());
+    return r;
 }
 
 Tuple Tuple::Reflect(Tuple const& other) const
@@ -0,0 +1,425 @@
+#include "WideBvh.h"
+
+#include "MathIntrinsics.h"
+#include "Ray.h"
+#include "Shapes/Shape.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef USE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+
+constexpr float kMaxQuantized = 255.f;
+
+// 2^exponent, built from its bits so SSE and scalar code agree
+float Step(int8_t exponent)
+{
+    uint32_t const bits = static_cast<uint32_t>(exponent + 127) << 23u;
+    float step;
+    std::memcpy(&step, &bits, sizeof(step));
+    return step;
+}
+
+float Dequantize(float origin, float step, uint8_t q)
+{
+    return origin + (static_cast<float>(q) * step);
+}
+
+#ifdef USE_SSE
+// Four consecutive quantized values
+__m128 Dequantize(__m128 origin, __m128 step, uint8_t const* q)
+{
+    int32_t bytes;
+    std::memcpy(&bytes, q, sizeof(bytes));
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const words = _mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero);
+    __m128 const values = _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+    return _mm_add_ps(origin, _mm_mul_ps(values, step));
+}
+#endif
+
+// Ray data needed by the slab test, computed once per query
+struct TraversalRay
+{
+    explicit TraversalRay(Ray const& ray)
+    {
+        for (size_t axis = 0; axis < 3; axis++)
+        {
+            m_origin[axis] = ray.Origin()[axis];
+            m_invDir[axis] = 1.f / ray.Direction()[axis];
+        }
+    }
+
+    float m_origin[3];
+    float m_invDir[3];
+};
+
+}
+
+template<uint32_t kWidth>
+WideBvh<kWidth>::WideBvh()
+{
+}
+
+template<uint32_t kWidth>
+WideBvh<kWidth>::WideBvh(Bvh const& bvh)
+{
+    Build(bvh);
+}
+
+template<uint32_t kWidth>
+void WideBvh<kWidth>::Build(Bvh const& bvh)
+{
+    m_nodes.clear();
+    m_leaves.clear();
+    m_objects = bvh.m_objects;
+    m_unbounded = bvh.m_unbounded;
+    m_sources.clear();
+    m_childSources.clear();
+    m_parents.clear();
+    m_leafParents.assign(bvh.m_nodes.size(), kNone);
+    m_bounds = bvh.GetBounds();
+
+    if (!bvh.m_nodes.empty())
+    {
+        Collapse(bvh, 0u, kNone);
+    }
+}
+
+template<uint32_t kWidth>
+uint32_t WideBvh<kWidth>::Collapse(Bvh const& bvh, uint32_t srcIdx, uint32_t parent)
+{
+    // Open the interior child with the largest area until the node is full
+    std::array<uint32_t, kWidth> children;
+    uint32_t count = 0u;
+    children[count++] = srcIdx;
+    while (count < kWidth)
+    {
+        uint32_t largest = kNone;
+        float largestArea = -1.f;
+        for (uint32_t i = 0u; i < count; i++)
+        {
+            auto const& child = bvh.m_nodes[children[i]];
+            if (!child.IsLeaf() && (child.m_bounds.SurfaceArea() > largestArea))
+            {
+                largest = i;
+                largestArea = child.m_bounds.SurfaceArea();
+            }
+        }
+        if (largest == kNone)
+        {
+            break;
+        }
+        auto const& opened = bvh.m_nodes[children[largest]];
+        children[largest] = opened.m_left;
+        children[count++] = opened.m_right;
+    }
+
+    auto const nodeIdx = static_cast<uint32_t>(m_nodes.size());
+    Node node = {};
+    node.m_childCount = static_cast<uint8_t>(count);
+    m_nodes.push_back(node);
+    m_sources.push_back(srcIdx);
+    m_parents.push_back(parent);
+    m_childSources.insert(m_childSources.end(), children.begin(), children.begin() + count);
+    m_childSources.resize(m_nodes.size() * kWidth, kNone);
+
+    for (uint32_t i = 0u; i < count; i++)
+    {
+        auto const& child = bvh.m_nodes[children[i]];
+        uint32_t ref;
+        if (child.IsLeaf())
+        {
+            ref = kLeafBit | static_cast<uint32_t>(m_leaves.size());
+            m_leaves.push_back({ child.m_first, child.m_count });
+            m_leafParents[children[i]] = nodeIdx;
+        }
+        else
+        {
+            ref = Collapse(bvh, children[i], nodeIdx);
+        }
+        // Recursion grows m_nodes, don't keep a reference across it
+        m_nodes[nodeIdx].m_children[i] = ref;
+        m_nodes[nodeIdx].m_shadowCasters |= child.m_castsShadows ? (1u << i) : 0u;
+    }
+
+    Quantize(bvh, nodeIdx);
+    return nodeIdx;
+}
+
+template<uint32_t kWidth>
+void WideBvh<kWidth>::Quantize(Bvh const& bvh, uint32_t nodeIdx)
+{
+    auto& node = m_nodes[nodeIdx];
+    auto const& bounds = bvh.m_nodes[m_sources[nodeIdx]].m_bounds;
+    for (size_t axis = 0; axis < 3; axis++)
+    {
+        float const origin = bounds.Min()[axis];
+        float const max = bounds.Max()[axis];
+
+        // Smallest power of two step covering the node in 255 steps, once
+        // rounded. Denormal steps are avoided, they only matter for tiny nodes.
+        int exponent = 0;
+        std::frexp((max - origin) / kMaxQuantized, &exponent);
+        exponent = std::max(exponent, -126);
+        while ((exponent < 127) && (Dequantize(origin, Step(static_cast<int8_t>(exponent)), 255u) < max))
+        {
+            exponent++;
+        }
+        float const step = Step(static_cast<int8_t>(exponent));
+        node.m_origin[axis] = origin;
+        node.m_exponent[axis] = static_cast<int8_t>(exponent);
+
+        for (uint32_t i = 0u; i < node.m_childCount; i++)
+        {
+            auto const& child = bvh.m_nodes[m_childSources[(nodeIdx * kWidth) + i]].m_bounds;
+            float const qMin = std::floor((child.Min()[axis] - origin) / step);
+            float const qMax = std::ceil((child.Max()[axis] - origin) / step);
+            auto lo = static_cast<uint8_t>(std::min(std::max(qMin, 0.f), kMaxQuantized));
+            auto hi = static_cast<uint8_t>(std::min(std::max(qMax, 0.f), kMaxQuantized));
+
+            // Rounding of the dequantized values must not shrink the child
+            while ((lo > 0u) && (Dequantize(origin, step, lo) > child.Min()[axis]))
+            {
+                lo--;
+            }
+            while ((hi < 255u) && (Dequantize(origin, step, hi) < child.Max()[axis]))
+            {
+                hi++;
+            }
+            node.m_qMin[axis][i] = lo;
+            node.m_qMax[axis][i] = hi;
+        }
+    }
+}
+
+template<uint32_t kWidth>
+void WideBvh<kWidth>::Refit(Bvh const& bvh, std::vector<ShapePtr> const& shapes)
+{
+    if (bvh.m_nodes.size() != m_leafParents.size())
+    {
+        throw std::runtime_error("A wide bvh can only be refitted from the bvh it was built from!");
+    }
+
+    for (auto const& shape : shapes)
+    {
+        auto const it = bvh.m_objectLeaves.find(shape.get());
+        for (uint32_t nodeIdx = (it != bvh.m_objectLeaves.end()) ? m_leafParents[it->second] : kNone;
+             nodeIdx != kNone;
+             nodeIdx = m_parents[nodeIdx])
+        {
+            Quantize(bvh, nodeIdx);
+        }
+    }
+    m_bounds = bvh.GetBounds();
+}
+
+template<uint32_t kWidth>
+uint32_t WideBvh<kWidth>::IntersectChildren(Node const& node, float const* origin, float const* invDir, float tMin, float tMax, float* tNear)
+{
+    uint32_t hits = 0u;
+#ifdef USE_SSE
+    __m128 steps[3];
+    for (uint32_t axis = 0u; axis < 3u; axis++)
+    {
+        steps[axis] = _mm_set1_ps(Step(node.m_exponent[axis]));
+    }
+    for (uint32_t first = 0u; first < kWidth; first += 4u)
+    {
+        __m128 lo = _mm_set1_ps(tMin);
+        __m128 hi = _mm_set1_ps(tMax);
+        for (uint32_t axis = 0u; axis < 3u; axis++)
+        {
+            __m128 const nodeOrigin = _mm_set1_ps(node.m_origin[axis]);
+            math::sse::Slab(
+                Dequantize(nodeOrigin, steps[axis], node.m_qMin[axis] + first),
+                Dequantize(nodeOrigin, steps[axis], node.m_qMax[axis] + first),
+                _mm_set1_ps(origin[axis]), _mm_set1_ps(invDir[axis]), lo, hi);
+        }
+        _mm_storeu_ps(tNear + first, lo);
+        hits |= math::sse::SlabHits(lo, hi) << first;
+    }
+#else
+    for (uint32_t i = 0u; i < kWidth; i++)
+    {
+        float lo = tMin;
+        float hi = tMax;
+        for (uint32_t axis = 0u; axis < 3u; axis++)
+        {
+            float const step = Step(node.m_exponent[axis]);
+            math::scalar::Slab(
+                Dequantize(node.m_origin[axis], step, node.m_qMin[axis][i]),
+                Dequantize(node.m_origin[axis], step, node.m_qMax[axis][i]),
+                origin[axis], invDir[axis], lo, hi);
+        }
+        tNear[i] = lo;
+        hits |= (lo <= hi) ? (1u << i) : 0u;
+    }
+#endif
+    // Unused slots hold empty bounds, which rays may still cross
+    return hits & ((1u << node.m_childCount) - 1u);
+}
+
+template<uint32_t kWidth>
+void WideBvh<kWidth>::Intersect(Ray const& ray, std::vector<Intersection>& xs) const
+{
+    for (auto const& obj : m_unbounded)
+    {
+        ray.Intersect(obj, xs);
+    }
+
+    if (m_nodes.empty())
+    {
+        return;
+    }
+
+    TraversalRay const tRay(ray);
+    std::array<uint32_t, Bvh::kMaxDepth * kWidth> stack;
+    uint32_t stackSize = 0u;
+    stack[stackSize++] = 0u;
+    while (stackSize > 0u)
+    {
+        uint32_t const child = stack[--stackSize];
+        if ((child & kLeafBit) != 0u)
+        {
+            auto const& leaf = m_leaves[child & ~kLeafBit];
+            for (uint32_t i = leaf.m_first; i < leaf.m_first + leaf.m_count; i++)
+            {
+                ray.Intersect(m_objects[i], xs);
+            }
+            continue;
+        }
+
+        auto const& node = m_nodes[child];
+        float tNear[kWidth];
+        uint32_t const hits = IntersectChildren(node, tRay.m_origin, tRay.m_invDir, -INF, INF, tNear);
+        for (uint32_t i = 0u; i < node.m_childCount; i++)
+        {
+            if ((hits & (1u << i)) != 0u)
+            {
+                stack[stackSize++] = node.m_children[i];
+            }
+        }
+    }
+}
+
+template<uint32_t kWidth>
+bool WideBvh<kWidth>::IntersectClosest(Ray const& ray, Intersection& hit) const
+{
+    bool found = false;
+    for (auto const& obj : m_unbounded)
+    {
+        found |= ray.IntersectClosest(obj, hit);
+    }
+
+    if (m_nodes.empty())
+    {
+        return found;
+    }
+
+    TraversalRay const tRay(ray);
+    std::array<StackEntry, Bvh::kMaxDepth * kWidth> stack;
+    uint32_t stackSize = 0u;
+    stack[stackSize++] = { 0u, 0.f };
+    while (stackSize > 0u)
+    {
+        // The bound shrinks with every hit, culling children still on the stack
+        auto const entry = stack[--stackSize];
+        if (entry.m_tNear > ray.TMax())
+        {
+            continue;
+        }
+
+        if ((entry.m_child & kLeafBit) != 0u)
+        {
+            auto const& leaf = m_leaves[entry.m_child & ~kLeafBit];
+            for (uint32_t i = leaf.m_first; i < leaf.m_first + leaf.m_count; i++)
+            {
+                found |= ray.IntersectClosest(m_objects[i], hit);
+            }
+            continue;
+        }
+
+        auto const& node = m_nodes[entry.m_child];
+        float tNear[kWidth];
+        uint32_t const hits = IntersectChildren(node, tRay.m_origin, tRay.m_invDir, 0.f, ray.TMax(), tNear);
+
+        // Pushed farthest first, so the nearest child is visited next
+        uint32_t const first = stackSize;
+        for (uint32_t i = 0u; i < node.m_childCount; i++)
+        {
+            if ((hits & (1u << i)) != 0u)
+            {
+                uint32_t j = stackSize++;
+                for (; (j > first) && (stack[j - 1u].m_tNear < tNear[i]); j--)
+                {
+                    stack[j] = stack[j - 1u];
+                }
+                stack[j] = { node.m_children[i], tNear[i] };
+            }
+        }
+    }
+    return found;
+}
+
+template<uint32_t kWidth>
+ShapePtr const* WideBvh<kWidth>::FindOccluder(Ray const& ray, float distance) const
+{
+    for (auto const& obj : m_unbounded)
+    {
+        if (ray.IntersectsBefore(obj, distance))
+        {
+            return &obj;
+        }
+    }
+
+    if (m_nodes.empty())
+    {
+        return nullptr;
+    }
+
+    TraversalRay const tRay(ray);
+    std::array<uint32_t, Bvh::kMaxDepth * kWidth> stack;
+    uint32_t stackSize = 0u;
+    stack[stackSize++] = 0u;
+    while (stackSize > 0u)
+    {
+        uint32_t const child = stack[--stackSize];
+        if ((child & kLeafBit) != 0u)
+        {
+            auto const& leaf = m_leaves[child & ~kLeafBit];
+            for (uint32_t i = leaf.m_first; i < leaf.m_first + leaf.m_count; i++)
+            {
+                if (ray.IntersectsBefore(m_objects[i], distance))
+                {
+                    return &m_objects[i];
+                }
+            }
+            continue;
+        }
+
+        // Any occluder will do, children are visited in no particular order
+        auto const& node = m_nodes[child];
+        float tNear[kWidth];
+        uint32_t const hits = node.m_shadowCasters & IntersectChildren(node, tRay.m_origin, tRay.m_invDir, EPSILON, distance, tNear);
+        for (uint32_t i = 0u; i < node.m_childCount; i++)
+        {
+            if ((hits & (1u << i)) != 0u)
+            {
+                stack[stackSize++] = node.m_children[i];
+            }
+        }
+    }
+    return nullptr;
+}
+
+template class WideBvh<4u>;
+template class WideBvh<8u>;
@@ -1,13 +1,21 @@
 #include "World.h"
 
 #include "Archetype.h"
+#include "Frustum.h"
 #include "Lighting.h"
 #include "Ray.h"
+#include "RayPacket.h"
+#include "TileCandidates.h"
+#include "Shapes/Instance.h"
 #include "Shapes/ShapeFactory.h"
 
+#include <array>
+#include <type_traits>
+
 namespace
 {
 
+constexpr static char const* json_key_archetype = "archetype";
 constexpr static char const* json_key_archetypes = "archetypes";
 constexpr static char const* json_key_lights = "lights";
 constexpr static char const* json_key_objects = "objects";
@@ -15,21 +23,110 @@ constexpr static char const* json_key_position = "position";
 constexpr static char const* json_key_intensity = "intensity";
 constexpr static char const* json_key_name = "name";
 
+// Counters are accumulated locally and published every so many queries, so
+// threads don't fight over the shared ones on every shadow ray
+constexpr uint64_t kOccluderCacheFlushPeriod = 1024u;
+
+// Last occluder found by the current thread toward every light of a world
+struct OccluderCache
+{
+    ~OccluderCache()
+    {
+        Flush();
+    }
+
+    void Bind(uint64_t sceneId, std::shared_ptr<World::OccluderCacheCounters> const& counters, size_t lightCount)
+    {
+        if ((sceneId != m_sceneId) || (counters != m_counters))
+        {
+            Flush();
+            m_sceneId = sceneId;
+            m_counters = counters;
+            m_occluders.clear();
+        }
+        if (m_occluders.size() < lightCount)
+        {
+            m_occluders.resize(lightCount);
+        }
+    }
+
+    void Count(bool hit)
+    {
+        m_queries++;
+        m_hits += hit ? 1u : 0u;
+        if (m_queries >= kOccluderCacheFlushPeriod)
+        {
+            Flush();
+        }
+    }
+
+    void Flush()
+    {
+        if (m_counters != nullptr)
+        {
+            m_counters->m_queries.fetch_add(m_queries, std::memory_order_relaxed);
+            m_counters->m_hits.fetch_add(m_hits, std::memory_order_relaxed);
+        }
+        m_queries = 0u;
+        m_hits = 0u;
+    }
+
+    uint64_t m_sceneId = 0u;
+    std::shared_ptr<World::OccluderCacheCounters> m_counters;
+    // Not owned, so threads outliving a world don't keep its shapes alive.
+    // They are dropped with the scene id before they could dangle.
+    std::vector<Shape const*> m_occluders;
+    uint64_t m_queries = 0u;
+    uint64_t m_hits = 0u;
+};
+
+thread_local OccluderCache t_occluderCache;
+
+}
+
+World::World()
+    : m_acceleratorType(AcceleratorType::Bvh)
+    , m_sceneId(NextSceneId())
+    , m_useOccluderCache(true)
+    , m_occluderCacheCounters(std::make_shared<OccluderCacheCounters>())
+{
+}
+
+// static
+uint64_t World::NextSceneId()
+{
+    static std::atomic<uint64_t> s_nextId = 1u;
+    return s_nextId.fetch_add(1u, std::memory_order_relaxed);
 }
 
 Color World::ShadeHit(IntersectionData const& data, uint8_t remaining) const
 {
+    auto const& material = data.GetMaterial();
+    Color const surfaceColor = SurfaceColor(data);
+
     Color color(0.f, 0.f, 0.f);
     for (auto const& light : m_lights)
     {
         bool isInShadow = IsShadowed(data.m_overPoint, light);
-        color = color + Lighting(data.m_object->GetMaterial(), data.m_object, light,
+        color = color + Lighting(material, surfaceColor, light,
             data.m_overPoint, data.m_eyev, data.m_normalv, isInShadow);
     }
+    return AddSecondaryColors(color, data, remaining);
+}
+
+Color World::SurfaceColor(IntersectionData const& data) const
+{
+    // Patterns are looked up in the space of the prototype for instanced objects
+    auto const patternPoint = (data.m_instance != nullptr) ? data.m_instance->WorldToLocal(data.m_overPoint) : data.m_overPoint;
+    return data.GetMaterial().ColorAt(data.m_object, patternPoint);
+}
+
+Color World::AddSecondaryColors(Color const& color, IntersectionData const& data, uint8_t remaining) const
+{
+    auto const& material = data.GetMaterial();
     Color const reflected = ReflectedColor(data, remaining);
     Color const refracted = RefractedColor(data, remaining);
 
-    auto const& material = data.m_object->GetMaterial();
     if ((material.Reflective() > 0.f) && (material.Transparency() > 0.f))
     {
         auto const reflectance = Schlick(data);
@@ -43,18 +140,119 @@ Color World::ShadeHit(IntersectionData const& data, uint8_t remaining) const
 
 Color World::ColorAt(Ray const& r, uint8_t remaining) const
 {
-    std::vector<Intersection> xs;
-    xs.reserve(10);
+    // Queried on a copy, so the caller can trace the same ray again
+    Ray const query(r.Origin(), r.Direction());
+    Intersection hit(INF, nullptr);
+    if (!query.IntersectClosest(*this, hit))
+    {
+        return Color(0.f, 0.f, 0.f);
+    }
+    return ShadeHit(Precompute(r, hit), remaining);
+}
+
+void World::ColorAt(RayPacket const& packet, Color* colors, uint8_t remaining) const
+{
+    // Queried on a copy, so the caller can trace the same rays again
+    RayPacket const query = packet;
+    query.ResetTMax();
+    std::array<Intersection, RayPacket::kMaxSize> hits;
+    uint32_t const found = query.IntersectClosest(*this, packet.FullMask(), hits.data());
+    ShadePacket(packet, found, hits.data(), colors, remaining);
+}
 
-    r.Intersect(*this, xs);
-    auto const i = Hit(xs);
-    if (i.Object() == nullptr)
+Color World::ColorAt(Ray const& r, TileCandidates const& candidates, uint8_t remaining) const
+{
+    Ray const query(r.Origin(), r.Direction());
+    Intersection hit(INF, nullptr);
+    if (!candidates.IntersectClosest(query, hit))
     {
         return Color(0.f, 0.f, 0.f);
     }
+    return ShadeHit(Precompute(r, hit), remaining);
+}
+
+void World::ColorAt(RayPacket const& packet, TileCandidates const& candidates, Color* colors, uint8_t remaining) const
+{
+    RayPacket const query = packet;
+    query.ResetTMax();
+    std::array<Intersection, RayPacket::kMaxSize> hits;
+    uint32_t const found = candidates.IntersectClosest(query, packet.FullMask(), hits.data());
+    ShadePacket(packet, found, hits.data(), colors, remaining);
+}
+
+void World::CollectCandidates(Frustum const& frustum, TileCandidates& candidates) const
+{
+    if (auto const* accelerator = GetAccelerator())
+    {
+        accelerator->CollectCandidates(frustum, candidates);
+        return;
+    }
+
+    candidates.Clear();
+    for (auto const& obj : m_objects)
+    {
+        auto const bounds = obj->Transform() * obj->GetBounds();
+        if (!bounds.IsFinite() || (frustum.Classify(bounds) != Frustum::Overlap::Outside))
+        {
+            candidates.Add(obj);
+        }
+    }
+}
+
+void World::ShadePacket(RayPacket const& packet, uint32_t found, Intersection const* hits, Color* colors, uint8_t remaining) const
+{
+    std::array<IntersectionData, RayPacket::kMaxSize> data;
+    std::array<Tuple, RayPacket::kMaxSize> surfaceColors; // Color has no default constructor
+    for (uint32_t lane = 0u; lane < packet.Size(); lane++)
+    {
+        colors[lane] = Color(0.f, 0.f, 0.f);
+    }
+    ForEachLane(found, [&](uint32_t lane) {
+        data[lane] = Precompute(packet.At(lane), hits[lane]);
+        surfaceColors[lane] = SurfaceColor(data[lane]);
+    });
+
+    // Lights are accumulated in the same order as ShadeHit does
+    for (auto const& light : m_lights)
+    {
+        RayPacket shadowRays;
+        std::array<float, RayPacket::kMaxSize> distances = {};
+        std::array<uint32_t, RayPacket::kMaxSize> lanes;
+        ForEachLane(found, [&](uint32_t lane) {
+            auto const pointToLight = light.Position() - data[lane].m_overPoint;
+            distances[shadowRays.Size()] = pointToLight.Length();
+            lanes[shadowRays.Size()] = lane;
+            shadowRays.Add(Ray(data[lane].m_overPoint, pointToLight.Normalized()));
+        });
+
+        uint32_t const shadowed = shadowRays.FindOccluders(*this, shadowRays.FullMask(), distances.data());
+        for (uint32_t i = 0u; i < shadowRays.Size(); i++)
+        {
+            auto const& d = data[lanes[i]];
+            colors[lanes[i]] = colors[lanes[i]] + Lighting(d.GetMaterial(), surfaceColors[lanes[i]], light,
+                d.m_overPoint, d.m_eyev, d.m_normalv, (shadowed & (1u << i)) != 0u);
+        }
+    }
+
+    ForEachLane(found, [&](uint32_t lane) {
+        colors[lane] = AddSecondaryColors(colors[lane], data[lane], remaining);
+    });
+}
+
+IntersectionData World::Precompute(Ray const& r, Intersection const& hit) const
+{
+    if (hit.GetMaterial().Transparency() == 0.f)
+    {
+        // Refractive indices are only used to refract, no need to know
+        // which objects the hit is inside of
+        return r.Precompute(hit);
+    }
 
-    auto const iData = r.Precompute(i, xs);
-    return ShadeHit(iData, remaining);
+    // Released before shading, so reflected and refracted rays reuse it
+    auto lease = IntersectionArena::Acquire();
+    auto& xs = lease.List();
+    r.Intersect(*this, xs);
+    return r.Precompute(hit, xs);
 }
 
 bool World::IsShadowed(Tuple const& point, PointLight const& light) const
@@ -63,12 +261,59 @@ bool World::IsShadowed(Tuple const& point, PointLight const& light) const
     auto const distanceToLight = pointToLight.Length();
     auto const rayToLight = Ray(point, pointToLight.Normalized());
 
-    return rayToLight.HasIntersectionNearThan(*this, distanceToLight);
+    // Only lights of this world have a slot in the cache
+    auto const lightIdx = static_cast<size_t>(&light - m_lights.data());
+    if (!m_useOccluderCache || m_lights.empty() || (&light < m_lights.data()) || (lightIdx >= m_lights.size()))
+    {
+        return rayToLight.HasIntersectionNearThan(*this, distanceToLight);
+    }
+
+    auto& cache = t_occluderCache;
+    cache.Bind(m_sceneId, m_occluderCacheCounters, m_lights.size());
+    auto& occluder = cache.m_occluders[lightIdx];
+    if ((occluder != nullptr) && rayToLight.IntersectsBefore(*occluder, distanceToLight))
+    {
+        cache.Count(true);
+        return true;
+    }
+    cache.Count(false);
+
+    auto const* found = rayToLight.FindOccluder(*this, distanceToLight);
+    if (found != nullptr)
+    {
+        occluder = found->get();
+    }
+    return found != nullptr;
+}
+
+World::OccluderCacheStats World::GetOccluderCacheStats() const
+{
+    FlushOccluderCacheStats();
+
+    OccluderCacheStats stats;
+    stats.m_queries = m_occluderCacheCounters->m_queries.load(std::memory_order_relaxed);
+    stats.m_hits = m_occluderCacheCounters->m_hits.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void World::ResetOccluderCacheStats()
+{
+    FlushOccluderCacheStats();
+    m_occluderCacheCounters->m_queries = 0u;
+    m_occluderCacheCounters->m_hits = 0u;
+}
+
+void World::FlushOccluderCacheStats() const
+{
+    if (t_occluderCache.m_counters == m_occluderCacheCounters)
+    {
+        t_occluderCache.Flush();
+    }
 }
 
 Color World::ReflectedColor(IntersectionData const& data, uint8_t remaining) const
 {
-    float const reflective = data.m_object->GetMaterial().Reflective();
+    float const reflective = data.GetMaterial().Reflective();
     if ((reflective == 0.f) || (remaining < 1))
     {
         return { 0.f, 0.f, 0.f };
@@ -80,7 +325,7 @@ Color World::ReflectedColor(IntersectionData const& data, uint8_t remaining) con
 
 Color World::RefractedColor(IntersectionData const& data, uint8_t maxRecursion) const
 {
-    float const transparency = data.m_object->GetMaterial().Transparency();
+    float const transparency = data.GetMaterial().Transparency();
     if (transparency == 0.f || maxRecursion < 1)
     {
         return Color::Black();
@@ -105,6 +350,108 @@ Color World::RefractedColor(IntersectionData const& data, uint8_t maxRecursion)
 void World::Add(ArchetypePtr const& a)
 {
     m_archetypes[a->Name()] = a;
+    m_prototypes.erase(a->Name());
+}
+
+void World::SetAcceleratorType(AcceleratorType type)
+{
+    m_acceleratorType = type;
+    BuildCollapsed();
+}
+
+void World::BuildAccelerator()
+{
+    m_bvh = std::make_shared<Bvh>(m_objects);
+    m_linearBvh.reset();
+    m_bvh4.reset();
+    m_bvh8.reset();
+    BuildCollapsed();
+}
+
+void World::BuildCollapsed()
+{
+    if (m_bvh == nullptr)
+    {
+        return;
+    }
+
+    if ((m_acceleratorType == AcceleratorType::LinearBvh) && (m_linearBvh == nullptr))
+    {
+        m_linearBvh = std::make_shared<LinearBvh>(*m_bvh);
+    }
+    else if ((m_acceleratorType == AcceleratorType::Bvh4) && (m_bvh4 == nullptr))
+    {
+        m_bvh4 = std::make_shared<Bvh4>(*m_bvh);
+    }
+    else if ((m_acceleratorType == AcceleratorType::Bvh8) && (m_bvh8 == nullptr))
+    {
+        m_bvh8 = std::make_shared<Bvh8>(*m_bvh);
+    }
+}
+
+void World::RefitAccelerator(std::vector<ShapePtr> const& moved)
+{
+    if (m_bvh == nullptr)
+    {
+        BuildAccelerator();
+        return;
+    }
+
+    // The bvh only knows about top level objects
+    std::vector<ShapePtr> objects;
+    objects.reserve(moved.size());
+    for (auto object : moved)
+    {
+        while (object->Parent() != nullptr)
+        {
+            object = object->Parent();
+        }
+        objects.push_back(object);
+    }
+
+    // Copied worlds share their accelerators, don't modify them under their
+    // feet
+    if (m_bvh.use_count() > 1)
+    {
+        m_bvh = std::make_shared<Bvh>(*m_bvh);
+    }
+    if (!m_bvh->Refit(objects) || m_bvh->NeedsRebuild())
+    {
+        BuildAccelerator();
+        return;
+    }
+
+    // Accelerators of other types would be out of date, they are built again
+    // if asked for
+    auto const refit = [&](auto& accelerator, AcceleratorType type) {
+        using Collapsed = typename std::decay_t<decltype(accelerator)>::element_type;
+        if ((type != m_acceleratorType) || (accelerator == nullptr))
+        {
+            accelerator.reset();
+            return;
+        }
+        if (accelerator.use_count() > 1)
+        {
+            accelerator = std::make_shared<Collapsed>(*accelerator);
+        }
+        accelerator->Refit(*m_bvh, objects);
+    };
+    refit(m_linearBvh, AcceleratorType::LinearBvh);
+    refit(m_bvh4, AcceleratorType::Bvh4);
+    refit(m_bvh8, AcceleratorType::Bvh8);
+    BuildCollapsed();
+}
+
+IAccelerator const* World::GetAccelerator() const
+{
+    switch (m_acceleratorType)
+    {
+    case AcceleratorType::Bvh: return m_bvh.get();
+    case AcceleratorType::LinearBvh: return m_linearBvh.get();
+    case AcceleratorType::Bvh4: return m_bvh4.get();
+    case AcceleratorType::Bvh8: return m_bvh8.get();
+    default: return nullptr;
+    }
 }
 
 ArchetypeConstPtr World::FindArchetype(std::string const& name) const
@@ -145,7 +492,13 @@ bool World::Load(std::istream& is)
         std::vector<json> objects = data.at(json_key_objects);
         for (auto const& obj : objects)
         {
-            if (auto shape = ShapeFactory::Get().Create(obj, {}, m_archetypes))
+            auto shape = CreateInstance(obj);
+            if (shape == nullptr)
+            {
+                shape = ShapeFactory::Get().Create(obj, {}, m_archetypes);
+            }
+
+            if (shape != nullptr)
             {
                 m_objects.push_back(shape);
             }
@@ -156,9 +509,41 @@ bool World::Load(std::istream& is)
         }
     }
 
+    BuildAccelerator();
     return true;
 }
 
+ShapePtr World::CreateInstance(json const& data)
+{
+    if (!data.contains(json_key_archetype))
+    {
+        return nullptr;
+    }
+
+    std::string const name = data.at(json_key_archetype);
+    auto const archetype = m_archetypes.find(name);
+    if ((archetype == m_archetypes.end()) || !Instance::CanInstance(archetype->second->Template(), data))
+    {
+        return nullptr;
+    }
+
+    // Every archetype is built only once, then shared by all of its instances
+    auto& prototype = m_prototypes[name];
+    if (prototype == nullptr)
+    {
+        auto root = ShapeFactory::Get().Create(archetype->second->Template(), {}, m_archetypes);
+        if (root == nullptr)
+        {
+            return nullptr;
+        }
+        prototype = Instance::Compile(root);
+    }
+
+    auto instance = std::make_shared<Instance>(prototype);
+    instance->Initialize(archetype->second->Template(), data, m_archetypes);
+    return instance;
+}
+
 bool World::LoadArchetypes(std::vector<json> const& archetypes)
 {
     for (auto const& arcTemplate : archetypes)
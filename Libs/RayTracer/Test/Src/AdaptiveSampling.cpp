@@ -0,0 +1,107 @@
+#include "TestHelpers.h"
+
+#include <RayTracer/Camera.h>
+#include <RayTracer/RenderTarget.h>
+#include <RayTracer/Transformations.h>
+#include <RayTracer/Util.h>
+
+#include <Beddev/Beddev.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    Camera AdaptiveCamera()
+    {
+        Camera c(37, 29, PI / 2.f);
+        c.SetTransform(matrix::View(Point(0.f, 1.f, -5.f), Point(0.f, 0.f, 0.f), Vector(0.f, 1.f, 0.f)));
+        return c;
+    }
+
+    RenderSettings Adaptive(uint32_t maxSamples, float threshold, uint32_t threads)
+    {
+        RenderSettings settings;
+        settings.m_maxSamplesPerPixel = maxSamples;
+        settings.m_adaptiveThreshold = threshold;
+        settings.m_threads = threads;
+        return settings;
+    }
+
+    // Samples of every pixel, along with the total reported by the stats
+    struct Sampled
+    {
+        std::vector<uint32_t> m_samples;
+        uint64_t m_total;
+    };
+
+    Sampled Render(World const& w, RenderSettings const& settings)
+    {
+        auto const c = AdaptiveCamera();
+        RenderTarget target(c.HorizontalSize(), c.VerticalSize());
+        RenderStats stats;
+        c.Render(w, settings, target, nullptr, &stats);
+        Sampled sampled;
+        target.Snapshot(nullptr, &sampled.m_samples);
+        sampled.m_total = stats.m_samples;
+        return sampled;
+    }
+
+    size_t PixelsWith(Sampled const& sampled, uint32_t samples)
+    {
+        return std::count(sampled.m_samples.begin(), sampled.m_samples.end(), samples);
+    }
+
+    uint64_t Sum(Sampled const& sampled)
+    {
+        uint64_t sum = 0u;
+        for (auto samples : sampled.m_samples)
+        {
+            sum += samples;
+        }
+        return sum;
+    }
+
+    bool SameRender(World const& w, RenderSettings const& a, RenderSettings const& b)
+    {
+        auto const c = AdaptiveCamera();
+        auto const imageA = c.Render(w, a);
+        auto const imageB = c.Render(w, b);
+        return SameImage(imageA, imageB);
+    }
+}
+
+SCENARIO("Without adaptive sampling every pixel gets the same samples", "adaptive")
+{
+    GIVEN( auto const w = DefaultWorld() )
+    WHEN( auto const sampled = Render(w, Adaptive(0u, .05f, 2u)) )
+    THEN( PixelsWith(sampled, 1u) == 37u * 29u
+        , sampled.m_total == 37u * 29u )
+}
+
+SCENARIO("Adaptive sampling refines edges and keeps flat regions at one sample", "adaptive")
+{
+    GIVEN( auto const w = DefaultWorld() )
+    WHEN( auto const sampled = Render(w, Adaptive(16u, .05f, 2u)) )
+    THEN( sampled.m_samples[0] == 1u
+        , PixelsWith(sampled, 1u) > (37u * 29u) / 2u
+        , PixelsWith(sampled, 16u) > 0u
+        , *std::max_element(sampled.m_samples.begin(), sampled.m_samples.end()) == 16u
+        , sampled.m_total == Sum(sampled)
+        , sampled.m_total < 4u * 37u * 29u )
+}
+
+SCENARIO("A high adaptive threshold never refines", "adaptive")
+{
+    GIVEN( auto const w = DefaultWorld() )
+    WHEN( auto const sampled = Render(w, Adaptive(16u, 10.f, 2u)) )
+    THEN( PixelsWith(sampled, 1u) == 37u * 29u
+        , SameRender(w, Adaptive(16u, 10.f, 2u), Adaptive(0u, .05f, 2u)) )
+}
+
+SCENARIO("Adaptive renders don't depend on the number of workers", "adaptive")
+{
+    GIVEN( auto const w = DefaultWorld() )
+    THEN( SameRender(w, Adaptive(8u, .02f, 1u), Adaptive(8u, .02f, 3u))
+        , !SameRender(w, Adaptive(8u, .02f, 1u), Adaptive(0u, .02f, 1u)) )
+}
@@ -0,0 +1,134 @@
+#include <RayTracer/AffineTransform.h>
+#include <RayTracer/Bounds.h>
+#include <RayTracer/Ray.h>
+#include <RayTracer/Transformations.h>
+#include <RayTracer/Util.h>
+
+#include <Beddev/Beddev.h>
+
+namespace
+{
+    using Kind = AffineTransform::Kind;
+
+    Mat44 GeneralTransform()
+    {
+        return matrix::Translation(1.f, -2.f, 3.f)
+            * matrix::RotationX(.3f) * matrix::RotationY(-1.2f)
+            * matrix::Shearing(.5f, 0.f, .2f, 0.f, 0.f, .1f)
+            * matrix::Scaling(2.f, .5f, 3.f);
+    }
+
+    bool IsRejected(Mat44 const& m)
+    {
+        try
+        {
+            AffineTransform const t(m);
+        }
+        catch (std::runtime_error const&)
+        {
+            return true;
+        }
+        return false;
+    }
+}
+
+SCENARIO("Affine transforms are classified when built", "math")
+{
+    THEN( AffineTransform().GetKind() == Kind::Identity
+        , AffineTransform(Mat44::Identity()).GetKind() == Kind::Identity
+        , AffineTransform(matrix::Translation(1.f, 2.f, 3.f)).GetKind() == Kind::Translation
+        , AffineTransform(matrix::Scaling(2.f, 2.f, 2.f)).GetKind() == Kind::UniformScale
+        , AffineTransform(matrix::Translation(1.f, 0.f, 0.f) * matrix::Scaling(.5f, .5f, .5f)).GetKind() == Kind::UniformScale
+        , AffineTransform(matrix::Scaling(1.f, 2.f, 3.f)).GetKind() == Kind::General
+        , AffineTransform(matrix::RotationY(PIOVR4)).GetKind() == Kind::General )
+}
+
+SCENARIO("Only affine matrices can be turned into affine transforms", "math")
+{
+    GIVEN( auto m = Mat44::Identity()
+         , m.At(3, 2) = 1.f )
+    THEN( IsRejected(m)
+        , !IsRejected(GeneralTransform()) )
+}
+
+SCENARIO("An affine transform converts back to the matrix it was built from", "math")
+{
+    GIVEN( auto const m = GeneralTransform() )
+    WHEN( auto const t = AffineTransform(m) )
+    THEN( t.ToMat44() == m
+        , t == m )
+}
+
+SCENARIO("Inverting affine transforms gives the same result as inverting matrices", "math")
+{
+    GIVEN( auto const translation = matrix::Translation(1.f, 2.f, 3.f)
+         , auto const scale = matrix::Translation(1.f, 2.f, 3.f) * matrix::Scaling(4.f, 4.f, 4.f)
+         , auto const general = GeneralTransform() )
+    THEN( AffineTransform().Inverse().IsIdentity()
+        , AffineTransform(translation).Inverse() == translation.Inverse()
+        , AffineTransform(translation).Inverse().GetKind() == Kind::Translation
+        , AffineTransform(scale).Inverse() == scale.Inverse()
+        , AffineTransform(scale).Inverse().GetKind() == Kind::UniformScale
+        , AffineTransform(general).Inverse() == general.Inverse()
+        , AffineTransform(general) * AffineTransform(general).Inverse() == Mat44::Identity() )
+}
+
+SCENARIO("Applying affine transforms to points and vectors", "math")
+{
+    GIVEN( auto const m = GeneralTransform()
+         , auto const t = AffineTransform(m)
+         , auto const p = Point(-3.f, 4.f, 5.f)
+         , auto const v = Vector(-3.f, 4.f, 5.f) )
+    THEN( t * p == m * p
+        , t * v == m * v
+        , AffineTransform(matrix::Translation(5.f, -3.f, 2.f)) * p == Point(2.f, 1.f, 7.f)
+        , AffineTransform(matrix::Translation(5.f, -3.f, 2.f)) * v == v
+        , AffineTransform(matrix::Translation(1.f, 0.f, 0.f) * matrix::Scaling(2.f, 2.f, 2.f)) * p == Point(-5.f, 8.f, 10.f) )
+}
+
+SCENARIO("Composing affine transforms gives the same result as multiplying matrices", "math")
+{
+    GIVEN( auto const a = GeneralTransform()
+         , auto const b = matrix::Translation(1.f, 2.f, 3.f) * matrix::RotationZ(.7f) )
+    THEN( AffineTransform(a) * AffineTransform(b) == a * b
+        , (AffineTransform(matrix::Translation(1.f, 0.f, 0.f)) * AffineTransform(matrix::Translation(0.f, 1.f, 0.f))).GetKind() == Kind::Translation )
+}
+
+SCENARIO("The normal matrix is the transposed linear part", "math")
+{
+    GIVEN( auto const m = matrix::RotationX(.3f) * matrix::Shearing(.5f, 0.f, .2f, 0.f, 0.f, .1f) * matrix::Scaling(2.f, .5f, 3.f)
+         , auto const n = AffineTransform(matrix::Translation(1.f, 2.f, 3.f) * m).NormalMatrix()
+         , auto const v = Vector(1.f, 2.f, 3.f) )
+    THEN( n * v == m.Transposed() * v
+        , AffineTransform(matrix::Translation(1.f, 2.f, 3.f)).NormalMatrix().IsIdentity() )
+}
+
+SCENARIO("Transforming bounds with affine transforms", "AABB")
+{
+    GIVEN( auto const b = Bounds(Point(-1.f, -2.f, -3.f), Point(1.f, 3.f, 2.f))
+         , auto const translation = matrix::Translation(1.f, 2.f, 3.f)
+         , auto const scale = matrix::Scaling(-2.f, -2.f, -2.f)
+         , auto const general = GeneralTransform() )
+    THEN( AffineTransform() * b == b
+        , AffineTransform(translation) * b == translation * b
+        , AffineTransform(scale) * b == scale * b
+        , AffineTransform(general) * b == general * b )
+}
+
+SCENARIO("Rotating infinite bounds keeps them well defined", "AABB")
+{
+    GIVEN( auto const b = Bounds(Point(-INF, 0.f, -INF), Point(INF, 0.f, INF)) )
+    WHEN( auto const rotated = AffineTransform(matrix::RotationZ(PIOVR2)) * b )
+    THEN( rotated.Min() == Point(-INF, -INF, -INF)
+        , rotated.Max() == Point(INF, INF, INF) )
+}
+
+SCENARIO("Transforming a ray with an affine transform keeps its tMax", "math")
+{
+    GIVEN( auto const r = Ray(Point(1.f, 2.f, 3.f), Vector(0.f, 1.f, 0.f), 5.f)
+         , auto const t = AffineTransform(matrix::Scaling(2.f, 3.f, 4.f)) )
+    WHEN( auto const r2 = t * r )
+    THEN( r2.Origin() == Point(2.f, 6.f, 12.f)
+        , r2.Direction() == Vector(0.f, 3.f, 0.f)
+        , r2.TMax() == 5.f )
+}
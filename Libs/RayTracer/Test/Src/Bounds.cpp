@@ -28,6 +28,32 @@ SCENARIO("Two bounds are merged into one", "AABB")
         , b1.Max() == Point( 1.f,  2.f,  1.f) )
 }
 
+SCENARIO("Merging bounds into empty bounds", "AABB")
+{
+    GIVEN( auto b = Bounds::Empty() )
+    WHEN( b.Merge(Bounds(Point(-1.f, -2.f, -3.f), Point(3.f, 2.f, 1.f)))
+        , b.Merge(Point(4.f, 0.f, 0.f)) )
+    THEN( b.Min() == Point(-1.f, -2.f, -3.f)
+        , b.Max() == Point(4.f, 2.f, 1.f) )
+}
+
+SCENARIO("The center and surface area of bounds", "AABB")
+{
+    GIVEN( auto const b = Bounds(Point(-1.f, 0.f, 1.f), Point(1.f, 4.f, 4.f)) )
+    THEN( b.Center() == Point(0.f, 2.f, 2.5f)
+        , Equals(b.SurfaceArea(), 52.f)
+        , Bounds::Empty().SurfaceArea() == 0.f )
+}
+
+SCENARIO("Bounds with infinite extents are not finite", "AABB")
+{
+    GIVEN( auto const b1 = Bounds()
+         , auto const b2 = Bounds(Point(-INF, 0.f, -INF), Point(INF, 0.f, INF)) )
+    THEN( b1.IsFinite()
+        , !b2.IsFinite()
+        , !Bounds::Empty().IsFinite() )
+}
+
 SCENARIO("Transforming bounds", "AABB")
 {
     GIVEN( auto const b = Bounds(Point(-1.f, -1.f, -1.f), Point(1.f, 1.f, 1.f))
@@ -89,3 +115,34 @@ PSCENARIO(TestArg, "A ray intersects a non-default AABB", "AABB")
         , t1 == arg.t1
         , t2 == arg.t2 )
 }
+
+SCENARIO("Checking whether bounds contain a point or other bounds", "AABB")
+{
+    GIVEN( auto const b = Bounds(Point(5.f, -2.f, 0.f), Point(11.f, 4.f, 7.f)) )
+    THEN( b.Contains(Point(5.f, -2.f, 0.f))
+        , b.Contains(Point(8.f, 1.f, 3.f))
+        , !b.Contains(Point(3.f, 0.f, 3.f))
+        , !b.Contains(Point(8.f, 1.f, 8.f))
+        , b.Contains(Bounds(Point(6.f, -1.f, 1.f), Point(10.f, 3.f, 6.f)))
+        , !b.Contains(Bounds(Point(4.f, -3.f, -1.f), Point(10.f, 3.f, 6.f))) )
+}
+
+SCENARIO("Splitting bounds across their largest dimension", "AABB")
+{
+    GIVEN( auto const b1 = Bounds(Point(-1.f, -4.f, -5.f), Point(9.f, 6.f, 5.f))
+         , auto const b2 = Bounds(Point(-1.f, -2.f, -3.f), Point(9.f, 5.5f, 3.f))
+         , auto const b3 = Bounds(Point(-1.f, -2.f, -3.f), Point(5.f, 8.f, 3.f))
+         , auto const b4 = Bounds(Point(-1.f, -2.f, -3.f), Point(5.f, 3.f, 7.f)) )
+    WHEN( auto const s1 = b1.Split()
+        , auto const s2 = b2.Split()
+        , auto const s3 = b3.Split()
+        , auto const s4 = b4.Split() )
+    THEN( s1.first == Bounds(Point(-1.f, -4.f, -5.f), Point(4.f, 6.f, 5.f))
+        , s1.second == Bounds(Point(4.f, -4.f, -5.f), Point(9.f, 6.f, 5.f))
+        , s2.first == Bounds(Point(-1.f, -2.f, -3.f), Point(4.f, 5.5f, 3.f))
+        , s2.second == Bounds(Point(4.f, -2.f, -3.f), Point(9.f, 5.5f, 3.f))
+        , s3.first == Bounds(Point(-1.f, -2.f, -3.f), Point(5.f, 3.f, 3.f))
+        , s3.second == Bounds(Point(-1.f, 3.f, -3.f), Point(5.f, 8.f, 3.f))
+        , s4.first == Bounds(Point(-1.f, -2.f, -3.f), Point(5.f, 3.f, 2.f))
+        , s4.second == Bounds(Point(-1.f, -2.f, 2.f), Point(5.f, 3.f, 7.f)) )
+}
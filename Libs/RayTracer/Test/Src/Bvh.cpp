@@ -0,0 +1,205 @@
+#include "TestHelpers.h"
+
+#include <RayTracer/Bvh.h>
+#include <RayTracer/Shapes/Group.h>
+#include <RayTracer/Shapes/Plane.h>
+#include <RayTracer/Shapes/Sphere.h>
+#include <RayTracer/Transformations.h>
+#include <RayTracer/World.h>
+
+#include <Beddev/Beddev.h>
+
+#include <sstream>
+
+SCENARIO("An empty bvh", "bvh")
+{
+    GIVEN( auto const bvh = Bvh() )
+    THEN( bvh.NodeCount() == 0
+        , bvh.Depth() == 0
+        , bvh.GetBounds() == Bounds::Empty() )
+}
+
+SCENARIO("A bvh over a single shape", "bvh")
+{
+    GIVEN( auto s = std::make_shared<Sphere>()
+         , s->SetTransform(matrix::Translation(2.f, 0.f, 0.f)) )
+    WHEN( auto const bvh = Bvh({ s }) )
+    THEN( bvh.NodeCount() == 1
+        , bvh.Depth() == 1
+        , bvh.GetBounds() == Bounds(Point(1.f, -1.f, -1.f), Point(3.f, 1.f, 1.f)) )
+}
+
+SCENARIO("Shapes with infinite bounds are kept out of the bvh", "bvh")
+{
+    GIVEN( auto p = std::make_shared<Plane>()
+         , auto s = std::make_shared<Sphere>() )
+    WHEN( auto const bvh = Bvh({ p, s }) )
+    THEN( bvh.NodeCount() == 1
+        , bvh.UnboundedCount() == 1
+        , bvh.GetBounds() == Bounds() )
+}
+
+SCENARIO("A bvh over many shapes is shallow", "bvh")
+{
+    GIVEN( auto const w = SphereGrid(16) )
+    WHEN( auto const bvh = Bvh(w.Objects()) )
+    THEN( bvh.UnboundedCount() == 0
+        , bvh.Depth() <= 16
+        , bvh.GetBounds() == Bounds(Point(-.5f, -.5f, -.5f), Point(45.5f, 45.5f, 2.5f)) )
+}
+
+SCENARIO("Intersecting a world through its bvh gives the same result as brute force", "bvh")
+{
+    GIVEN( auto w = SphereGrid(8)
+         , w.Add(std::make_shared<Plane>())
+         , w.BuildAccelerator() )
+    THEN( w.GetBvh() != nullptr
+        , SameIntersections(w, World::AcceleratorType::Bvh, Ray(Point(0.f, 0.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameIntersections(w, World::AcceleratorType::Bvh, Ray(Point(9.f, 6.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameIntersections(w, World::AcceleratorType::Bvh, Ray(Point(-5.f, 0.f, 0.f), Vector(1.f, 0.f, 0.f)))
+        , SameIntersections(w, World::AcceleratorType::Bvh, Ray(Point(-5.f, -5.f, .5f), Vector(1.f, 1.f, 0.f).Normalized()))
+        , SameIntersections(w, World::AcceleratorType::Bvh, Ray(Point(10.f, 10.f, 10.f), Vector(.1f, .2f, -1.f).Normalized()))
+        , SameIntersections(w, World::AcceleratorType::Bvh, Ray(Point(1.5f, 1.5f, -5.f), Vector(0.f, 0.f, 1.f))) )
+}
+
+SCENARIO("Shadow queries through a bvh give the same result as brute force", "bvh")
+{
+    GIVEN( auto w = SphereGrid(8)
+         , w.BuildAccelerator() )
+    THEN( SameShadows(w, World::AcceleratorType::Bvh, Point(0.f, 0.f, 1.f))
+        , SameShadows(w, World::AcceleratorType::Bvh, Point(3.f, 3.f, 2.f))
+        , SameShadows(w, World::AcceleratorType::Bvh, Point(21.f, 21.f, 5.f))
+        , SameShadows(w, World::AcceleratorType::Bvh, Point(30.f, 0.f, -2.f))
+        , SameShadows(w, World::AcceleratorType::Bvh, Point(-1.f, 1.f, -1.f)) )
+}
+
+SCENARIO("Closest hit queries through a bvh give the same result as brute force", "bvh")
+{
+    GIVEN( auto w = SphereGrid(8)
+         , w.Add(std::make_shared<Plane>())
+         , w.BuildAccelerator() )
+    THEN( SameClosestHit(w, World::AcceleratorType::Bvh, Ray(Point(0.f, 0.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameClosestHit(w, World::AcceleratorType::Bvh, Ray(Point(9.f, 6.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameClosestHit(w, World::AcceleratorType::Bvh, Ray(Point(25.f, 25.f, .5f), Vector(-1.f, -1.f, 0.f).Normalized()))
+        , SameClosestHit(w, World::AcceleratorType::Bvh, Ray(Point(10.f, 10.f, 10.f), Vector(.1f, .2f, -1.f).Normalized()))
+        , SameClosestHit(w, World::AcceleratorType::Bvh, Ray(Point(3.f, 3.f, 0.f), Vector(0.f, 0.f, 1.f))) )
+}
+
+SCENARIO("Adding objects to a world invalidates its bvh", "bvh")
+{
+    GIVEN( auto w = DefaultWorld()
+         , w.BuildAccelerator() )
+    WHEN( w.Add(std::make_shared<Sphere>()) )
+    THEN( w.GetBvh() == nullptr )
+}
+
+SCENARIO("The bvh is not used when the world accelerator is disabled", "bvh")
+{
+    GIVEN( auto w = DefaultWorld()
+         , w.BuildAccelerator() )
+    WHEN( w.SetAcceleratorType(World::AcceleratorType::None) )
+    THEN( w.GetBvh() == nullptr )
+}
+
+SCENARIO("Loading a world builds its bvh", "bvh")
+{
+    GIVEN( auto w = World()
+         , std::istringstream ss(R"({"objects":[{"type":"Sphere"},{"type":"Cube","position":[4,0,0]}]})") )
+    THEN( w.Load(ss)
+        , w.GetBvh() != nullptr
+        , w.GetBvh()->GetBounds() == Bounds(Point(-1.f, -1.f, -1.f), Point(5.f, 1.f, 1.f)) )
+}
+
+SCENARIO("Refitting a bvh after moving a shape", "bvh")
+{
+    GIVEN( auto s1 = std::make_shared<Sphere>()
+         , auto s2 = std::make_shared<Sphere>()
+         , s2->SetTransform(matrix::Translation(4.f, 0.f, 0.f))
+         , auto bvh = Bvh({ s1, s2 })
+         , s2->SetTransform(matrix::Translation(0.f, 6.f, 0.f)) )
+    WHEN( auto const refitted = bvh.Refit({ s2 }) )
+    THEN( refitted
+        , bvh.NodeCount() == 3
+        , bvh.GetBounds() == Bounds(Point(-1.f, -1.f, -1.f), Point(1.f, 7.f, 1.f)) )
+}
+
+SCENARIO("Shapes unknown to a bvh can't be refitted", "bvh")
+{
+    GIVEN( auto p = std::make_shared<Plane>()
+         , auto bvh = Bvh({ std::make_shared<Sphere>(), p }) )
+    THEN( !bvh.Refit({ std::make_shared<Sphere>() })
+        , !bvh.Refit({ p }) )
+}
+
+SCENARIO("The quality of a bvh degrades when its shapes are scattered", "bvh")
+{
+    GIVEN( auto w = SphereGrid(8)
+         , auto bvh = Bvh(w.Objects())
+         , auto const cost = bvh.SahCost() )
+    WHEN( w.Objects()[0]->SetTransform(matrix::Translation(25.f, 25.f, 0.f))
+        , w.Objects()[63]->SetTransform(matrix::Translation(0.f, 0.f, 0.f))
+        , bvh.Refit({ w.Objects()[0], w.Objects()[63] }) )
+    THEN( cost == bvh.BuildSahCost()
+        , bvh.SahCost() > cost
+        , bvh.NeedsRebuild() )
+}
+
+SCENARIO("Refitting a world bvh gives the same result as brute force", "bvh")
+{
+    GIVEN( auto w = SphereGrid(8)
+         , w.BuildAccelerator()
+         , auto const bvh = w.GetBvh() )
+    WHEN( w.Objects()[9]->SetTransform(matrix::Translation(4.f, 3.5f, 1.f))
+        , w.Objects()[10]->SetTransform(matrix::Translation(3.5f, 4.f, 0.f))
+        , w.RefitAccelerator({ w.Objects()[9], w.Objects()[10] }) )
+    THEN( w.GetBvh() == bvh
+        , !w.GetBvh()->NeedsRebuild()
+        , SameIntersections(w, World::AcceleratorType::Bvh, Ray(Point(4.f, 3.5f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameIntersections(w, World::AcceleratorType::Bvh, Ray(Point(3.f, 3.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameIntersections(w, World::AcceleratorType::LinearBvh, Ray(Point(3.5f, 4.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameIntersections(w, World::AcceleratorType::LinearBvh, Ray(Point(-5.f, 4.f, 0.f), Vector(1.f, 0.f, 0.f)))
+        , SameShadows(w, World::AcceleratorType::LinearBvh, Point(4.f, 3.5f, -1.f)) )
+}
+
+SCENARIO("Refitting a world rebuilds its bvh once degraded", "bvh")
+{
+    GIVEN( auto w = SphereGrid(8)
+         , w.BuildAccelerator()
+         , auto const bvh = w.GetBvh() )
+    WHEN( w.Objects()[0]->SetTransform(matrix::Translation(25.f, 25.f, 0.f))
+        , w.Objects()[63]->SetTransform(matrix::Translation(0.f, 0.f, 0.f))
+        , w.RefitAccelerator({ w.Objects()[0], w.Objects()[63] }) )
+    THEN( w.GetBvh() != bvh
+        , w.GetBvh()->SahCost() == w.GetBvh()->BuildSahCost()
+        , SameIntersections(w, World::AcceleratorType::Bvh, Ray(Point(25.f, 25.f, -5.f), Vector(0.f, 0.f, 1.f))) )
+}
+
+SCENARIO("Refitting a world after moving a nested shape", "bvh")
+{
+    GIVEN( auto w = World()
+         , auto g = std::make_shared<Group>()
+         , auto s = std::make_shared<Sphere>()
+         , g->AddChild(s)
+         , w.Add(g)
+         , w.Add(std::make_shared<Sphere>())
+         , w.ModifyObjects()[1]->SetTransform(matrix::Translation(0.f, 0.f, 4.f))
+         , w.BuildAccelerator() )
+    WHEN( s->SetTransform(matrix::Translation(0.f, 5.f, 0.f))
+        , w.RefitAccelerator({ s }) )
+    THEN( g->GetBounds() == Bounds(Point(-1.f, 4.f, -1.f), Point(1.f, 6.f, 1.f))
+        , w.GetBvh()->GetBounds() == Bounds(Point(-1.f, -1.f, -1.f), Point(1.f, 6.f, 5.f))
+        , SameIntersections(w, World::AcceleratorType::Bvh, Ray(Point(0.f, 5.f, -5.f), Vector(0.f, 0.f, 1.f))) )
+}
+
+SCENARIO("Shadow queries through a bvh skip shapes not casting shadows", "bvh")
+{
+    GIVEN( auto w = SphereGrid(8)
+         , w.Objects()[9]->CastShadows(false)
+         , w.Objects()[18]->CastShadows(false)
+         , w.BuildAccelerator() )
+    THEN( SameShadows(w, World::AcceleratorType::Bvh, Point(3.f, 3.f, 5.f))
+        , SameShadows(w, World::AcceleratorType::Bvh, Point(6.f, 6.f, 5.f))
+        , SameShadows(w, World::AcceleratorType::LinearBvh, Point(3.f, 3.f, 5.f))
+        , SameShadows(w, World::AcceleratorType::LinearBvh, Point(6.f, 6.f, 5.f))
+        , SameShadows(w, World::AcceleratorType::LinearBvh, Point(21.f, 21.f, 5.f)) )
+}
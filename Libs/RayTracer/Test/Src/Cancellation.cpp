@@ -0,0 +1,144 @@
+#include "TestHelpers.h"
+
+#include <RayTracer/CancellationToken.h>
+#include <RayTracer/Camera.h>
+#include <RayTracer/RenderTarget.h>
+#include <RayTracer/ThreadPool.h>
+#include <RayTracer/Transformations.h>
+#include <RayTracer/Util.h>
+
+#include <Beddev/Beddev.h>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace
+{
+    Camera CancelledCamera()
+    {
+        Camera c(37, 29, PI / 2.f);
+        c.SetTransform(matrix::View(Point(0.f, 1.f, -5.f), Point(0.f, 0.f, 0.f), Vector(0.f, 1.f, 0.f)));
+        return c;
+    }
+
+    // Single worker, so tiles are rendered in order
+    RenderSettings Stoppable(CancellationToken const* token, uint32_t passes)
+    {
+        RenderSettings settings;
+        settings.m_threads = 1u;
+        settings.m_passes = passes;
+        settings.m_cancellation = token;
+        return settings;
+    }
+
+    RenderSettings Budget(double seconds)
+    {
+        RenderSettings settings;
+        settings.m_timeBudget = seconds;
+        return settings;
+    }
+
+    // Coverage of a render, cancelled once the given number of tiles of a
+    // pass are done
+    struct Outcome
+    {
+        bool m_complete;
+        std::vector<uint8_t> m_coverage;
+    };
+
+    Outcome CancelAfter(World const& w, uint32_t passes, uint32_t pass, uint32_t tiles)
+    {
+        auto const c = CancelledCamera();
+        CancellationToken token;
+        RenderTarget target(c.HorizontalSize(), c.VerticalSize());
+        Outcome outcome;
+        outcome.m_complete = c.Render(w, Stoppable(&token, passes), target, [&](RenderProgress const& p, RenderTarget const&) {
+            if ((p.m_pass == pass) && (p.m_tilesDone == tiles))
+            {
+                token.Cancel();
+            }
+        });
+        target.Snapshot(&outcome.m_coverage);
+        return outcome;
+    }
+
+    Outcome RenderWith(World const& w, RenderSettings const& settings)
+    {
+        auto const c = CancelledCamera();
+        RenderTarget target(c.HorizontalSize(), c.VerticalSize());
+        Outcome outcome;
+        outcome.m_complete = c.Render(w, settings, target);
+        target.Snapshot(&outcome.m_coverage);
+        return outcome;
+    }
+
+    size_t Covered(std::vector<uint8_t> const& coverage, uint8_t blockSize)
+    {
+        return std::count(coverage.begin(), coverage.end(), blockSize);
+    }
+
+    uint32_t RunsUntilCancelled(ThreadPool& pool, uint32_t count, uint32_t cancelAt)
+    {
+        std::atomic<uint32_t> runs = 0u;
+        pool.ParallelFor(count, [&](uint32_t index, uint32_t) {
+            runs++;
+            if (index == cancelAt)
+            {
+                pool.Cancel();
+            }
+        });
+        return runs;
+    }
+}
+
+SCENARIO("A cancelled token stops a render before it starts", "cancel")
+{
+    GIVEN( auto const w = DefaultWorld()
+         , auto token = CancellationToken() )
+    WHEN( token.Cancel()
+        , auto const outcome = RenderWith(w, Stoppable(&token, 1u)) )
+    THEN( token.IsCancelled()
+        , !outcome.m_complete
+        , Covered(outcome.m_coverage, 0u) == 37u * 29u )
+}
+
+SCENARIO("Cancelling a render keeps the tiles already done", "cancel")
+{
+    GIVEN( auto const w = DefaultWorld() )
+    WHEN( auto const outcome = CancelAfter(w, 1u, 0u, 2u) )
+    THEN( !outcome.m_complete
+        , Covered(outcome.m_coverage, 1u) == 2u * 16u * 16u
+        , Covered(outcome.m_coverage, 0u) == (37u * 29u) - (2u * 16u * 16u) )
+}
+
+SCENARIO("Cancelling a progressive render keeps a full frame of its last pass", "cancel")
+{
+    GIVEN( auto const w = DefaultWorld() )
+    WHEN( auto const firstPass = CancelAfter(w, 3u, 0u, 6u)
+        , auto const secondPass = CancelAfter(w, 3u, 1u, 3u) )
+    THEN( !firstPass.m_complete
+        , Covered(firstPass.m_coverage, 4u) == 37u * 29u
+        , !secondPass.m_complete
+        , Covered(secondPass.m_coverage, 0u) == 0u
+        , Covered(secondPass.m_coverage, 2u) > 0u
+        , Covered(secondPass.m_coverage, 4u) > 0u )
+}
+
+SCENARIO("Renders stop once out of time", "cancel")
+{
+    GIVEN( auto const w = DefaultWorld() )
+    WHEN( auto const expired = RenderWith(w, Budget(1e-9))
+        , auto const plenty = RenderWith(w, Budget(1000.)) )
+    THEN( !expired.m_complete
+        , Covered(expired.m_coverage, 1u) < 37u * 29u
+        , plenty.m_complete
+        , Covered(plenty.m_coverage, 1u) == 37u * 29u )
+}
+
+SCENARIO("Cancelling a thread pool drops the tasks not started yet", "cancel")
+{
+    GIVEN( auto pool = ThreadPool(1u) )
+    THEN( RunsUntilCancelled(pool, 100u, 9u) == 10u
+        , RunsUntilCancelled(pool, 100u, 200u) == 100u )
+}
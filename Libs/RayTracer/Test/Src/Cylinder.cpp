@@ -136,3 +136,11 @@ PSCENARIO(CapsT, "A capped cylinder bounds", "shape,cylinder")
     WHEN( auto const& b = cyl->GetBounds() )
     THEN( b == Bounds(Point(-1.f, GetParam().first, -1.f), Point(1.f, GetParam().second, 1.f)) )
 }
+
+SCENARIO("Occlusion queries against the caps of a closed cylinder", "shape,cylinder")
+{
+    GIVEN( auto const cyl = std::make_shared<Cylinder>(1.f, 2.f, true)
+         , auto const r = Ray(Point(0.f, 5.f, 0.f), Vector(0.f, -1.f, 0.f)) )
+    THEN( cyl->IntersectsBefore(r, 3.5f)
+        , !cyl->IntersectsBefore(r, 2.5f) )
+}
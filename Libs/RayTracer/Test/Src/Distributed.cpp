@@ -0,0 +1,318 @@
+#if !defined(_WIN32)
+
+#include "TestHelpers.h"
+
+#include <RayTracer/Camera.h>
+#include <RayTracer/Distributed.h>
+#include <RayTracer/Transformations.h>
+#include <RayTracer/Util.h>
+
+#include <Beddev/Beddev.h>
+
+#include <atomic>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace
+{
+    constexpr static char const* g_scene = R"(
+{
+    "objects": [{
+        "name": "Floor",
+        "type": "Plane",
+        "material": {
+            "reflective": 0.3,
+            "pattern": {
+                "type": "Checker",
+                "pattern_a": { "type": "Solid", "color": [1, 1, 1] },
+                "pattern_b": { "type": "Solid", "color": [0.2, 0.2, 0.2] }
+            }
+        }
+    },{
+        "name": "Ball",
+        "type": "Sphere",
+        "position": [0, 1, 0]
+    },{
+        "name": "SmallBall",
+        "type": "Sphere",
+        "position": [1.5, 0.5, -0.5],
+        "scaling": [0.5, 0.5, 0.5]
+    }],
+    "lights": [{
+        "name": "sun",
+        "type": "PointLight",
+        "position": [-10, 10, -10],
+        "intensity": [1, 1, 1]
+    }]
+})";
+
+    // Unique to the test process, so tests can run side by side
+    std::string UnixAddress(char const* name)
+    {
+        return "unix:/tmp/raytracer-" + std::to_string(getpid()) + "-" + name + ".sock";
+    }
+
+    Camera DistributedCamera()
+    {
+        Camera c(37, 29, PI / 2.f);
+        c.SetTransform(matrix::View(Point(0.f, 1.5f, -5.f), Point(0.f, 1.f, 0.f), Vector(0.f, 1.f, 0.f)));
+        return c;
+    }
+
+    RenderSettings Settings(uint32_t samples, uint32_t maxSamples)
+    {
+        RenderSettings settings;
+        settings.m_tileSize = 8u;
+        settings.m_samplesPerPixel = samples;
+        settings.m_maxSamplesPerPixel = maxSamples;
+        return settings;
+    }
+
+    Canvas RenderLocally(RenderSettings const& settings)
+    {
+        World w;
+        std::istringstream is(g_scene);
+        w.Load(is);
+        return DistributedCamera().Render(w, settings);
+    }
+
+    // Takes a job and its first tiles, then disconnects without sending them
+    // back
+    void DyingWorker(std::string const& address)
+    {
+        auto const connection = RenderConnection::Connect(address);
+        RenderMessage message;
+        while (connection->Receive(message) && (message.m_type != RenderMessage::Type::Tiles))
+        {
+        }
+    }
+
+    // Takes a job and its first tiles, then stays connected without sending
+    // them back, or after sending only the start of their pixels
+    void StallingWorker(std::string const& address, bool partial)
+    {
+        auto const connection = RenderConnection::Connect(address);
+        RenderMessage message;
+        while (connection->Receive(message) && (message.m_type != RenderMessage::Type::Tiles))
+        {
+        }
+        if (partial)
+        {
+            // Pixels with a 64 byte payload, of which only 4 bytes come
+            uint8_t const bytes[12] = { 2u, 0u, 0u, 0u, 64u, 0u, 0u, 0u, 0u, 0u, 0u, 0u };
+            write(connection->Socket(), bytes, sizeof(bytes));
+        }
+        // Until the coordinator drops it
+        while (connection->Receive(message))
+        {
+        }
+    }
+
+    struct Outcome
+    {
+        std::optional<Canvas> m_image; // not set if the render threw
+        uint32_t m_workersLeft = 0u;
+        uint32_t m_workersQuit = 0u;   // told to by the coordinator
+        uint32_t m_workersFailed = 0u; // threw
+    };
+
+    // Renders the scene with worker threads in place of worker processes,
+    // the dying or stalling ones joining last
+    Outcome RenderDistributed(std::string const& address, uint32_t workers, uint32_t dying, RenderSettings const& settings, uint32_t stalling = 0u)
+    {
+        Outcome outcome;
+        std::atomic<uint32_t> quit = 0u;
+        std::vector<std::thread> threads;
+        {
+            RenderCoordinator coordinator(address, 2u, 2.);
+            std::string const bound = coordinator.Address();
+            for (uint32_t i = 0u; i < workers; i++)
+            {
+                threads.emplace_back([&quit, bound]() { quit += RunRenderWorker(bound, 1u) ? 1u : 0u; });
+            }
+            coordinator.WaitForWorkers(workers, 10.);
+            for (uint32_t i = 0u; i < dying; i++)
+            {
+                threads.emplace_back(DyingWorker, bound);
+            }
+            for (uint32_t i = 0u; i < stalling; i++)
+            {
+                threads.emplace_back(StallingWorker, bound, (i % 2u) == 1u);
+            }
+            coordinator.WaitForWorkers(workers + dying + stalling, 10.);
+
+            try
+            {
+                outcome.m_image.emplace(coordinator.Render(g_scene, DistributedCamera(), settings));
+            }
+            catch (std::runtime_error const&)
+            {
+            }
+            outcome.m_workersLeft = coordinator.WorkerCount();
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        outcome.m_workersQuit = quit;
+        return outcome;
+    }
+
+    // Renders a scene workers can't load, which they throw on
+    Outcome RenderUnloadable(std::string const& address, uint32_t workers)
+    {
+        Outcome outcome;
+        std::atomic<uint32_t> failed = 0u;
+        std::vector<std::thread> threads;
+        {
+            RenderCoordinator coordinator(address);
+            std::string const bound = coordinator.Address();
+            for (uint32_t i = 0u; i < workers; i++)
+            {
+                threads.emplace_back([&failed, bound]() {
+                    try
+                    {
+                        RunRenderWorker(bound, 1u);
+                    }
+                    catch (std::runtime_error const&)
+                    {
+                        failed++;
+                    }
+                });
+            }
+            coordinator.WaitForWorkers(workers, 10.);
+
+            try
+            {
+                outcome.m_image.emplace(coordinator.Render(R"({ "objects": [{ "name": "Pot", "type": "Teapot" }] })", DistributedCamera()));
+            }
+            catch (std::runtime_error const&)
+            {
+            }
+            outcome.m_workersLeft = coordinator.WorkerCount();
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        outcome.m_workersFailed = failed;
+        return outcome;
+    }
+
+    bool IsRejected(std::string const& scene, RenderSettings const& settings)
+    {
+        RenderCoordinator coordinator(UnixAddress("rejected"));
+        try
+        {
+            coordinator.Render(scene, DistributedCamera(), settings);
+        }
+        catch (std::runtime_error const&)
+        {
+            return true;
+        }
+        return false;
+    }
+
+    RenderSettings WithSampler()
+    {
+        RenderSettings settings;
+        settings.m_sampler = std::make_shared<SobolSampler>();
+        return settings;
+    }
+
+    bool CantConnect(std::string const& address)
+    {
+        try
+        {
+            RenderConnection::Connect(address);
+        }
+        catch (std::runtime_error const&)
+        {
+            return true;
+        }
+        return false;
+    }
+}
+
+SCENARIO("Distributed renders match local ones", "distributed")
+{
+    GIVEN( auto const settings = Settings(1u, 0u)
+         , auto const local = RenderLocally(settings) )
+    WHEN( auto const outcome = RenderDistributed(UnixAddress("match"), 3u, 0u, settings) )
+    THEN( outcome.m_image.has_value()
+        , SameImage(*outcome.m_image, local)
+        , outcome.m_workersLeft == 3u
+        , outcome.m_workersQuit == 3u )
+}
+
+SCENARIO("Distributed renders work over TCP with adaptive sampling", "distributed")
+{
+    GIVEN( auto const settings = Settings(2u, 8u)
+         , auto const local = RenderLocally(settings) )
+    WHEN( auto const outcome = RenderDistributed("tcp:127.0.0.1:0", 2u, 0u, settings) )
+    THEN( outcome.m_image.has_value()
+        , SameImage(*outcome.m_image, local)
+        , outcome.m_workersQuit == 2u )
+}
+
+SCENARIO("Tiles of a worker dying mid-render are handed to the others", "distributed")
+{
+    GIVEN( auto const settings = Settings(1u, 0u)
+         , auto const local = RenderLocally(settings) )
+    WHEN( auto const outcome = RenderDistributed(UnixAddress("dying"), 2u, 2u, settings) )
+    THEN( outcome.m_image.has_value()
+        , SameImage(*outcome.m_image, local)
+        , outcome.m_workersLeft == 2u
+        , outcome.m_workersQuit == 2u )
+}
+
+SCENARIO("Tiles of a worker not replying in time are handed to the others", "distributed")
+{
+    GIVEN( auto const settings = Settings(1u, 0u)
+         , auto const local = RenderLocally(settings) )
+    WHEN( auto const outcome = RenderDistributed(UnixAddress("stalling"), 2u, 0u, settings, 2u) )
+    THEN( outcome.m_image.has_value()
+        , SameImage(*outcome.m_image, local)
+        , outcome.m_workersLeft == 2u
+        , outcome.m_workersQuit == 2u )
+}
+
+SCENARIO("Distributed renders fail once every worker is gone", "distributed")
+{
+    GIVEN( auto const settings = Settings(1u, 0u) )
+    WHEN( auto const outcome = RenderDistributed(UnixAddress("gone"), 0u, 1u, settings) )
+    THEN( !outcome.m_image.has_value()
+        , outcome.m_workersLeft == 0u )
+}
+
+SCENARIO("Distributed renders reject what workers can't render", "distributed")
+{
+    GIVEN( auto const settings = RenderSettings() )
+    THEN( IsRejected("not a scene", settings)
+        , IsRejected(g_scene, WithSampler())
+        , IsRejected(g_scene, settings) )
+}
+
+SCENARIO("Workers which can't load the scene are dropped", "distributed")
+{
+    WHEN( auto const outcome = RenderUnloadable(UnixAddress("unloadable"), 2u) )
+    THEN( !outcome.m_image.has_value()
+        , outcome.m_workersLeft == 0u
+        , outcome.m_workersFailed == 2u )
+}
+
+SCENARIO("Connecting to an address nothing listens at", "distributed")
+{
+    GIVEN( auto const address = UnixAddress("nothing") )
+    THEN( CantConnect(address)
+        , CantConnect("tcp:127.0.0.1")
+        , CantConnect("nowhere") )
+}
+
+#endif
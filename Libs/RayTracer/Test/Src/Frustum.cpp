@@ -0,0 +1,129 @@
+#include "TestHelpers.h"
+
+#include <RayTracer/Camera.h>
+#include <RayTracer/Frustum.h>
+#include <RayTracer/Shapes/Plane.h>
+#include <RayTracer/Shapes/Sphere.h>
+#include <RayTracer/TileCandidates.h>
+#include <RayTracer/Transformations.h>
+#include <RayTracer/Util.h>
+
+#include <Beddev/Beddev.h>
+
+namespace
+{
+    // Square pyramid looking down +z, 90 degrees wide
+    Frustum UnitFrustum()
+    {
+        return Frustum(Point(0.f, 0.f, 0.f), { Point(-1.f, -1.f, 1.f), Point(1.f, -1.f, 1.f), Point(1.f, 1.f, 1.f), Point(-1.f, 1.f, 1.f) });
+    }
+
+    Frustum::Overlap Classify(Frustum const& f, Tuple const& min, Tuple const& max)
+    {
+        return f.Classify(Bounds(min, max));
+    }
+
+    // Grid of spheres in front of a plane
+    World CullingWorld()
+    {
+        World w = SphereGrid(16);
+        w.Add(std::make_shared<Plane>());
+        w.BuildAccelerator();
+        return w;
+    }
+
+    Camera CullingCamera(uint32_t width, uint32_t height)
+    {
+        Camera c(width, height, PI / 3.f);
+        c.SetTransform(matrix::View(Point(22.5f, 22.5f, -60.f), Point(22.5f, 22.5f, 0.f), Vector(0.f, 1.f, 0.f)));
+        return c;
+    }
+
+    TileCandidates Collect(World& w, World::AcceleratorType type, Camera const& c, uint32_t x0, uint32_t y0)
+    {
+        w.SetAcceleratorType(type);
+        uint32_t const tileSize = RenderSettings().m_tileSize;
+        TileCandidates candidates;
+        w.CollectCandidates(c.TileFrustum(x0, y0, x0 + tileSize, y0 + tileSize), candidates);
+        return candidates;
+    }
+
+    bool SameRender(World& w, World::AcceleratorType type, uint32_t packetSize)
+    {
+        // Odd sizes, so tiles are clipped at the edges
+        w.SetAcceleratorType(type);
+        auto const c = CullingCamera(41, 23);
+        RenderSettings settings;
+        settings.m_packetSize = packetSize;
+        settings.m_frustumCulling = false;
+        auto const expected = c.Render(w, settings);
+        settings.m_frustumCulling = true;
+        auto const actual = c.Render(w, settings);
+        return SameImage(expected, actual);
+    }
+}
+
+SCENARIO("Classifying boxes against a frustum", "frustum")
+{
+    GIVEN( auto const f = UnitFrustum() )
+    THEN( Classify(f, Point(-.5f, -.5f, 4.f), Point(.5f, .5f, 5.f)) == Frustum::Overlap::Inside
+        , Classify(f, Point(1.5f, -.5f, 1.f), Point(2.5f, .5f, 2.f)) == Frustum::Overlap::Partial
+        , Classify(f, Point(-1.f, -1.f, -1.f), Point(1.f, 1.f, 1.f)) == Frustum::Overlap::Partial
+        , Classify(f, Point(5.f, -.5f, 1.f), Point(6.f, .5f, 2.f)) == Frustum::Overlap::Outside
+        , Classify(f, Point(-.5f, 10.f, 4.f), Point(.5f, 11.f, 5.f)) == Frustum::Overlap::Outside
+        , Classify(f, Point(-.5f, -.5f, -5.f), Point(.5f, .5f, -4.f)) == Frustum::Overlap::Outside )
+}
+
+SCENARIO("A tile frustum contains the primary rays of its pixels", "frustum")
+{
+    GIVEN( auto const c = CullingCamera(64, 48)
+         , auto const f = c.TileFrustum(16, 16, 32, 32) )
+    THEN( f.Origin() == c.RayForPixel(0, 0).Origin()
+        , f.Classify(Bounds(c.RayForPixel(16, 16).Position(10.f), c.RayForPixel(16, 16).Position(10.f))) == Frustum::Overlap::Inside
+        , f.Classify(Bounds(c.RayForPixel(31, 31).Position(10.f), c.RayForPixel(31, 31).Position(10.f))) == Frustum::Overlap::Inside
+        , f.Classify(Bounds(c.RayForPixel(33, 20).Position(10.f), c.RayForPixel(33, 20).Position(10.f))) == Frustum::Overlap::Outside
+        , f.Classify(Bounds(c.RayForPixel(20, 14).Position(10.f), c.RayForPixel(20, 14).Position(10.f))) == Frustum::Overlap::Outside )
+}
+
+SCENARIO("Tiles only keep the parts of a linear bvh within their frustum", "frustum")
+{
+    GIVEN( auto w = CullingWorld()
+         , auto const c = CullingCamera(160, 160) )
+    WHEN( auto const center = Collect(w, World::AcceleratorType::LinearBvh, c, 64, 64)
+        , auto const sky = Collect(w, World::AcceleratorType::LinearBvh, c, 0, 0) )
+    THEN( center.IsCulled()
+        , center.ObjectCount() == 1
+        , center.SubtreeCount() > 0
+        , center.SubtreeCount() <= LinearBvh::kMaxCandidates
+        , sky.SubtreeCount() == 0 )
+}
+
+SCENARIO("Tiles only keep the objects within their frustum", "frustum")
+{
+    GIVEN( auto w = CullingWorld()
+         , auto const c = CullingCamera(160, 160) )
+    WHEN( auto const center = Collect(w, World::AcceleratorType::None, c, 64, 64) )
+    THEN( center.IsCulled()
+        , center.ObjectCount() > 1
+        , center.ObjectCount() < w.Objects().size() / 4 )
+}
+
+SCENARIO("Accelerators that can't be culled are kept whole", "frustum")
+{
+    GIVEN( auto w = CullingWorld()
+         , auto const c = CullingCamera(160, 160) )
+    WHEN( auto const center = Collect(w, World::AcceleratorType::Bvh, c, 64, 64) )
+    THEN( !center.IsCulled()
+        , center.ObjectCount() == 0
+        , center.SubtreeCount() == 0 )
+}
+
+SCENARIO("Rendering with frustum culling gives the same image", "frustum")
+{
+    GIVEN( auto w = CullingWorld() )
+    THEN( SameRender(w, World::AcceleratorType::LinearBvh, 1u)
+        , SameRender(w, World::AcceleratorType::LinearBvh, 16u)
+        , SameRender(w, World::AcceleratorType::None, 1u)
+        , SameRender(w, World::AcceleratorType::None, 4u)
+        , SameRender(w, World::AcceleratorType::Bvh4, 8u) )
+}
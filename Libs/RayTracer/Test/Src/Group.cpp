@@ -5,6 +5,7 @@
 #include <RayTracer/Shapes/Cone.h>
 #include <RayTracer/Shapes/Cube.h>
 #include <RayTracer/Shapes/Group.h>
+#include <RayTracer/Shapes/ShapeFactory.h>
 #include <RayTracer/Shapes/Sphere.h>
 
 SCENARIO("Creating a new group", "shapes,groups")
@@ -48,10 +49,10 @@ SCENARIO("Intersecting a ray with an nonempty group", "shapes,groups")
     WHEN( auto xs = std::vector<Intersection>()
         , r.Intersect(g, xs) )
     THEN( xs.size() == 4
-        , xs[0].Object() == s2
-        , xs[1].Object() == s2
-        , xs[2].Object() == s1
-        , xs[3].Object() == s1 )
+        , xs[0].Object() == s2.get()
+        , xs[1].Object() == s2.get()
+        , xs[2].Object() == s1.get()
+        , xs[3].Object() == s1.get() )
 }
 
 SCENARIO("Intersecting a transformed group", "shapes,groups")
@@ -111,3 +112,152 @@ SCENARIO("The group's bounds are recalculated when a child is transformed", "sha
          , sphere->SetTransform(matrix::Scaling(2.f, 2.f, 2.f)) )
     THEN( g->GetBounds() == Bounds(Point(-2.f, -2.f, -2.f), Point(2.f, 2.f, 2.f)) )
 }
+
+SCENARIO("Partitioning a group's children", "shape,groups")
+{
+    GIVEN( auto const s1 = std::make_shared<Sphere>()
+         , s1->SetTransform(matrix::Translation(-2.f, 0.f, 0.f))
+         , auto const s2 = std::make_shared<Sphere>()
+         , s2->SetTransform(matrix::Translation(2.f, 0.f, 0.f))
+         , auto const s3 = std::make_shared<Sphere>()
+         , auto const g = std::make_shared<Group>()
+         , g->AddChild(s1)
+         , g->AddChild(s2)
+         , g->AddChild(s3) )
+    WHEN( auto const halves = g->PartitionChildren() )
+    THEN( g->Children().size() == 1
+        , g->Includes(s3)
+        , halves.first.size() == 1
+        , halves.first[0] == s1
+        , halves.second.size() == 1
+        , halves.second[0] == s2 )
+}
+
+SCENARIO("Creating a sub-group from a list of children", "shape,groups")
+{
+    GIVEN( auto const s1 = std::make_shared<Sphere>()
+         , auto const s2 = std::make_shared<Sphere>()
+         , auto const g = std::make_shared<Group>() )
+    WHEN( g->MakeSubgroup({ s1, s2 }) )
+    THEN( g->Children().size() == 1
+        , std::dynamic_pointer_cast<Group>(g->Children()[0])->Children().size() == 2
+        , std::dynamic_pointer_cast<Group>(g->Children()[0])->Includes(s1)
+        , std::dynamic_pointer_cast<Group>(g->Children()[0])->Includes(s2) )
+}
+
+SCENARIO("Subdividing a primitive does nothing", "shape,groups")
+{
+    GIVEN( auto const s = std::make_shared<Sphere>() )
+    WHEN( s->Divide(1) )
+    THEN( s->Parent() == nullptr )
+}
+
+SCENARIO("Subdividing a group partitions its children", "shape,groups")
+{
+    GIVEN( auto const s1 = std::make_shared<Sphere>()
+         , s1->SetTransform(matrix::Translation(-2.f, -2.f, 0.f))
+         , auto const s2 = std::make_shared<Sphere>()
+         , s2->SetTransform(matrix::Translation(-2.f, 2.f, 0.f))
+         , auto const s3 = std::make_shared<Sphere>()
+         , s3->SetTransform(matrix::Scaling(4.f, 4.f, 4.f))
+         , auto const g = std::make_shared<Group>()
+         , g->AddChild(s1)
+         , g->AddChild(s2)
+         , g->AddChild(s3) )
+    WHEN( g->Divide(1) )
+    THEN( g->Children().size() == 2
+        , g->Children()[0] == s3
+        , std::dynamic_pointer_cast<Group>(g->Children()[1])->Children().size() == 2
+        , std::dynamic_pointer_cast<Group>(std::dynamic_pointer_cast<Group>(g->Children()[1])->Children()[0])->Includes(s1)
+        , std::dynamic_pointer_cast<Group>(std::dynamic_pointer_cast<Group>(g->Children()[1])->Children()[1])->Includes(s2) )
+}
+
+SCENARIO("Subdividing a group with too few children", "shape,groups")
+{
+    GIVEN( auto const s1 = std::make_shared<Sphere>()
+         , s1->SetTransform(matrix::Translation(-2.f, 0.f, 0.f))
+         , auto const s2 = std::make_shared<Sphere>()
+         , s2->SetTransform(matrix::Translation(2.f, 1.f, 0.f))
+         , auto const s3 = std::make_shared<Sphere>()
+         , s3->SetTransform(matrix::Translation(2.f, -1.f, 0.f))
+         , auto const sub = std::make_shared<Group>()
+         , sub->AddChild(s1)
+         , sub->AddChild(s2)
+         , sub->AddChild(s3)
+         , auto const s4 = std::make_shared<Sphere>()
+         , auto const g = std::make_shared<Group>()
+         , g->AddChild(sub)
+         , g->AddChild(s4) )
+    WHEN( g->Divide(3) )
+    THEN( g->Children().size() == 2
+        , g->Children()[0] == sub
+        , g->Children()[1] == s4
+        , sub->Children().size() == 2
+        , std::dynamic_pointer_cast<Group>(sub->Children()[0])->Children().size() == 1
+        , std::dynamic_pointer_cast<Group>(sub->Children()[0])->Includes(s1)
+        , std::dynamic_pointer_cast<Group>(sub->Children()[1])->Children().size() == 2 )
+}
+
+SCENARIO("Shapes sharing the same bounds are not subdivided", "shape,groups")
+{
+    GIVEN( auto const s1 = std::make_shared<Sphere>()
+         , auto const s2 = std::make_shared<Sphere>()
+         , auto const g = std::make_shared<Group>()
+         , g->AddChild(s1)
+         , g->AddChild(s2) )
+    WHEN( g->Divide(1) )
+    THEN( g->Children().size() == 2
+        , g->Includes(s1)
+        , g->Includes(s2) )
+}
+
+SCENARIO("A subdivided group is intersected like the original one", "shape,groups")
+{
+    GIVEN( auto const g = ShapeFactory::Get().Create(R"({
+            "type": "Group",
+            "subdivide": 2,
+            "children": [
+                { "type": "Sphere", "position": [-4, 0, 0] },
+                { "type": "Sphere", "position": [-2, 0, 0] },
+                { "type": "Sphere", "position": [ 2, 0, 0] },
+                { "type": "Sphere", "position": [ 4, 0, 0] } ]
+         })"_json)
+         , auto const r = Ray(Point(-6.f, 0.f, 0.f), Vector(1.f, 0.f, 0.f)) )
+    WHEN( auto xs = std::vector<Intersection>()
+        , r.Intersect(g, xs) )
+    THEN( std::dynamic_pointer_cast<Group>(g)->Children().size() == 2
+        , xs.size() == 8
+        , xs[0].Distance() == 1.f
+        , xs[7].Distance() == 11.f )
+}
+
+SCENARIO("Occlusion queries against a group skip children not casting shadows", "shape,groups")
+{
+    GIVEN( auto const s1 = std::make_shared<Sphere>()
+         , auto const s2 = std::make_shared<Sphere>()
+         , s2->SetTransform(matrix::Translation(0.f, 0.f, 4.f))
+         , s1->CastShadows(false)
+         , auto const g = std::make_shared<Group>()
+         , g->AddChild(s1)
+         , g->AddChild(s2)
+         , auto const r = Ray(Point(0.f, 0.f, -5.f), Vector(0.f, 0.f, 1.f)) )
+    THEN( !g->IntersectsBefore(r, 6.f)
+        , g->IntersectsBefore(r, 10.f) )
+}
+
+SCENARIO("Subgroups without shadow casters don't cast shadows", "shape,groups")
+{
+    GIVEN( auto const g = ShapeFactory::Get().Create(R"({
+            "type": "Group",
+            "subdivide": 2,
+            "children": [
+                { "type": "Sphere", "position": [-4, 0, 0], "cast_shadows": false },
+                { "type": "Sphere", "position": [-2, 0, 0], "cast_shadows": false },
+                { "type": "Sphere", "position": [ 2, 0, 0] },
+                { "type": "Sphere", "position": [ 4, 0, 0], "cast_shadows": false } ]
+         })"_json) )
+    WHEN( auto const& children = std::dynamic_pointer_cast<Group>(g)->Children() )
+    THEN( children.size() == 2
+        , !children[0]->CastShadows()
+        , children[1]->CastShadows() )
+}
@@ -0,0 +1,215 @@
+#include "TestHelpers.h"
+
+#include <RayTracer/Shapes/Group.h>
+#include <RayTracer/Shapes/Instance.h>
+#include <RayTracer/Shapes/Sphere.h>
+#include <RayTracer/Transformations.h>
+#include <RayTracer/World.h>
+
+#include <Beddev/Beddev.h>
+
+#include <sstream>
+
+namespace
+{
+
+    constexpr static char const* g_instancedWorld = R"(
+{
+    "objects": [{
+        "archetype": "Pair",
+        "position": [-2, 0, 0]
+    },{
+        "archetype": "Pair",
+        "position": [2, 0, 0],
+        "rotation": [0, 0.5, 0]
+    },{
+        "archetype": "Pair",
+        "position": [0, 2, 0],
+        "scaling": [0.5, 0.5, 0.5],
+        "material": { "pattern": { "type": "Solid", "color": [1, 0, 0] } }
+    }],
+    "lights": [{
+        "type" : "PointLight",
+        "position" : [-10, 10, -10],
+        "intensity" : [1, 1, 1]
+    }],
+    "archetypes": [{
+        "name": "Pair",
+        "type": "Group",
+        "children": [{
+            "type" : "Sphere",
+            "position": [0, 0, -0.5],
+            "scaling": [0.5, 0.5, 0.5]
+        },{
+            "type": "Cube",
+            "position": [0, 0, 0.5],
+            "scaling": [0.5, 0.5, 0.5]
+        }]
+    }]
+})";
+
+    // Same scene as above, written without archetypes
+    constexpr static char const* g_copiedWorld = R"(
+{
+    "objects": [{
+        "type": "Group",
+        "position": [-2, 0, 0],
+        "children": [
+            { "type" : "Sphere", "position": [0, 0, -0.5], "scaling": [0.5, 0.5, 0.5] },
+            { "type" : "Cube", "position": [0, 0, 0.5], "scaling": [0.5, 0.5, 0.5] }
+        ]
+    },{
+        "type": "Group",
+        "position": [2, 0, 0],
+        "rotation": [0, 0.5, 0],
+        "children": [
+            { "type" : "Sphere", "position": [0, 0, -0.5], "scaling": [0.5, 0.5, 0.5] },
+            { "type" : "Cube", "position": [0, 0, 0.5], "scaling": [0.5, 0.5, 0.5] }
+        ]
+    },{
+        "type": "Group",
+        "position": [0, 2, 0],
+        "scaling": [0.5, 0.5, 0.5],
+        "children": [{
+            "type" : "Sphere",
+            "position": [0, 0, -0.5],
+            "scaling": [0.5, 0.5, 0.5],
+            "material": { "pattern": { "type": "Solid", "color": [1, 0, 0] } }
+        },{
+            "type" : "Cube",
+            "position": [0, 0, 0.5],
+            "scaling": [0.5, 0.5, 0.5],
+            "material": { "pattern": { "type": "Solid", "color": [1, 0, 0] } }
+        }]
+    }],
+    "lights": [{
+        "type" : "PointLight",
+        "position" : [-10, 10, -10],
+        "intensity" : [1, 1, 1]
+    }]
+})";
+
+    World LoadWorld(char const* scene)
+    {
+        World w;
+        std::istringstream ss(scene);
+        w.Load(ss);
+        return w;
+    }
+
+    std::shared_ptr<Instance const> AsInstance(ShapePtr const& shape)
+    {
+        return std::dynamic_pointer_cast<Instance const>(shape);
+    }
+
+    bool SameColors(World const& a, World const& b, Ray const& r)
+    {
+        return a.ColorAt(r) == b.ColorAt(r);
+    }
+
+}
+
+SCENARIO("Compiling a group into an instance prototype", "instance")
+{
+    GIVEN( auto g = std::make_shared<Group>()
+         , g->SetTransform(matrix::Translation(5.f, 0.f, 0.f))
+         , auto s1 = std::make_shared<Sphere>()
+         , s1->SetTransform(matrix::Translation(-2.f, 0.f, 0.f))
+         , auto s2 = std::make_shared<Sphere>()
+         , s2->SetTransform(matrix::Translation(2.f, 0.f, 0.f))
+         , g->AddChild(s1)
+         , g->AddChild(s2) )
+    WHEN( auto const prototype = Instance::Compile(g) )
+    THEN( prototype->m_root == g
+        , g->Transform() == Mat44::Identity()
+        , prototype->m_bvh.GetBounds() == Bounds(Point(-3.f, -1.f, -1.f), Point(3.f, 1.f, 1.f)) )
+}
+
+SCENARIO("An instance takes its bounds from its prototype", "instance")
+{
+    GIVEN( auto const prototype = Instance::Compile(std::make_shared<Sphere>()) )
+    WHEN( auto const instance = std::make_shared<Instance>(prototype)
+        , instance->SetTransform(matrix::Translation(3.f, 0.f, 0.f)) )
+    THEN( instance->GetBounds() == Bounds(Point(-1.f, -1.f, -1.f), Point(1.f, 1.f, 1.f))
+        , instance->Prototype() == prototype )
+}
+
+SCENARIO("Intersecting a ray with an instance", "instance")
+{
+    GIVEN( auto const prototype = Instance::Compile(std::make_shared<Sphere>())
+         , auto const instance = std::make_shared<Instance>(prototype)
+         , instance->SetTransform(matrix::Translation(0.f, 0.f, 5.f))
+         , auto const r = Ray(Point(0.f, 0.f, -5.f), Vector(0.f, 0.f, 1.f))
+         , std::vector<Intersection> xs )
+    WHEN( r.Intersect(instance, xs) )
+    THEN( xs.size() == 2
+        , xs[0].Distance() == 9.f
+        , xs[1].Distance() == 11.f
+        , xs[0].Object() == prototype->m_root.get()
+        , xs[0].Instance() == instance.get()
+        , xs[1].Instance() == instance.get() )
+}
+
+SCENARIO("Computing the normal of an object hit through an instance", "instance")
+{
+    GIVEN( auto const prototype = Instance::Compile(std::make_shared<Sphere>())
+         , auto const instance = std::make_shared<Instance>(prototype)
+         , instance->SetTransform(matrix::Translation(0.f, 1.f, 0.f))
+         , auto const r = Ray(Point(0.f, 1.70711f, -5.f), Vector(0.f, 0.f, 1.f))
+         , std::vector<Intersection> xs )
+    WHEN( r.Intersect(instance, xs)
+        , auto const data = r.Precompute(Hit(xs), xs) )
+    THEN( data.m_instance == instance.get()
+        , data.m_normalv == Vector(0.f, 0.70711f, -0.70711f) )
+}
+
+SCENARIO("Loading a world shares a single prototype between all references", "instance")
+{
+    GIVEN( auto const w = LoadWorld(g_instancedWorld) )
+    THEN( w.Objects().size() == 3
+        , AsInstance(w.Objects()[0]) != nullptr
+        , AsInstance(w.Objects()[1]) != nullptr
+        , AsInstance(w.Objects()[2]) != nullptr
+        , AsInstance(w.Objects()[0])->Prototype() == AsInstance(w.Objects()[1])->Prototype()
+        , AsInstance(w.Objects()[0])->Prototype() == AsInstance(w.Objects()[2])->Prototype()
+        , !AsInstance(w.Objects()[0])->OverridesMaterial()
+        , AsInstance(w.Objects()[2])->OverridesMaterial() )
+}
+
+SCENARIO("The material of an instance overrides the one of its prototype", "instance")
+{
+    GIVEN( auto const w = LoadWorld(g_instancedWorld)
+         , auto const r = Ray(Point(0.f, 2.f, -5.f), Vector(0.f, 0.f, 1.f))
+         , std::vector<Intersection> xs )
+    WHEN( r.Intersect(w, xs) )
+    THEN( xs.size() == 4
+        , xs[0].Instance() == w.Objects()[2].get()
+        , xs[0].GetMaterial().Pattern()->ColorAt(Point(0.f, 0.f, 0.f)) == Color(1.f, 0.f, 0.f)
+        , xs[0].Object()->GetMaterial().Pattern()->ColorAt(Point(0.f, 0.f, 0.f)) == Color(1.f, 1.f, 1.f) )
+}
+
+SCENARIO("An instanced world looks the same as a copied one", "instance")
+{
+    GIVEN( auto const instanced = LoadWorld(g_instancedWorld)
+         , auto const copied = LoadWorld(g_copiedWorld) )
+    THEN( SameColors(instanced, copied, Ray(Point(-2.f, 0.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameColors(instanced, copied, Ray(Point(-2.f, 0.3f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameColors(instanced, copied, Ray(Point(2.f, 0.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameColors(instanced, copied, Ray(Point(2.2f, 0.2f, 5.f), Vector(0.f, 0.f, -1.f)))
+        , SameColors(instanced, copied, Ray(Point(0.1f, 2.1f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameColors(instanced, copied, Ray(Point(-5.f, 0.1f, -0.4f), Vector(1.f, 0.f, 0.f)))
+        , SameColors(instanced, copied, Ray(Point(-5.f, 5.f, -5.f), Vector(1.f, -1.f, 1.f).Normalized())) )
+}
+
+SCENARIO("Archetype references overriding shape properties are copied", "instance")
+{
+    GIVEN( auto w = World()
+         , std::istringstream ss(R"({
+                "objects": [{ "archetype": "Ball", "radius_hint": 2 }],
+                "archetypes": [{ "name": "Ball", "type": "Sphere" }]
+            })") )
+    WHEN( w.Load(ss) )
+    THEN( w.Objects().size() == 1
+        , AsInstance(w.Objects()[0]) == nullptr
+        , std::dynamic_pointer_cast<Sphere>(w.Objects()[0]) != nullptr )
+}
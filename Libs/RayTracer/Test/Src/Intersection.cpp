@@ -4,6 +4,7 @@
 #include <RayTracer/Ray.h>
 #include <RayTracer/Shapes/Plane.h>
 #include <RayTracer/Shapes/Sphere.h>
+#include <RayTracer/Transformations.h>
 #include <RayTracer/Util.h>
 
 #include <Beddev/Beddev.h>
@@ -13,7 +14,7 @@ SCENARIO("An intersection encapsulates the distance from the ray origin and the
     GIVEN( auto const s = std::make_shared<Sphere>() )
     WHEN( auto const i = Intersection(3.5f, s) )
     THEN( i.Distance() == 3.5f
-        , i.Object() == s )
+        , i.Object() == s.get() )
 }
 
 SCENARIO("Agregating intersections", "math")
@@ -34,8 +35,8 @@ SCENARIO("Intersect sets the object on the intersection", "math")
     WHEN( std::vector<Intersection> xs = {}
         , r.Intersect(s, xs) )
     THEN( xs.size() == 2
-        , xs[0].Object() == s
-        , xs[1].Object() == s )
+        , xs[0].Object() == s.get()
+        , xs[1].Object() == s.get() )
 }
 
 SCENARIO("The hit, when all intersections have positive t", "math")
@@ -130,6 +131,73 @@ PSCENARIO(ArgT, "Finding n1 and n2 at various intersections", "refraction")
         , comps.m_n2 == arg.n2 )
 }
 
+namespace
+{
+    // Concentric glassy spheres, each one denser than the one containing it
+    std::vector<ShapePtr> NestedGlassySpheres(int count)
+    {
+        std::vector<ShapePtr> spheres;
+        for (int k = 0; k < count; k++)
+        {
+            auto s = GlassySphere();
+            float const radius = static_cast<float>(count - k);
+            s->SetTransform(matrix::Scaling(radius, radius, radius));
+            s->ModifyMaterial().RefractiveIndex(1.f + (.1f * (k + 1)));
+            spheres.push_back(s);
+        }
+        return spheres;
+    }
+
+    std::vector<Intersection> IntersectAll(Ray const& r, std::vector<ShapePtr> const& shapes)
+    {
+        std::vector<Intersection> xs;
+        for (auto const& s : shapes)
+        {
+            r.Intersect(s, xs);
+        }
+        std::sort(xs.begin(), xs.end());
+        return xs;
+    }
+}
+
+SCENARIO("n1 and n2 are not computed for opaque hits", "refraction")
+{
+    GIVEN( auto a = GlassySphere()
+         , a->SetTransform(matrix::Scaling(2.f, 2.f, 2.f))
+         , auto b = std::make_shared<Sphere>()
+         , b->ModifyMaterial().RefractiveIndex(2.f)
+         , auto const r = Ray(Point(0.f, 0.f, -4.f), Vector(0.f, 0.f, 1.f))
+         , auto const xs = Intersections(
+             Intersection{ 2.f, a }, Intersection{ 3.f, b },
+             Intersection{ 5.f, b }, Intersection{ 6.f, a }) )
+    WHEN( auto const comps = r.Precompute(xs[1], xs) )
+    THEN( comps.m_n1 == 1.f
+        , comps.m_n2 == 1.f )
+}
+
+SCENARIO("Finding n1 and n2 through deeply nested objects", "refraction")
+{
+    GIVEN( auto const spheres = NestedGlassySpheres(20)
+         , auto const r = Ray(Point(0.f, 0.f, -25.f), Vector(0.f, 0.f, 1.f))
+         , auto const xs = IntersectAll(r, spheres) )
+    WHEN( auto const entering = r.Precompute(xs[19], xs)
+        , auto const exiting = r.Precompute(xs[20], xs) )
+    THEN( xs.size() == 40
+        , xs[19].Object() == spheres[19].get()
+        , Equals(entering.m_n1, 2.9f)
+        , Equals(entering.m_n2, 3.f)
+        , Equals(exiting.m_n1, 3.f)
+        , Equals(exiting.m_n2, 2.9f) )
+}
+
+SCENARIO("Finding n1 and n2 does no heap allocations", "refraction")
+{
+    GIVEN( auto const spheres = NestedGlassySpheres(20)
+         , auto const r = Ray(Point(0.f, 0.f, -25.f), Vector(0.f, 0.f, 1.f))
+         , auto const xs = IntersectAll(r, spheres) )
+    THEN( CountAllocations([&]() { r.Precompute(xs[30], xs); }) == 0u )
+}
+
 SCENARIO("The under point is offset below the surface", "refraction")
 {
     GIVEN( auto const r = Ray(Point(0.f, 0.f, -5.f), Vector(0.f, 0.f, 1.f))
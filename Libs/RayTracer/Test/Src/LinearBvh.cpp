@@ -0,0 +1,67 @@
+#include "TestHelpers.h"
+
+#include <RayTracer/Bvh.h>
+#include <RayTracer/LinearBvh.h>
+#include <RayTracer/Shapes/Plane.h>
+#include <RayTracer/Shapes/Sphere.h>
+#include <RayTracer/Transformations.h>
+#include <RayTracer/World.h>
+
+#include <Beddev/Beddev.h>
+
+SCENARIO("An empty linear bvh", "bvh")
+{
+    GIVEN( auto const bvh = LinearBvh() )
+    THEN( bvh.NodeCount() == 0
+        , bvh.GetBounds() == Bounds::Empty() )
+}
+
+SCENARIO("Flattening a bvh keeps its bounds and batches small subtrees", "bvh")
+{
+    GIVEN( auto const w = SphereGrid(16)
+         , auto const bvh = Bvh(w.Objects()) )
+    WHEN( auto const linear = LinearBvh(bvh) )
+    THEN( linear.NodeCount() + linear.BatchCount() <= bvh.NodeCount()
+        , linear.BatchCount() > 0
+        , linear.GetBounds() == bvh.GetBounds() )
+}
+
+SCENARIO("Intersecting a world through its linear bvh gives the same result as brute force", "bvh")
+{
+    GIVEN( auto w = SphereGrid(8)
+         , w.Add(std::make_shared<Plane>())
+         , w.BuildAccelerator()
+         , w.SetAcceleratorType(World::AcceleratorType::LinearBvh) )
+    THEN( w.GetLinearBvh() != nullptr
+        , w.GetAccelerator() == w.GetLinearBvh()
+        , SameIntersections(w, World::AcceleratorType::LinearBvh, Ray(Point(0.f, 0.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameIntersections(w, World::AcceleratorType::LinearBvh, Ray(Point(9.f, 6.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameIntersections(w, World::AcceleratorType::LinearBvh, Ray(Point(-5.f, 0.f, 0.f), Vector(1.f, 0.f, 0.f)))
+        , SameIntersections(w, World::AcceleratorType::LinearBvh, Ray(Point(25.f, 25.f, .5f), Vector(-1.f, -1.f, 0.f).Normalized()))
+        , SameIntersections(w, World::AcceleratorType::LinearBvh, Ray(Point(10.f, 10.f, 10.f), Vector(.1f, .2f, -1.f).Normalized()))
+        , SameIntersections(w, World::AcceleratorType::LinearBvh, Ray(Point(1.5f, 1.5f, -5.f), Vector(0.f, 0.f, 1.f))) )
+}
+
+SCENARIO("Closest hit queries through a linear bvh give the same result as brute force", "bvh")
+{
+    GIVEN( auto w = SphereGrid(8)
+         , w.Add(std::make_shared<Plane>())
+         , w.BuildAccelerator() )
+    THEN( SameClosestHit(w, World::AcceleratorType::LinearBvh, Ray(Point(0.f, 0.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameClosestHit(w, World::AcceleratorType::LinearBvh, Ray(Point(9.f, 6.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameClosestHit(w, World::AcceleratorType::LinearBvh, Ray(Point(-5.f, 0.f, 0.f), Vector(1.f, 0.f, 0.f)))
+        , SameClosestHit(w, World::AcceleratorType::LinearBvh, Ray(Point(25.f, 25.f, .5f), Vector(-1.f, -1.f, 0.f).Normalized()))
+        , SameClosestHit(w, World::AcceleratorType::LinearBvh, Ray(Point(10.f, 10.f, 10.f), Vector(.1f, .2f, -1.f).Normalized()))
+        , SameClosestHit(w, World::AcceleratorType::LinearBvh, Ray(Point(3.f, 3.f, 0.f), Vector(0.f, 0.f, 1.f))) )
+}
+
+SCENARIO("Shadow queries through a linear bvh give the same result as brute force", "bvh")
+{
+    GIVEN( auto w = SphereGrid(8)
+         , w.BuildAccelerator() )
+    THEN( SameShadows(w, World::AcceleratorType::LinearBvh, Point(0.f, 0.f, 1.f))
+        , SameShadows(w, World::AcceleratorType::LinearBvh, Point(3.f, 3.f, 2.f))
+        , SameShadows(w, World::AcceleratorType::LinearBvh, Point(21.f, 21.f, 5.f))
+        , SameShadows(w, World::AcceleratorType::LinearBvh, Point(30.f, 0.f, -2.f))
+        , SameShadows(w, World::AcceleratorType::LinearBvh, Point(-1.f, 1.f, -1.f)) )
+}
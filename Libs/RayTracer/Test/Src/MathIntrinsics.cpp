@@ -0,0 +1,161 @@
+#include <RayTracer/MathIntrinsics.h>
+#include <RayTracer/Matrix.h>
+#include <RayTracer/Transformations.h>
+#include <RayTracer/Tuple.h>
+#include <RayTracer/Util.h>
+
+#include <Beddev/Beddev.h>
+
+// The SSE kernels must give the same results as the scalar reference ones
+#ifdef USE_SSE
+
+namespace
+{
+    using Kernel2 = void(*)(float const*, float const*, float*);
+
+    bool SameFloats(float const* a, float const* b, int count)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            if (!Equals(a[i], b[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool SameResults(Kernel2 scalar, Kernel2 sse, Tuple const& a, Tuple const& b)
+    {
+        float expected[4];
+        float actual[4];
+        scalar(a.Data(), b.Data(), expected);
+        sse(a.Data(), b.Data(), actual);
+        return SameFloats(expected, actual, 4);
+    }
+
+    bool SameNormalized(Tuple const& a)
+    {
+        float expected[4];
+        float actual[4];
+        math::scalar::Normalize(a.Data(), expected);
+        math::sse::Normalize(a.Data(), actual);
+        return SameFloats(expected, actual, 4);
+    }
+
+    bool SameMatrixTuple(Mat44 const& m, Tuple const& t)
+    {
+        float expected[4];
+        float actual[4];
+        math::scalar::MulMat44Vec(m.Data(), t.Data(), expected);
+        math::sse::MulMat44Vec(m.Data(), t.Data(), actual);
+        return SameFloats(expected, actual, 4);
+    }
+
+    bool SameMatrixProduct(Mat44 const& a, Mat44 const& b)
+    {
+        float expected[16];
+        float actual[16];
+        math::scalar::MulMat44(a.Data(), b.Data(), expected);
+        math::sse::MulMat44(a.Data(), b.Data(), actual);
+        return SameFloats(expected, actual, 16);
+    }
+
+    // Rays along one axis. Those starting in the plane of a slab and
+    // parallel to it give 0 * inf, a NaN distance.
+    float const kOrigins[4] = { -5.f, 1.f, 2.f, 3.f };
+    float const kInwards[4] = { 1.f, -1.f, .5f, -.25f };
+    float const kInPlane[4] = { 1.f, 1.f, 2.f, 3.f };
+    float const kParallel[4] = { INF, -INF, INF, -INF };
+
+    // Each lane of the SSE slab test against the scalar one, for rays given
+    // as origin and inverse direction along one axis
+    bool SameSlabs(float min, float max, float const* origin, float const* invDir)
+    {
+        __m128 lo = _mm_set1_ps(0.f);
+        __m128 hi = _mm_set1_ps(10.f);
+        math::sse::Slab(_mm_set1_ps(min), _mm_set1_ps(max), _mm_loadu_ps(origin), _mm_loadu_ps(invDir), lo, hi);
+        float actualLo[4];
+        float actualHi[4];
+        _mm_storeu_ps(actualLo, lo);
+        _mm_storeu_ps(actualHi, hi);
+        uint32_t expectedHits = 0u;
+        for (uint32_t lane = 0u; lane < 4u; lane++)
+        {
+            float expectedLo = 0.f;
+            float expectedHi = 10.f;
+            math::scalar::Slab(min, max, origin[lane], invDir[lane], expectedLo, expectedHi);
+            if (!(expectedLo == actualLo[lane]) || !(expectedHi == actualHi[lane]))
+            {
+                return false;
+            }
+            expectedHits |= (expectedLo <= expectedHi) ? (1u << lane) : 0u;
+        }
+        return math::sse::SlabHits(lo, hi) == expectedHits;
+    }
+
+    Mat44 SomeTransform()
+    {
+        return matrix::Translation(1.f, -2.f, 3.f) * matrix::RotationX(.3f) * matrix::Scaling(2.f, .5f, 3.f);
+    }
+}
+
+SCENARIO("SSE and scalar element wise kernels agree", "simd")
+{
+    GIVEN( auto const a = Tuple(1.5f, -2.25f, 3.f, 1.f)
+         , auto const b = Tuple(-4.f, .5f, 10.f, 0.f) )
+    THEN( SameResults(math::scalar::Add, math::sse::Add, a, b)
+        , SameResults(math::scalar::Sub, math::sse::Sub, a, b)
+        , SameResults(math::scalar::Mul, math::sse::Mul, a, b) )
+}
+
+SCENARIO("SSE and scalar dot and cross products agree", "simd")
+{
+    GIVEN( auto const a = Vector(1.f, 2.f, 3.f)
+         , auto const b = Vector(2.f, 3.f, 4.f)
+         , auto const p = Tuple(-1.5f, 7.f, .25f, 1.f) )
+    THEN( Equals(math::scalar::Dot(a.Data(), b.Data()), math::sse::Dot(a.Data(), b.Data()))
+        , Equals(math::scalar::Dot(p.Data(), b.Data()), math::sse::Dot(p.Data(), b.Data()))
+        , SameResults(math::scalar::Cross, math::sse::Cross, a, b)
+        , SameResults(math::scalar::Cross, math::sse::Cross, p, b) )
+}
+
+SCENARIO("SSE and scalar normalization agree", "simd")
+{
+    THEN( SameNormalized(Vector(4.f, 0.f, 0.f))
+        , SameNormalized(Vector(1.f, 2.f, 3.f))
+        , SameNormalized(Vector(-.001f, 1000.f, 3.f)) )
+}
+
+SCENARIO("SSE and scalar matrix kernels agree", "simd")
+{
+    GIVEN( auto const m = SomeTransform()
+         , auto const n = matrix::View(Point(1.f, 3.f, 2.f), Point(4.f, -2.f, 8.f), Vector(1.f, 1.f, 0.f)) )
+    THEN( SameMatrixTuple(m, Point(1.f, 2.f, 3.f))
+        , SameMatrixTuple(m, Vector(-1.f, .5f, 2.f))
+        , SameMatrixTuple(n, Point(4.f, -2.f, 8.f))
+        , SameMatrixProduct(m, n)
+        , SameMatrixProduct(n, m)
+        , SameMatrixProduct(m, Mat44::Identity()) )
+}
+
+SCENARIO("SSE and scalar slab tests agree, NaNs included", "simd")
+{
+    THEN( SameSlabs(0.f, 2.f, kOrigins, kInwards)
+        , SameSlabs(1.f, 3.f, kInPlane, kParallel)
+        , SameSlabs(-1.f, 1.f, kOrigins, kParallel) )
+}
+
+SCENARIO("Kernels may write their result over an operand", "simd")
+{
+    GIVEN( auto const m = SomeTransform()
+         , auto const p = Point(1.f, 2.f, 3.f)
+         , auto t = p
+         , auto product = m )
+    WHEN( math::sse::MulMat44Vec(m.Data(), t.Data(), t.Data())
+        , math::sse::MulMat44(product.Data(), m.Data(), product.Data()) )
+    THEN( t == m * p
+        , product == m * m )
+}
+
+#endif
@@ -26,7 +26,7 @@ SCENARIO("A pattern with an object transformation", "patterns")
     GIVEN( auto s = std::make_shared<Sphere>()
          , s->SetTransform(matrix::Scaling(2.f, 2.f, 2.f))
          , auto const p = TestPattern() )
-    WHEN( auto const c = p.ShapeColorAt(s, Point(2.f, 3.f, 4.f)) )
+    WHEN( auto const c = p.ShapeColorAt(s.get(), Point(2.f, 3.f, 4.f)) )
     THEN( c == Color(1.f, 1.5f, 2.f) )
 }
 
@@ -35,7 +35,7 @@ SCENARIO("A pattern with a pattern transformation", "patterns")
     GIVEN( auto s = std::make_shared<Sphere>()
          , auto p = TestPattern()
          , p.SetTransform(matrix::Scaling(2.f, 2.f, 2.f)) )
-    WHEN( auto const c = p.ShapeColorAt(s, Point(2.f, 3.f, 4.f)) )
+    WHEN( auto const c = p.ShapeColorAt(s.get(), Point(2.f, 3.f, 4.f)) )
     THEN( c == Color(1.f, 1.5f, 2.f) )
 }
 
@@ -45,7 +45,7 @@ SCENARIO("A pattern with both an object and a pattern transformation", "patterns
          , s->SetTransform(matrix::Scaling(2.f, 2.f, 2.f))
          , auto p = TestPattern()
          , p.SetTransform(matrix::Translation(.5f, 1.f, 1.5f)) )
-    WHEN( auto const c = p.ShapeColorAt(s, Point(2.5, 3.f, 3.5f)) )
+    WHEN( auto const c = p.ShapeColorAt(s.get(), Point(2.5, 3.f, 3.5f)) )
     THEN( c == Color(.75f, .5f, .25f) )
 }
 
@@ -135,6 +135,6 @@ SCENARIO("A pattern applied to a shape in a group", "patterns")
          , g->AddChild(s)
          , auto p = TestPattern()
          , p.SetTransform(matrix::Scaling(2.f, 2.f, 2.f)) )
-    WHEN( auto const c = p.ShapeColorAt(s, Point(2.f, 3.f, 4.f)) )
+    WHEN( auto const c = p.ShapeColorAt(s.get(), Point(2.f, 3.f, 4.f)) )
     THEN( c == Color(1.f, .75f, 1.f) )
 }
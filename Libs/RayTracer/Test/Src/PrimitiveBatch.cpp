@@ -0,0 +1,195 @@
+#include "TestHelpers.h"
+
+#include <RayTracer/Bvh.h>
+#include <RayTracer/LinearBvh.h>
+#include <RayTracer/PrimitiveBatch.h>
+#include <RayTracer/Shapes/Cube.h>
+#include <RayTracer/Shapes/Cylinder.h>
+#include <RayTracer/Shapes/Sphere.h>
+#include <RayTracer/Transformations.h>
+#include <RayTracer/Util.h>
+
+#include <Beddev/Beddev.h>
+
+#include <stdexcept>
+
+namespace
+{
+    // Seven lanes, so the last one of the batch stays unused
+    std::vector<ShapePtr> MixedShapes()
+    {
+        std::vector<ShapePtr> shapes;
+        for (int i = 0; i < 7; i++)
+        {
+            ShapePtr s = (i % 2 == 0) ? ShapePtr(std::make_shared<Sphere>()) : ShapePtr(std::make_shared<Cube>());
+            s->SetTransform(matrix::Translation(2.5f * i, .5f * (i % 3), 0.f) * matrix::RotationY(.2f * i) * matrix::Scaling(1.f, .5f + (.25f * i), 1.f));
+            shapes.push_back(s);
+        }
+        return shapes;
+    }
+
+    PrimitiveBatch MakeBatch(std::vector<ShapePtr> const& shapes)
+    {
+        PrimitiveBatch batch;
+        for (size_t i = 0; i < shapes.size(); i++)
+        {
+            batch.Add(static_cast<uint32_t>(i), *shapes[i]);
+        }
+        return batch;
+    }
+
+    PrimitiveBatch FullBatch()
+    {
+        PrimitiveBatch batch;
+        for (uint32_t i = 0u; i < PrimitiveBatch::kWidth; i++)
+        {
+            batch.Add(i, Sphere());
+        }
+        return batch;
+    }
+
+    bool IsRejected(PrimitiveBatch& batch)
+    {
+        try
+        {
+            batch.Add(0u, Sphere());
+        }
+        catch (std::runtime_error const&)
+        {
+            return true;
+        }
+        return false;
+    }
+
+    // Every lane must report the hits of its shape intersected on its own
+    bool SameAsShapes(std::vector<ShapePtr> const& shapes, Ray const& ray)
+    {
+        auto const batch = MakeBatch(shapes);
+        float t1[PrimitiveBatch::kWidth];
+        float t2[PrimitiveBatch::kWidth];
+        uint32_t const hits = batch.Intersect(ray, t1, t2);
+        for (uint32_t lane = 0u; lane < PrimitiveBatch::kWidth; lane++)
+        {
+            std::vector<Intersection> xs;
+            if (lane < shapes.size())
+            {
+                ray.Intersect(shapes[lane], xs);
+            }
+            bool const hit = (hits & (1u << lane)) != 0u;
+            if ((hit != !xs.empty())
+                || (hit && (!Equals(t1[lane], xs[0].Distance()) || !Equals(t2[lane], xs[1].Distance()))))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+#ifdef USE_AVX
+    bool SameKernels(std::vector<ShapePtr> const& shapes, Ray const& ray)
+    {
+        auto const batch = MakeBatch(shapes);
+        float expected1[PrimitiveBatch::kWidth], expected2[PrimitiveBatch::kWidth];
+        float actual1[PrimitiveBatch::kWidth], actual2[PrimitiveBatch::kWidth];
+        uint32_t const expected = batch::IntersectScalar(batch, ray, expected1, expected2);
+        uint32_t const actual = batch::IntersectAvx(batch, ray, actual1, actual2);
+        if (expected != actual)
+        {
+            return false;
+        }
+        for (uint32_t lane = 0u; lane < PrimitiveBatch::kWidth; lane++)
+        {
+            if (((expected & (1u << lane)) != 0u)
+                && (!Equals(expected1[lane], actual1[lane]) || !Equals(expected2[lane], actual2[lane])))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+#endif
+
+    // size x size grid alternating spheres, cubes and a few cylinders
+    World MixedGrid(int size)
+    {
+        World w = SphereGrid(size);
+        auto& objects = w.ModifyObjects();
+        for (size_t i = 0; i < objects.size(); i++)
+        {
+            if (i % 3 == 0)
+            {
+                ShapePtr replacement = (i % 11 == 0) ? ShapePtr(std::make_shared<Cylinder>(-1.f, 1.f, true)) : ShapePtr(std::make_shared<Cube>());
+                replacement->SetTransform(objects[i]->Transform().ToMat44());
+                objects[i] = replacement;
+            }
+        }
+        return w;
+    }
+}
+
+SCENARIO("Only spheres and cubes can be batched", "batch")
+{
+    THEN( PrimitiveBatch::CanBatch(Sphere())
+        , PrimitiveBatch::CanBatch(Cube())
+        , !PrimitiveBatch::CanBatch(Cylinder())
+        , !PrimitiveBatch::CanBatch(TestShape()) )
+}
+
+SCENARIO("A primitive batch gives the same hits as its shapes", "batch")
+{
+    GIVEN( auto const shapes = MixedShapes() )
+    THEN( SameAsShapes(shapes, Ray(Point(-5.f, 0.f, 0.f), Vector(1.f, 0.f, 0.f)))
+        , SameAsShapes(shapes, Ray(Point(-5.f, .5f, .2f), Vector(1.f, 0.f, 0.f)))
+        , SameAsShapes(shapes, Ray(Point(5.f, 0.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameAsShapes(shapes, Ray(Point(7.5f, 0.f, 0.f), Vector(0.f, 1.f, 0.f)))
+        , SameAsShapes(shapes, Ray(Point(-2.f, 3.f, -4.f), Vector(1.f, -.2f, .3f).Normalized()))
+        , SameAsShapes(shapes, Ray(Point(0.f, 10.f, 0.f), Vector(0.f, 0.f, 1.f))) )
+}
+
+SCENARIO("A full primitive batch can't be added to", "batch")
+{
+    GIVEN( auto batch = FullBatch() )
+    THEN( batch.m_count == PrimitiveBatch::kWidth
+        , IsRejected(batch) )
+}
+
+#ifdef USE_AVX
+SCENARIO("AVX and scalar batch kernels agree", "batch")
+{
+    GIVEN( auto const shapes = MixedShapes() )
+    THEN( SameKernels(shapes, Ray(Point(-5.f, 0.f, 0.f), Vector(1.f, 0.f, 0.f)))
+        , SameKernels(shapes, Ray(Point(-5.f, .5f, .2f), Vector(1.f, 0.f, 0.f)))
+        , SameKernels(shapes, Ray(Point(5.f, 0.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameKernels(shapes, Ray(Point(-2.f, 3.f, -4.f), Vector(1.f, -.2f, .3f).Normalized())) )
+}
+#endif
+
+SCENARIO("A linear bvh batches the leaves of a grid of spheres and cubes", "batch")
+{
+    GIVEN( auto w = MixedGrid(8)
+         , w.BuildAccelerator() )
+    THEN( LinearBvh(*w.GetBvh()).BatchCount() > 0
+        , LinearBvh(*w.GetBvh()).NodeCount() < w.GetBvh()->NodeCount()
+        , SameIntersections(w, World::AcceleratorType::LinearBvh, Ray(Point(0.f, 0.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameIntersections(w, World::AcceleratorType::LinearBvh, Ray(Point(-5.f, 3.f, 0.f), Vector(1.f, 0.f, 0.f)))
+        , SameIntersections(w, World::AcceleratorType::LinearBvh, Ray(Point(25.f, 25.f, .5f), Vector(-1.f, -1.f, 0.f).Normalized()))
+        , SameClosestHit(w, World::AcceleratorType::LinearBvh, Ray(Point(9.f, 6.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameClosestHit(w, World::AcceleratorType::LinearBvh, Ray(Point(-5.f, 0.f, 0.f), Vector(1.f, 0.f, 0.f)))
+        , SameClosestHit(w, World::AcceleratorType::LinearBvh, Ray(Point(10.f, 10.f, 10.f), Vector(.1f, .2f, -1.f).Normalized()))
+        , SameShadows(w, World::AcceleratorType::LinearBvh, Point(3.f, 3.f, 2.f))
+        , SameShadows(w, World::AcceleratorType::LinearBvh, Point(0.f, 0.f, 1.f))
+        , SameShadows(w, World::AcceleratorType::LinearBvh, Point(-1.f, 1.f, -1.f)) )
+}
+
+SCENARIO("Refitting a linear bvh updates its batches", "batch")
+{
+    GIVEN( auto w = MixedGrid(8)
+         , w.BuildAccelerator() )
+    WHEN( w.Objects()[10]->SetTransform(matrix::Translation(3.5f, 4.f, 0.f) * matrix::Scaling(.5f, .5f, .5f))
+        , w.Objects()[12]->SetTransform(matrix::Translation(4.f, 12.5f, 1.f) * matrix::Scaling(.5f, .5f, .5f))
+        , w.RefitAccelerator({ w.Objects()[10], w.Objects()[12] }) )
+    THEN( SameIntersections(w, World::AcceleratorType::LinearBvh, Ray(Point(3.5f, 4.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameIntersections(w, World::AcceleratorType::LinearBvh, Ray(Point(4.f, 12.5f, -5.f), Vector(.01f, .01f, 1.f).Normalized()))
+        , SameClosestHit(w, World::AcceleratorType::LinearBvh, Ray(Point(4.f, 12.5f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameShadows(w, World::AcceleratorType::LinearBvh, Point(3.5f, 4.f, -1.f)) )
+}
@@ -92,3 +92,44 @@ SCENARIO("Scaling a ray", "math")
     THEN( r2.Origin() == Point(2.f, 6.f, 12.f)
         , r2.Direction() == Vector(0.f, 3.f, 0.f) )
 }
+
+SCENARIO("A closest hit query keeps the nearest hit and shrinks the ray tMax", "math")
+{
+    GIVEN( auto const r = Ray(Point(0.f, 0.f, -5.f), Vector(0.f, 0.f, 1.f))
+         , auto const s = std::make_shared<Sphere>()
+         , Intersection hit(INF, nullptr) )
+    WHEN( bool const found = r.IntersectClosest(s, hit) )
+    THEN( found
+        , hit.Distance() == 4.f
+        , hit.Object() == s.get()
+        , r.TMax() == 4.f )
+}
+
+SCENARIO("A closest hit query ignores hits beyond the ray tMax", "math")
+{
+    GIVEN( auto const r = Ray(Point(0.f, 0.f, -5.f), Vector(0.f, 0.f, 1.f), 3.f)
+         , auto const s = std::make_shared<Sphere>()
+         , Intersection hit(INF, nullptr) )
+    WHEN( bool const found = r.IntersectClosest(s, hit) )
+    THEN( !found
+        , hit.Object() == nullptr
+        , r.TMax() == 3.f )
+}
+
+SCENARIO("A closest hit query ignores hits behind the ray", "math")
+{
+    GIVEN( auto const r = Ray(Point(0.f, 0.f, 0.f), Vector(0.f, 0.f, 1.f))
+         , auto const s = std::make_shared<Sphere>()
+         , Intersection hit(INF, nullptr) )
+    WHEN( bool const found = r.IntersectClosest(s, hit) )
+    THEN( found
+        , hit.Distance() == 1.f )
+}
+
+SCENARIO("Transforming a ray keeps its tMax", "math")
+{
+    GIVEN( auto const r = Ray(Point(1.f, 2.f, 3.f), Vector(0.f, 1.f, 0.f), 7.f)
+         , auto const m = matrix::Scaling(2.f, 3.f, 4.f) )
+    WHEN( auto const r2 = m * r )
+    THEN( r2.TMax() == 7.f )
+}
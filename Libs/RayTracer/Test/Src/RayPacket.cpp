@@ -0,0 +1,263 @@
+#include "TestHelpers.h"
+
+#include <RayTracer/Camera.h>
+#include <RayTracer/RayPacket.h>
+#include <RayTracer/Shapes/Cube.h>
+#include <RayTracer/Shapes/Cylinder.h>
+#include <RayTracer/Shapes/Plane.h>
+#include <RayTracer/Shapes/Sphere.h>
+#include <RayTracer/Transformations.h>
+#include <RayTracer/Util.h>
+
+#include <Beddev/Beddev.h>
+
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    // Grid of spheres with a floor, a cube, a cylinder and a glass sphere in front
+    World PacketWorld()
+    {
+        World w = SphereGrid(6);
+
+        auto floor = std::make_shared<Plane>();
+        floor->SetTransform(matrix::Translation(0.f, 0.f, 3.f) * matrix::RotationX(-PI / 2.f));
+        floor->ModifyMaterial().Reflective(.5f);
+        w.Add(floor);
+
+        auto cube = std::make_shared<Cube>();
+        cube->SetTransform(matrix::Translation(4.5f, 4.5f, -1.f) * matrix::Scaling(.75f, .75f, .75f));
+        w.Add(cube);
+
+        auto cylinder = std::make_shared<Cylinder>(-1.f, 1.f, true);
+        cylinder->SetTransform(matrix::Translation(10.5f, 4.5f, -1.f) * matrix::Scaling(.75f, 1.f, .75f));
+        w.Add(cylinder);
+
+        auto glass = GlassySphere();
+        glass->SetTransform(matrix::Translation(7.5f, 10.5f, -2.f));
+        w.Add(glass);
+
+        w.BuildAccelerator();
+        return w;
+    }
+
+    Camera PacketCamera(uint32_t width, uint32_t height)
+    {
+        Camera c(width, height, PI / 3.f);
+        c.SetTransform(matrix::View(Point(7.5f, 7.5f, -20.f), Point(7.5f, 7.5f, 0.f), Vector(0.f, 1.f, 0.f)));
+        return c;
+    }
+
+    RayPacket PrimaryPacket(Camera const& c, uint32_t x0, uint32_t y0)
+    {
+        RayPacket packet;
+        for (uint32_t y = y0; y < y0 + 4u; y++)
+        {
+            for (uint32_t x = x0; x < x0 + 4u; x++)
+            {
+                packet.Add(c.RayForPixel(x, y));
+            }
+        }
+        return packet;
+    }
+
+    // Rays from a 4x4 grid of points of the z = -1.5 plane toward the light
+    RayPacket ShadowPacket(Tuple const& light, float x0, float y0, std::array<float, RayPacket::kMaxSize>& distances)
+    {
+        RayPacket packet;
+        for (int i = 0; i < 16; i++)
+        {
+            auto const point = Point(x0 + (.8f * (i % 4)), y0 + (.8f * (i / 4)), -1.5f);
+            auto const toLight = light - point;
+            distances[packet.Size()] = toLight.Length();
+            packet.Add(Ray(point, toLight.Normalized()));
+        }
+        return packet;
+    }
+
+    bool SamePacketHits(World& w, World::AcceleratorType type, RayPacket const& packet)
+    {
+        w.SetAcceleratorType(type);
+        std::array<Intersection, RayPacket::kMaxSize> hits;
+        uint32_t const found = packet.IntersectClosest(w, packet.FullMask(), hits.data());
+
+        w.SetAcceleratorType(World::AcceleratorType::None);
+        for (uint32_t lane = 0u; lane < packet.Size(); lane++)
+        {
+            auto const r = packet.At(lane);
+            Ray const single(r.Origin(), r.Direction());
+            Intersection expected;
+            bool const expectedFound = single.IntersectClosest(w, expected);
+            bool const actualFound = (found & (1u << lane)) != 0u;
+            if ((expectedFound != actualFound)
+                || (expectedFound && ((expected.Object() != hits[lane].Object())
+                    || !Equals(expected.Distance(), hits[lane].Distance())
+                    || (packet.TMax(lane) != hits[lane].Distance()))))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool SamePacketShadows(World& w, World::AcceleratorType type, float x0, float y0)
+    {
+        std::array<float, RayPacket::kMaxSize> distances = {};
+        auto const packet = ShadowPacket(w.Lights()[0].Position(), x0, y0, distances);
+        w.SetAcceleratorType(type);
+        uint32_t const occluded = packet.FindOccluders(w, packet.FullMask(), distances.data());
+
+        w.SetAcceleratorType(World::AcceleratorType::None);
+        for (uint32_t lane = 0u; lane < packet.Size(); lane++)
+        {
+            if (packet.At(lane).HasIntersectionNearThan(w, distances[lane]) != ((occluded & (1u << lane)) != 0u))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool SamePacketColors(World& w, World::AcceleratorType type, RayPacket const& packet)
+    {
+        w.SetAcceleratorType(type);
+        std::vector<Color> colors(RayPacket::kMaxSize, Color(0.f, 0.f, 0.f));
+        w.ColorAt(packet, colors.data());
+        for (uint32_t lane = 0u; lane < packet.Size(); lane++)
+        {
+            if (!(colors[lane] == w.ColorAt(packet.At(lane))))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool SameRender(World& w, World::AcceleratorType type, uint32_t packetSize)
+    {
+        // Odd sizes, so blocks of pixels are clipped at the edges
+        w.SetAcceleratorType(type);
+        auto const c = PacketCamera(23, 13);
+        RenderSettings settings;
+        settings.m_packetSize = 1u;
+        auto const expected = c.Render(w, settings);
+        settings.m_packetSize = packetSize;
+        auto const actual = c.Render(w, settings);
+        return SameImage(expected, actual);
+    }
+
+    RayPacket FullPacket()
+    {
+        RayPacket packet;
+        for (uint32_t i = 0u; i < RayPacket::kMaxSize; i++)
+        {
+            packet.Add(Ray(Point(0.f, 0.f, 0.f), Vector(0.f, 0.f, 1.f)));
+        }
+        return packet;
+    }
+
+    bool IsRejected(RayPacket& packet)
+    {
+        try
+        {
+            packet.Add(Ray(Point(0.f, 0.f, 0.f), Vector(0.f, 0.f, 1.f)));
+        }
+        catch (std::runtime_error const&)
+        {
+            return true;
+        }
+        return false;
+    }
+
+    bool IsRejectedPacketSize(uint32_t size)
+    {
+        try
+        {
+            RenderSettings settings;
+            settings.m_packetSize = size;
+            settings.Validate();
+        }
+        catch (std::runtime_error const&)
+        {
+            return true;
+        }
+        return false;
+    }
+}
+
+SCENARIO("Rays are stored in the lanes of a packet", "packet")
+{
+    GIVEN( auto packet = RayPacket()
+         , auto const r = Ray(Point(1.f, 2.f, 3.f), Vector(0.f, 1.f, 0.f), 5.f) )
+    WHEN( packet.Add(Ray(Point(0.f, 0.f, 0.f), Vector(0.f, 0.f, 1.f)))
+        , packet.Add(r) )
+    THEN( packet.Size() == 2u
+        , packet.FullMask() == 3u
+        , packet.At(1).Origin() == r.Origin()
+        , packet.At(1).Direction() == r.Direction()
+        , packet.TMax(1) == 5.f
+        , packet.TMax(0) == INF )
+}
+
+SCENARIO("A full ray packet can't be added to", "packet")
+{
+    GIVEN( auto packet = FullPacket() )
+    THEN( packet.Size() == RayPacket::kMaxSize
+        , IsRejected(packet) )
+}
+
+SCENARIO("Packet closest hit queries give the same results as single rays", "packet")
+{
+    GIVEN( auto w = PacketWorld()
+         , auto const c = PacketCamera(24, 16) )
+    THEN( SamePacketHits(w, World::AcceleratorType::None, PrimaryPacket(c, 0, 0))
+        , SamePacketHits(w, World::AcceleratorType::Bvh, PrimaryPacket(c, 8, 4))
+        , SamePacketHits(w, World::AcceleratorType::LinearBvh, PrimaryPacket(c, 0, 0))
+        , SamePacketHits(w, World::AcceleratorType::LinearBvh, PrimaryPacket(c, 8, 4))
+        , SamePacketHits(w, World::AcceleratorType::LinearBvh, PrimaryPacket(c, 12, 8))
+        , SamePacketHits(w, World::AcceleratorType::LinearBvh, PrimaryPacket(c, 20, 12)) )
+}
+
+SCENARIO("Packet shadow queries give the same results as single rays", "packet")
+{
+    GIVEN( auto w = PacketWorld() )
+    THEN( SamePacketShadows(w, World::AcceleratorType::None, 2.f, 2.f)
+        , SamePacketShadows(w, World::AcceleratorType::Bvh, 2.f, 2.f)
+        , SamePacketShadows(w, World::AcceleratorType::LinearBvh, 2.f, 2.f)
+        , SamePacketShadows(w, World::AcceleratorType::LinearBvh, 4.f, 3.f)
+        , SamePacketShadows(w, World::AcceleratorType::LinearBvh, 9.f, 9.f)
+        , SamePacketShadows(w, World::AcceleratorType::LinearBvh, -8.f, 20.f) )
+}
+
+SCENARIO("Shading a packet gives the same colors as single rays", "packet")
+{
+    GIVEN( auto w = PacketWorld()
+         , auto const c = PacketCamera(24, 16) )
+    THEN( SamePacketColors(w, World::AcceleratorType::None, PrimaryPacket(c, 8, 4))
+        , SamePacketColors(w, World::AcceleratorType::LinearBvh, PrimaryPacket(c, 0, 0))
+        , SamePacketColors(w, World::AcceleratorType::LinearBvh, PrimaryPacket(c, 8, 4))
+        , SamePacketColors(w, World::AcceleratorType::LinearBvh, PrimaryPacket(c, 12, 8))
+        , SamePacketColors(w, World::AcceleratorType::LinearBvh, PrimaryPacket(c, 12, 0)) )
+}
+
+SCENARIO("Rendering with ray packets gives the same image as single rays", "packet")
+{
+    GIVEN( auto w = PacketWorld() )
+    THEN( SameRender(w, World::AcceleratorType::LinearBvh, 4u)
+        , SameRender(w, World::AcceleratorType::LinearBvh, 8u)
+        , SameRender(w, World::AcceleratorType::LinearBvh, 16u)
+        , SameRender(w, World::AcceleratorType::Bvh, 16u) )
+}
+
+SCENARIO("Camera packets hold 1, 4, 8 or 16 rays", "packet")
+{
+    GIVEN( auto const settings = RenderSettings() )
+    THEN( settings.m_packetSize == 16u
+        , !IsRejectedPacketSize(1u)
+        , !IsRejectedPacketSize(8u)
+        , IsRejectedPacketSize(0u)
+        , IsRejectedPacketSize(3u)
+        , IsRejectedPacketSize(32u) )
+}
@@ -0,0 +1,250 @@
+#include "TestHelpers.h"
+
+#include <RayTracer/Camera.h>
+#include <RayTracer/RenderSettings.h>
+#include <RayTracer/RenderTarget.h>
+#include <RayTracer/Shapes/Plane.h>
+#include <RayTracer/Transformations.h>
+#include <RayTracer/Util.h>
+
+#include <Beddev/Beddev.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    // Default world above a mirror
+    World MirrorWorld()
+    {
+        auto w = DefaultWorld();
+        auto floor = std::make_shared<Plane>();
+        floor->SetTransform(matrix::Translation(0.f, -1.f, 0.f));
+        floor->ModifyMaterial().Reflective(1.f);
+        w.Add(floor);
+        w.BuildAccelerator();
+        return w;
+    }
+
+    Camera SettingsCamera()
+    {
+        Camera c(37, 29, PI / 2.f);
+        c.SetTransform(matrix::View(Point(0.f, 1.f, -5.f), Point(0.f, 0.f, 0.f), Vector(0.f, 1.f, 0.f)));
+        return c;
+    }
+
+    uint32_t DifferentPixels(Canvas const& a, Canvas const& b)
+    {
+        uint32_t count = 0u;
+        for (int y = 0; y < a.Height(); y++)
+        {
+            for (int x = 0; x < a.Width(); x++)
+            {
+                count += (a.PixelAt(x, y) == b.PixelAt(x, y)) ? 0u : 1u;
+            }
+        }
+        return count;
+    }
+
+    uint32_t DifferentPixels(World const& w, RenderSettings const& settings)
+    {
+        auto const c = SettingsCamera();
+        return DifferentPixels(c.Render(w), c.Render(w, settings));
+    }
+
+    RenderSettings TileSize(uint32_t size)
+    {
+        RenderSettings settings;
+        settings.m_tileSize = size;
+        return settings;
+    }
+
+    RenderSettings MaxDepth(uint8_t depth)
+    {
+        RenderSettings settings;
+        settings.m_maxDepth = depth;
+        return settings;
+    }
+
+    RenderSettings SamplesPerPixel(uint32_t samples)
+    {
+        RenderSettings settings;
+        settings.m_samplesPerPixel = samples;
+        return settings;
+    }
+
+    RenderSettings MaxSamplesPerPixel(uint32_t samples, uint32_t maxSamples)
+    {
+        RenderSettings settings;
+        settings.m_samplesPerPixel = samples;
+        settings.m_maxSamplesPerPixel = maxSamples;
+        return settings;
+    }
+
+    RenderSettings Passes(uint32_t passes)
+    {
+        RenderSettings settings;
+        settings.m_passes = passes;
+        return settings;
+    }
+
+    RenderSettings TimeBudget(double seconds)
+    {
+        RenderSettings settings;
+        settings.m_timeBudget = seconds;
+        return settings;
+    }
+
+    RenderSettings Accelerator(World::AcceleratorType type)
+    {
+        RenderSettings settings;
+        settings.m_accelerator = type;
+        return settings;
+    }
+
+    RenderSettings Tiles(uint32_t first, uint32_t last)
+    {
+        RenderSettings settings;
+        settings.m_tiles = std::make_pair(first, last);
+        return settings;
+    }
+
+    // Pixels of the default world rendered by the given range of 16 x 16
+    // tiles, the others being black
+    uint32_t RenderedPixels(World const& w, uint32_t first, uint32_t last)
+    {
+        auto const c = SettingsCamera();
+        RenderTarget target(c.HorizontalSize(), c.VerticalSize());
+        c.Render(w, Tiles(first, last), target);
+        std::vector<uint8_t> coverage;
+        target.Snapshot(&coverage);
+        return static_cast<uint32_t>(std::count(coverage.begin(), coverage.end(), 1u));
+    }
+
+    bool IsRejected(RenderSettings const& settings)
+    {
+        try
+        {
+            Camera(4, 4, PI / 2.f).Render(DefaultWorld(), settings);
+        }
+        catch (std::runtime_error const&)
+        {
+            return true;
+        }
+        return false;
+    }
+
+    // Single rays, so shadows go through the occluder cache
+    RenderStats Measure(World const& w, bool workerStats, bool occluderCacheStats)
+    {
+        RenderSettings settings;
+        settings.m_threads = 2u;
+        settings.m_packetSize = 1u;
+        settings.m_workerStats = workerStats;
+        settings.m_occluderCacheStats = occluderCacheStats;
+        RenderStats stats;
+        SettingsCamera().Render(w, settings, &stats);
+        return stats;
+    }
+}
+
+SCENARIO("Default render settings", "settings")
+{
+    GIVEN( auto const settings = RenderSettings() )
+    THEN( settings.m_threads == 0u
+        , settings.m_tileSize == 16u
+        , settings.m_maxDepth == World::kDefaultMaxDepth
+        , settings.m_samplesPerPixel == 1u
+        , settings.m_maxSamplesPerPixel == 0u
+        , settings.m_passes == 1u
+        , settings.m_packetSize == 16u
+        , settings.m_frustumCulling
+        , !settings.m_tiles.has_value()
+        , !settings.m_accelerator.has_value()
+        , settings.m_timeBudget == 0.
+        , settings.m_cancellation == nullptr
+        , !settings.m_workerStats
+        , !settings.m_occluderCacheStats )
+}
+
+SCENARIO("Render settings out of range are rejected", "settings")
+{
+    GIVEN( auto const w = DefaultWorld() )
+    THEN( !IsRejected(RenderSettings())
+        , IsRejected(TileSize(0u))
+        , IsRejected(SamplesPerPixel(0u))
+        , IsRejected(Passes(0u))
+        , !IsRejected(Passes(RenderSettings::kMaxPasses))
+        , IsRejected(Passes(RenderSettings::kMaxPasses + 1u))
+        , IsRejected(TimeBudget(-1.))
+        , IsRejected(MaxSamplesPerPixel(4u, 2u))
+        , !IsRejected(MaxSamplesPerPixel(4u, 4u))
+        , !IsRejected(MaxSamplesPerPixel(4u, 0u))
+        , IsRejected(Tiles(2u, 2u))
+        , !IsRejected(Tiles(2u, 3u)) )
+}
+
+SCENARIO("The tile size doesn't change the rendered image", "settings")
+{
+    GIVEN( auto const w = MirrorWorld() )
+    THEN( DifferentPixels(w, TileSize(1u)) == 0u
+        , DifferentPixels(w, TileSize(7u)) == 0u
+        , DifferentPixels(w, TileSize(64u)) == 0u )
+}
+
+SCENARIO("Only the range of tiles set is rendered", "settings")
+{
+    GIVEN( auto const w = DefaultWorld()
+         , auto const c = SettingsCamera() )
+    THEN( c.TileCount(16u) == 6u
+        , RenderedPixels(w, 0u, 1u) == 16u * 16u
+        , RenderedPixels(w, 2u, 4u) == (5u * 16u) + (16u * 13u)
+        , RenderedPixels(w, 5u, 100u) == 5u * 13u
+        , RenderedPixels(w, 0u, 6u) == 37u * 29u )
+}
+
+SCENARIO("The max depth of a render bounds its reflections", "settings")
+{
+    GIVEN( auto const w = MirrorWorld()
+         , auto const c = SettingsCamera()
+         , auto const r = c.RayForPixel(18, 20) )
+    WHEN( auto const flat = c.Render(w, MaxDepth(0u)) )
+    THEN( DifferentPixels(w, MaxDepth(World::kDefaultMaxDepth)) == 0u
+        , DifferentPixels(w, MaxDepth(0u)) > 0u
+        , flat.PixelAt(18, 20) == w.ColorAt(r, 0u)
+        , !(flat.PixelAt(18, 20) == w.ColorAt(r)) )
+}
+
+SCENARIO("Several samples per pixel smooth the edges of objects", "settings")
+{
+    GIVEN( auto const w = DefaultWorld()
+         , auto const c = SettingsCamera() )
+    WHEN( auto const image = c.Render(w, SamplesPerPixel(4u)) )
+    THEN( DifferentPixels(w, SamplesPerPixel(1u)) == 0u
+        , DifferentPixels(w, SamplesPerPixel(4u)) > 0u
+        , image.PixelAt(0, 0) == Color(0.f, 0.f, 0.f) )
+}
+
+SCENARIO("Rendering through another accelerator keeps the world's own", "settings")
+{
+    GIVEN( auto const w = MirrorWorld() )
+    THEN( DifferentPixels(w, Accelerator(World::AcceleratorType::None)) == 0u
+        , DifferentPixels(w, Accelerator(World::AcceleratorType::LinearBvh)) == 0u
+        , DifferentPixels(w, Accelerator(World::AcceleratorType::Bvh8)) == 0u
+        , w.GetAcceleratorType() == World::AcceleratorType::Bvh )
+}
+
+SCENARIO("Render stats are only measured when enabled", "settings")
+{
+    GIVEN( auto const w = MirrorWorld() )
+    WHEN( auto const none = Measure(w, false, false)
+        , auto const all = Measure(w, true, true) )
+    THEN( none.m_seconds > 0.
+        , none.m_workers.empty()
+        , none.m_occluderCache.m_queries == 0u
+        , all.m_workers.size() == 2u
+        , all.m_occluderCache.m_queries > 0u
+        , all.m_occluderCache.m_hits <= all.m_occluderCache.m_queries )
+}
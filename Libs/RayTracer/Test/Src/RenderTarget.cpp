@@ -0,0 +1,166 @@
+#include "TestHelpers.h"
+
+#include <RayTracer/Camera.h>
+#include <RayTracer/RenderTarget.h>
+#include <RayTracer/Transformations.h>
+#include <RayTracer/Util.h>
+
+#include <Beddev/Beddev.h>
+
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    Camera ProgressiveCamera()
+    {
+        // Odd sizes, so tiles and the blocks of coarse passes are clipped
+        Camera c(37, 29, PI / 2.f);
+        c.SetTransform(matrix::View(Point(0.f, 1.f, -5.f), Point(0.f, 0.f, 0.f), Vector(0.f, 1.f, 0.f)));
+        return c;
+    }
+
+    RenderSettings Passes(uint32_t passes, uint32_t packetSize)
+    {
+        RenderSettings settings;
+        settings.m_passes = passes;
+        settings.m_packetSize = packetSize;
+        settings.m_threads = 3u;
+        return settings;
+    }
+
+    bool SameAsSinglePass(World const& w, uint32_t passes, uint32_t packetSize)
+    {
+        auto const c = ProgressiveCamera();
+        return SameImage(c.Render(w, Passes(1u, packetSize)), c.Render(w, Passes(passes, packetSize)));
+    }
+
+    // Every progress reported by a render, with a snapshot at the end of its first pass
+    struct Progress
+    {
+        std::vector<RenderProgress> m_calls;
+        std::optional<Canvas> m_firstPass; // Canvas can't be assigned
+    };
+
+    Progress Track(World const& w, uint32_t passes)
+    {
+        auto const c = ProgressiveCamera();
+        RenderTarget target(c.HorizontalSize(), c.VerticalSize());
+        Progress progress;
+        c.Render(w, Passes(passes, 16u), target, [&](RenderProgress const& p, RenderTarget const& t) {
+            progress.m_calls.push_back(p);
+            if ((p.m_pass == 0u) && (p.m_tilesDone == p.m_tileCount))
+            {
+                progress.m_firstPass.emplace(t.Snapshot());
+            }
+        });
+        return progress;
+    }
+
+    // Passes are reported in order, each with one call per tile
+    bool InOrder(std::vector<RenderProgress> const& calls)
+    {
+        for (size_t i = 0; i < calls.size(); i++)
+        {
+            auto const& p = calls[i];
+            uint32_t const pass = static_cast<uint32_t>(i / p.m_tileCount);
+            if ((p.m_pass != pass) || (p.m_tilesDone != (i % p.m_tileCount) + 1u))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Pixels of the coarsest pass fill blocks of stride x stride from the corner of their tile
+    bool FilledInBlocks(Canvas const& image, uint32_t stride)
+    {
+        for (int y = 0; y < image.Height(); y++)
+        {
+            for (int x = 0; x < image.Width(); x++)
+            {
+                uint32_t const cornerX = x - (x % 16) % stride;
+                uint32_t const cornerY = y - (y % 16) % stride;
+                if (!(image.PixelAt(x, y) == image.PixelAt(cornerX, cornerY)))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool IsRejectedTarget(World const& w, uint32_t width, uint32_t height)
+    {
+        try
+        {
+            RenderTarget target(width, height);
+            ProgressiveCamera().Render(w, RenderSettings(), target);
+        }
+        catch (std::runtime_error const&)
+        {
+            return true;
+        }
+        return false;
+    }
+
+    std::vector<PixelBlock> RedBlock()
+    {
+        return { PixelBlock{ 1u, 1u, 3u, 2u, Color(1.f, 0.f, 0.f) } };
+    }
+}
+
+SCENARIO("A new render target is black", "progressive")
+{
+    GIVEN( auto const target = RenderTarget(4u, 3u) )
+    WHEN( auto const snapshot = target.Snapshot() )
+    THEN( snapshot.Width() == 4
+        , snapshot.Height() == 3
+        , snapshot.PixelAt(3, 2) == Color(0.f, 0.f, 0.f) )
+}
+
+SCENARIO("Writing blocks of pixels to a render target", "progressive")
+{
+    GIVEN( auto target = RenderTarget(4u, 3u) )
+    WHEN( target.Write(RedBlock())
+        , auto const snapshot = target.Snapshot()
+        , auto const canvas = target.TakeCanvas() )
+    THEN( snapshot.PixelAt(1, 1) == Color(1.f, 0.f, 0.f)
+        , snapshot.PixelAt(2, 1) == Color(1.f, 0.f, 0.f)
+        , snapshot.PixelAt(3, 1) == Color(0.f, 0.f, 0.f)
+        , snapshot.PixelAt(1, 2) == Color(0.f, 0.f, 0.f)
+        , canvas.PixelAt(2, 1) == Color(1.f, 0.f, 0.f)
+        , target.Width() == 0u
+        , target.Snapshot().Width() == 0 )
+}
+
+SCENARIO("Progressive renders end with the same image as a single pass", "progressive")
+{
+    GIVEN( auto const w = DefaultWorld() )
+    THEN( SameAsSinglePass(w, 2u, 16u)
+        , SameAsSinglePass(w, 3u, 4u)
+        , SameAsSinglePass(w, 4u, 1u)
+        , SameAsSinglePass(w, 5u, 8u) )
+}
+
+SCENARIO("Progress is reported after every tile of every pass", "progressive")
+{
+    GIVEN( auto const w = DefaultWorld() )
+    WHEN( auto const progress = Track(w, 3u) )
+    THEN( progress.m_calls.size() == 3u * 3u * 2u
+        , progress.m_calls.front().m_passCount == 3u
+        , progress.m_calls.front().m_tileCount == 3u * 2u
+        , InOrder(progress.m_calls)
+        , progress.m_firstPass.has_value()
+        , FilledInBlocks(*progress.m_firstPass, 4u)
+        , !FilledInBlocks(ProgressiveCamera().Render(w), 4u) )
+}
+
+SCENARIO("A render target must have the size of the image", "progressive")
+{
+    GIVEN( auto const w = DefaultWorld() )
+    THEN( !IsRejectedTarget(w, 37u, 29u)
+        , IsRejectedTarget(w, 36u, 29u)
+        , IsRejectedTarget(w, 37u, 30u) )
+}
@@ -0,0 +1,272 @@
+#include "TestHelpers.h"
+
+#include <RayTracer/Camera.h>
+#include <RayTracer/RenderSettings.h>
+#include <RayTracer/Sampler.h>
+#include <RayTracer/Transformations.h>
+#include <RayTracer/Util.h>
+
+#include <Beddev/Beddev.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+    bool InUnitRange(ISampler const& sampler)
+    {
+        for (uint32_t pixel = 0u; pixel < 16u; pixel++)
+        {
+            for (uint32_t sample = 0u; sample < 256u; sample++)
+            {
+                for (uint32_t dimension = 0u; dimension < 40u; dimension++)
+                {
+                    float const value = sampler.Get(pixel, 3u * pixel, sample, dimension);
+                    if ((value < 0.f) || (value >= 1.f))
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    // The first samples of a pair of dimensions of a pixel, one per cell of
+    // a columns x rows grid
+    bool OnePerCell(ISampler const& sampler, uint32_t dimension, uint32_t columns, uint32_t rows)
+    {
+        std::vector<uint32_t> cells(columns * rows, 0u);
+        for (uint32_t sample = 0u; sample < columns * rows; sample++)
+        {
+            float u = 0.f;
+            float v = 0.f;
+            sampler.Get2D(5u, 7u, sample, dimension, u, v);
+            cells[(static_cast<uint32_t>(v * rows) * columns) + static_cast<uint32_t>(u * columns)]++;
+        }
+        for (auto count : cells)
+        {
+            if (count != 1u)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool OnePerStratum(ISampler const& sampler, uint32_t dimension, uint32_t strata)
+    {
+        std::vector<uint32_t> counts(strata, 0u);
+        for (uint32_t sample = 0u; sample < strata; sample++)
+        {
+            counts[static_cast<uint32_t>(sampler.Get(5u, 7u, sample, dimension) * strata)]++;
+        }
+        for (auto count : counts)
+        {
+            if (count != 1u)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // The same sample of every pixel, or of every dimension, is somewhere else
+    bool DecorrelatedPixels(ISampler const& sampler)
+    {
+        return !(sampler.Get(0u, 0u, 0u, 0u) == sampler.Get(1u, 0u, 0u, 0u))
+            && !(sampler.Get(0u, 0u, 0u, 0u) == sampler.Get(0u, 1u, 0u, 0u));
+    }
+
+    bool DecorrelatedDimensions(ISampler const& sampler)
+    {
+        return !(sampler.Get(2u, 3u, 1u, 0u) == sampler.Get(2u, 3u, 1u, 2u))
+            && !(sampler.Get(2u, 3u, 1u, 1u) == sampler.Get(2u, 3u, 1u, 3u));
+    }
+
+    // Cells of a size x size grid hit by the first size * size samples of a
+    // pixel along two dimensions. Only size of them are when the second is a
+    // function of the first.
+    uint32_t CellsHit(ISampler const& sampler, uint32_t first, uint32_t second, uint32_t size)
+    {
+        std::vector<bool> hit(size * size, false);
+        for (uint32_t sample = 0u; sample < size * size; sample++)
+        {
+            uint32_t const column = static_cast<uint32_t>(sampler.Get(5u, 7u, sample, first) * size);
+            uint32_t const row = static_cast<uint32_t>(sampler.Get(5u, 7u, sample, second) * size);
+            hit[(row * size) + column] = true;
+        }
+        return static_cast<uint32_t>(std::count(hit.begin(), hit.end(), true));
+    }
+
+    // RMS error over many pixels of the area of the quarter disk estimated
+    // with the given number of samples
+    double QuarterDiskError(ISampler const& sampler, uint32_t samples)
+    {
+        double squaredError = 0.;
+        for (uint32_t pixel = 0u; pixel < 256u; pixel++)
+        {
+            uint32_t inside = 0u;
+            for (uint32_t sample = 0u; sample < samples; sample++)
+            {
+                float u = 0.f;
+                float v = 0.f;
+                sampler.Get2D(pixel % 16u, pixel / 16u, sample, 2u, u, v);
+                inside += (((u * u) + (v * v)) < 1.f) ? 1u : 0u;
+            }
+            double const error = (static_cast<double>(inside) / samples) - (PI / 4.);
+            squaredError += error * error;
+        }
+        return std::sqrt(squaredError / 256.);
+    }
+
+    double WhiteNoiseQuarterDiskError(uint32_t samples)
+    {
+        std::mt19937 generator(1234u);
+        std::uniform_real_distribution<float> uniform(0.f, 1.f);
+        double squaredError = 0.;
+        for (uint32_t pixel = 0u; pixel < 256u; pixel++)
+        {
+            uint32_t inside = 0u;
+            for (uint32_t sample = 0u; sample < samples; sample++)
+            {
+                float const u = uniform(generator);
+                float const v = uniform(generator);
+                inside += (((u * u) + (v * v)) < 1.f) ? 1u : 0u;
+            }
+            double const error = (static_cast<double>(inside) / samples) - (PI / 4.);
+            squaredError += error * error;
+        }
+        return std::sqrt(squaredError / 256.);
+    }
+
+    Camera SamplerCamera()
+    {
+        Camera c(37, 29, PI / 2.f);
+        c.SetTransform(matrix::View(Point(0.f, 1.f, -5.f), Point(0.f, 0.f, 0.f), Vector(0.f, 1.f, 0.f)));
+        return c;
+    }
+
+    RenderSettings Sampled(SamplerPtr sampler, uint32_t samples, uint32_t threads)
+    {
+        RenderSettings settings;
+        settings.m_sampler = sampler;
+        settings.m_samplesPerPixel = samples;
+        settings.m_threads = threads;
+        return settings;
+    }
+
+    bool SameRender(World const& w, RenderSettings const& a, RenderSettings const& b)
+    {
+        auto const c = SamplerCamera();
+        auto const imageA = c.Render(w, a);
+        auto const imageB = c.Render(w, b);
+        return SameImage(imageA, imageB);
+    }
+}
+
+SCENARIO("Samplers give values in [0, 1)", "sampler")
+{
+    GIVEN( auto const r2 = R2Sampler()
+         , auto const sobol = SobolSampler()
+         , auto const halton = HaltonSampler()
+         , auto const stratified = StratifiedSampler(64u) )
+    THEN( InUnitRange(r2)
+        , InUnitRange(sobol)
+        , InUnitRange(halton)
+        , InUnitRange(stratified) )
+}
+
+SCENARIO("Samplers only depend on the pixel, the sample and the dimension", "sampler")
+{
+    GIVEN( auto const a = SobolSampler(7u)
+         , auto const b = SobolSampler(7u)
+         , auto const c = SobolSampler(8u)
+         , auto const halton = HaltonSampler(7u)
+         , auto const stratified = StratifiedSampler(16u, 7u) )
+    THEN( a.Get(12u, 34u, 5u, 3u) == b.Get(12u, 34u, 5u, 3u)
+        , !(a.Get(12u, 34u, 5u, 3u) == c.Get(12u, 34u, 5u, 3u))
+        , halton.Get(12u, 34u, 5u, 3u) == HaltonSampler(7u).Get(12u, 34u, 5u, 3u)
+        , stratified.Get(12u, 34u, 5u, 3u) == StratifiedSampler(16u, 7u).Get(12u, 34u, 5u, 3u) )
+}
+
+SCENARIO("The R2 sampler starts at the center of the pixel", "sampler")
+{
+    GIVEN( auto const r2 = R2Sampler() )
+    THEN( r2.Get(0u, 0u, 0u, 0u) == .5f
+        , r2.Get(0u, 0u, 0u, 1u) == .5f
+        , r2.Get(3u, 9u, 5u, 0u) == r2.Get(4u, 2u, 5u, 0u) )
+}
+
+SCENARIO("Scrambled samplers decorrelate pixels and dimensions", "sampler")
+{
+    GIVEN( auto const sobol = SobolSampler()
+         , auto const halton = HaltonSampler()
+         , auto const stratified = StratifiedSampler(16u) )
+    THEN( DecorrelatedPixels(sobol)
+        , DecorrelatedPixels(halton)
+        , DecorrelatedPixels(stratified)
+        , DecorrelatedDimensions(sobol)
+        , DecorrelatedDimensions(halton)
+        , DecorrelatedDimensions(stratified) )
+}
+
+SCENARIO("Sobol samples are stratified over every pair of dimensions", "sampler")
+{
+    GIVEN( auto const sobol = SobolSampler(3u) )
+    THEN( OnePerCell(sobol, 0u, 4u, 4u)
+        , OnePerCell(sobol, 0u, 16u, 1u)
+        , OnePerCell(sobol, 0u, 1u, 16u)
+        , OnePerCell(sobol, 0u, 8u, 8u)
+        , OnePerCell(sobol, 4u, 2u, 8u)
+        , OnePerCell(sobol, 10u, 4u, 4u) )
+}
+
+SCENARIO("Halton samples are stratified in their base", "sampler")
+{
+    GIVEN( auto const halton = HaltonSampler(3u) )
+    THEN( OnePerStratum(halton, 0u, 16u)
+        , OnePerStratum(halton, 1u, 9u)
+        , OnePerStratum(halton, 2u, 25u)
+        , OnePerStratum(halton, 3u, 49u)
+        , OnePerCell(halton, 0u, 2u, 3u) )
+}
+
+SCENARIO("Halton dimensions reusing a base are decorrelated", "sampler")
+{
+    GIVEN( auto const halton = HaltonSampler(3u) )
+    THEN( CellsHit(halton, 0u, HaltonSampler::kBaseCount, 8u) > 24u
+        , CellsHit(halton, 1u, HaltonSampler::kBaseCount + 1u, 9u) > 27u
+        , CellsHit(halton, 0u, 2u * HaltonSampler::kBaseCount, 8u) > 24u )
+}
+
+SCENARIO("Stratified samples fall in different strata", "sampler")
+{
+    GIVEN( auto const square = StratifiedSampler(16u, 3u)
+         , auto const wide = StratifiedSampler(6u, 3u) )
+    THEN( OnePerCell(square, 0u, 4u, 4u)
+        , OnePerCell(square, 6u, 4u, 4u)
+        , OnePerCell(wide, 0u, 2u, 3u) )
+}
+
+SCENARIO("Samplers converge faster than white noise", "sampler")
+{
+    GIVEN( auto const sobol = SobolSampler()
+         , auto const halton = HaltonSampler()
+         , auto const stratified = StratifiedSampler(64u)
+         , auto const whiteNoise = WhiteNoiseQuarterDiskError(64u) )
+    THEN( QuarterDiskError(sobol, 64u) < whiteNoise / 2.
+        , QuarterDiskError(halton, 64u) < whiteNoise / 2.
+        , QuarterDiskError(stratified, 64u) < whiteNoise / 2.
+        , QuarterDiskError(sobol, 256u) < QuarterDiskError(sobol, 16u) / 4. )
+}
+
+SCENARIO("Sampled renders don't depend on the number of workers", "sampler")
+{
+    GIVEN( auto const w = DefaultWorld()
+         , SamplerPtr const sobol = std::make_shared<SobolSampler>() )
+    THEN( SameRender(w, Sampled(sobol, 4u, 1u), Sampled(sobol, 4u, 3u))
+        , SameRender(w, Sampled(nullptr, 1u, 2u), Sampled(std::make_shared<R2Sampler>(), 1u, 2u))
+        , !SameRender(w, Sampled(sobol, 4u, 2u), Sampled(nullptr, 4u, 2u)) )
+}
@@ -126,6 +126,46 @@ SCENARIO("Finding the normal on a child object", "shapes")
     THEN( n == Vector(0.2857f, 0.4286f, -0.8571f) )
 }
 
+SCENARIO("A shape composes the transforms of its parents", "shapes")
+{
+    GIVEN( auto g1 = std::make_shared<Group>()
+         , g1->SetTransform(matrix::RotationY(PIOVR2) )
+         , auto g2 = std::make_shared<Group>()
+         , g2->SetTransform(matrix::Scaling(1.f, 2.f, 3.f))
+         , g1->AddChild(g2)
+         , auto s = std::make_shared<Sphere>()
+         , s->SetTransform(matrix::Translation(5.f, 0.f, 0.f))
+         , g2->AddChild(s) )
+    THEN( s->WorldToObject() == s->InvTransform() * g2->InvTransform() * g1->InvTransform()
+        , s->NormalToWorldTransform() == s->WorldToObject().NormalMatrix() )
+}
+
+SCENARIO("Transforming a group after adding children updates their world transforms", "shapes")
+{
+    GIVEN( auto g1 = std::make_shared<Group>()
+         , auto g2 = std::make_shared<Group>()
+         , auto s = std::make_shared<Sphere>()
+         , s->SetTransform(matrix::Translation(5.f, 0.f, 0.f))
+         , g2->AddChild(s)
+         , g1->AddChild(g2) )
+    WHEN( g2->SetTransform(matrix::Scaling(2.f, 2.f, 2.f))
+        , g1->SetTransform(matrix::RotationY(PIOVR2)) )
+    THEN( s->WorldToLocal(Point(-2.f, 0.f, -10.f)) == Point(0.f, 0.f, -1.f) )
+}
+
+SCENARIO("Nesting a group updates the world transforms of its children", "shapes")
+{
+    GIVEN( auto g1 = std::make_shared<Group>()
+         , g1->SetTransform(matrix::RotationY(PIOVR2) )
+         , auto g2 = std::make_shared<Group>()
+         , g2->SetTransform(matrix::Scaling(1.f, 2.f, 3.f))
+         , auto s = std::make_shared<Sphere>()
+         , s->SetTransform(matrix::Translation(5.f, 0.f, 0.f))
+         , g2->AddChild(s) )
+    WHEN( g1->AddChild(g2) )
+    THEN( s->NormalAt(Point(1.7321f, 1.1547f, -5.5774f)) == Vector(0.2857f, 0.4286f, -0.8571f) )
+}
+
 SCENARIO("A shape's bounds", "shape")
 {
     GIVEN( auto const ts = TestShape() )
@@ -57,3 +57,15 @@ SCENARIO("A sphere bounds", "shape,sphere")
     WHEN( auto const& b = s->GetBounds() )
     THEN( b == Bounds() )
 }
+
+SCENARIO("Occlusion queries against a sphere", "shape,sphere")
+{
+    GIVEN( auto const s = std::make_shared<Sphere>()
+         , auto const outside = Ray(Point(0.f, 0.f, -5.f), Vector(0.f, 0.f, 1.f))
+         , auto const inside = Ray(Point(0.f, 0.f, 0.f), Vector(0.f, 0.f, 1.f)) )
+    THEN( s->IntersectsBefore(outside, 10.f)
+        , !s->IntersectsBefore(outside, 4.f)
+        , s->IntersectsBefore(inside, 2.f)
+        , !s->IntersectsBefore(inside, .5f)
+        , !s->IntersectsBefore(Ray(Point(0.f, 2.f, -5.f), Vector(0.f, 0.f, 1.f)), 10.f) )
+}
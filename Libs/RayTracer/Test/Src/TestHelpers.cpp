@@ -1,8 +1,86 @@
 #include "TestHelpers.h"
 
 #include <RayTracer/Shapes/Cylinder.h>
+#include <RayTracer/Transformations.h>
 #include <RayTracer/Shapes/Sphere.h>
 
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local bool t_countAllocations = false;
+    thread_local size_t t_allocations = 0u;
+
+    // Allocations of the other threads, counted from the thread setting the
+    // flag which doesn't count its own
+    std::atomic<bool> g_countOtherAllocations = false;
+    std::atomic<size_t> g_otherAllocations = 0u;
+    thread_local bool t_counting = false;
+}
+
+void* operator new(std::size_t size)
+{
+    if (t_countAllocations)
+    {
+        t_allocations++;
+    }
+    if (g_countOtherAllocations && !t_counting)
+    {
+        g_otherAllocations++;
+    }
+    if (void* ptr = std::malloc(size ? size : 1u))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+size_t CountAllocations(std::function<void()> const& f)
+{
+    t_allocations = 0u;
+    t_countAllocations = true;
+    f();
+    t_countAllocations = false;
+    return t_allocations;
+}
+
+size_t CountOtherAllocations(std::function<void()> const& f)
+{
+    g_otherAllocations = 0u;
+    t_counting = true;
+    g_countOtherAllocations = true;
+    f();
+    g_countOtherAllocations = false;
+    t_counting = false;
+    return g_otherAllocations;
+}
+
+bool SameImage(Canvas const& a, Canvas const& b)
+{
+    if ((a.Width() != b.Width()) || (a.Height() != b.Height()))
+    {
+        return false;
+    }
+    for (int y = 0; y < a.Height(); y++)
+    {
+        for (int x = 0; x < a.Width(); x++)
+        {
+            if (!(a.PixelAt(x, y) == b.PixelAt(x, y)))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 World DefaultWorld()
 {
     World w;
@@ -47,6 +125,74 @@ ShapePtr GlassySphere()
     return s;
 }
 
+World SphereGrid(int size)
+{
+    World w;
+    for (int i = 0; i < size; i++)
+    {
+        for (int j = 0; j < size; j++)
+        {
+            auto s = std::make_shared<Sphere>();
+            s->SetTransform(matrix::Translation(3.f * i, 3.f * j, (float)((i + j) % 3)) * matrix::Scaling(.5f, .5f, .5f));
+            w.Add(s);
+        }
+    }
+    w.Add(PointLight(Point(-10.f, 10.f, -10.f), Color(1.f, 1.f, 1.f)));
+    return w;
+}
+
+bool SameIntersections(World& w, World::AcceleratorType type, Ray const& r)
+{
+    std::vector<Intersection> expected;
+    w.SetAcceleratorType(World::AcceleratorType::None);
+    r.Intersect(w, expected);
+
+    std::vector<Intersection> actual;
+    w.SetAcceleratorType(type);
+    r.Intersect(w, actual);
+
+    if (expected.size() != actual.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        if (!Equals(expected[i].Distance(), actual[i].Distance()))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SameClosestHit(World& w, World::AcceleratorType type, Ray const& r)
+{
+    std::vector<Intersection> xs;
+    w.SetAcceleratorType(World::AcceleratorType::None);
+    r.Intersect(w, xs);
+    auto const expected = Hit(xs);
+
+    w.SetAcceleratorType(type);
+    Ray const query(r.Origin(), r.Direction());
+    Intersection actual(INF, nullptr);
+    bool const found = query.IntersectClosest(w, actual);
+
+    if (found != (expected.Object() != nullptr))
+    {
+        return false;
+    }
+    return !found
+        || ((actual.Object() == expected.Object()) && Equals(actual.Distance(), expected.Distance()) && (query.TMax() == actual.Distance()));
+}
+
+bool SameShadows(World& w, World::AcceleratorType type, Tuple const& point)
+{
+    w.SetAcceleratorType(World::AcceleratorType::None);
+    bool const expected = w.IsShadowed(point, w.Lights()[0]);
+    w.SetAcceleratorType(type);
+    return expected == w.IsShadowed(point, w.Lights()[0]);
+}
+
 std::ostream& operator<<(std::ostream& os, TestArg const& arg)
 {
     os << "{ " << arg.origin
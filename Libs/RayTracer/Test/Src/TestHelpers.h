@@ -1,14 +1,35 @@
 #pragma once
 
+#include <RayTracer/Canvas.h>
 #include <RayTracer/Pattern.h>
 #include <RayTracer/Ray.h>
 #include <RayTracer/Shapes/Shape.h>
 #include <RayTracer/World.h>
 
+#include <functional>
+
 World DefaultWorld();
 World DefaultWorld2();
 ShapePtr GlassySphere();
 
+// size x size grid of small spheres, with the default light
+World SphereGrid(int size);
+
+// Number of heap allocations done by the calling thread while running f
+size_t CountAllocations(std::function<void()> const& f);
+
+// Number of heap allocations done by every other thread, such as those of
+// the thread pool, while the calling one runs f
+size_t CountOtherAllocations(std::function<void()> const& f);
+
+// Same size and exactly the same pixels
+bool SameImage(Canvas const& a, Canvas const& b);
+
+// Compare results given by an accelerator against brute force
+bool SameIntersections(World& w, World::AcceleratorType type, Ray const& r);
+bool SameShadows(World& w, World::AcceleratorType type, Tuple const& point);
+bool SameClosestHit(World& w, World::AcceleratorType type, Ray const& r);
+
 class TestPattern : public IPattern
 {
 public:
@@ -0,0 +1,166 @@
+#include "TestHelpers.h"
+
+#include <RayTracer/Camera.h>
+#include <RayTracer/ThreadPool.h>
+#include <RayTracer/Transformations.h>
+#include <RayTracer/Util.h>
+
+#include <Beddev/Beddev.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Number of times every index was run
+    std::vector<uint32_t> RunAll(ThreadPool& pool, uint32_t count, std::vector<WorkerStats>& stats)
+    {
+        std::vector<uint32_t> runs(count, 0u);
+        pool.ParallelFor(count, [&](uint32_t index, uint32_t) { runs[index]++; }, &stats);
+        return runs;
+    }
+
+    bool RanOnce(std::vector<uint32_t> const& runs)
+    {
+        for (auto count : runs)
+        {
+            if (count != 1u)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    uint32_t TaskCount(std::vector<WorkerStats> const& stats)
+    {
+        uint32_t count = 0u;
+        for (auto const& s : stats)
+        {
+            count += s.m_tasks;
+        }
+        return count;
+    }
+
+    // Every slow task is in the range of the first worker, the others must
+    // steal them to finish early
+    uint32_t StealsOfUnevenTasks(ThreadPool& pool)
+    {
+        std::vector<WorkerStats> stats;
+        pool.ParallelFor(64u, [](uint32_t index, uint32_t) {
+            if (index < 16u)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        }, &stats);
+
+        uint32_t steals = 0u;
+        for (auto const& s : stats)
+        {
+            steals += s.m_steals;
+        }
+        return steals;
+    }
+
+    bool IsRethrown(ThreadPool& pool)
+    {
+        try
+        {
+            pool.ParallelFor(10u, [](uint32_t index, uint32_t) {
+                if (index == 7u)
+                {
+                    throw std::runtime_error("Task failed!");
+                }
+            });
+        }
+        catch (std::runtime_error const&)
+        {
+            return true;
+        }
+        return false;
+    }
+
+    // Number of workers the render was spread over
+    size_t RenderWorkers(Camera const& c, World const& w, uint32_t threads)
+    {
+        RenderSettings settings;
+        settings.m_threads = threads;
+        settings.m_workerStats = true;
+        RenderStats stats;
+        c.Render(w, settings, &stats);
+        return stats.m_workers.size();
+    }
+
+    bool SameRender(World const& w, uint32_t workerCount)
+    {
+        Camera c(37, 29, PI / 2.f);
+        c.SetTransform(matrix::View(Point(0.f, 1.f, -5.f), Point(0.f, 0.f, 0.f), Vector(0.f, 1.f, 0.f)));
+        RenderSettings settings;
+        settings.m_threads = 1u;
+        auto const expected = c.Render(w, settings);
+        settings.m_threads = workerCount;
+        settings.m_workerStats = true;
+        RenderStats stats;
+        auto const actual = c.Render(w, settings, &stats);
+        if ((stats.m_workers.size() != workerCount) || (TaskCount(stats.m_workers) != 3u * 2u))
+        {
+            return false;
+        }
+        return SameImage(expected, actual);
+    }
+}
+
+SCENARIO("A thread pool runs every task once", "pool")
+{
+    GIVEN( auto pool = ThreadPool(4u)
+         , auto stats = std::vector<WorkerStats>() )
+    WHEN( auto const runs = RunAll(pool, 1000u, stats) )
+    THEN( pool.WorkerCount() == 4u
+        , RanOnce(runs)
+        , stats.size() == 4u
+        , TaskCount(stats) == 1000u )
+}
+
+SCENARIO("A thread pool runs batches smaller than its worker count", "pool")
+{
+    GIVEN( auto pool = ThreadPool(4u)
+         , auto stats = std::vector<WorkerStats>() )
+    THEN( RanOnce(RunAll(pool, 3u, stats))
+        , TaskCount(stats) == 3u
+        , RanOnce(RunAll(pool, 0u, stats))
+        , TaskCount(stats) == 0u )
+}
+
+SCENARIO("Idle workers steal tasks from busy ones", "pool")
+{
+    GIVEN( auto pool = ThreadPool(4u) )
+    THEN( StealsOfUnevenTasks(pool) > 0u )
+}
+
+SCENARIO("Exceptions thrown by tasks are rethrown by the pool", "pool")
+{
+    GIVEN( auto pool = ThreadPool(3u)
+         , auto stats = std::vector<WorkerStats>() )
+    THEN( IsRethrown(pool)
+        , RanOnce(RunAll(pool, 10u, stats)) )
+}
+
+SCENARIO("A pool with no worker count uses every hardware thread", "pool")
+{
+    GIVEN( auto pool = ThreadPool(0u)
+         , auto const w = DefaultWorld()
+         , auto const c = Camera(10, 10, PI / 2.f) )
+    WHEN( auto const workers = RenderWorkers(c, w, 0u) )
+    THEN( pool.WorkerCount() >= 1u
+        , workers == pool.WorkerCount() )
+}
+
+SCENARIO("Rendering gives the same image whatever the number of workers", "pool")
+{
+    GIVEN( auto const w = DefaultWorld() )
+    THEN( SameRender(w, 2u)
+        , SameRender(w, 3u)
+        , SameRender(w, 8u) )
+}
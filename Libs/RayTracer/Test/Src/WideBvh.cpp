@@ -0,0 +1,104 @@
+#include "TestHelpers.h"
+
+#include <RayTracer/Bvh.h>
+#include <RayTracer/Shapes/Plane.h>
+#include <RayTracer/Shapes/Sphere.h>
+#include <RayTracer/Transformations.h>
+#include <RayTracer/WideBvh.h>
+#include <RayTracer/World.h>
+
+#include <Beddev/Beddev.h>
+
+namespace
+{
+    bool HitsSomething(Bvh4 const& bvh, Ray const& r)
+    {
+        Intersection hit;
+        return bvh.IntersectClosest(r, hit);
+    }
+}
+
+SCENARIO("An empty wide bvh", "bvh")
+{
+    GIVEN( auto const bvh4 = Bvh4()
+         , auto const bvh8 = Bvh8() )
+    THEN( bvh4.NodeCount() == 0
+        , bvh8.NodeCount() == 0
+        , bvh4.GetBounds() == Bounds::Empty() )
+}
+
+SCENARIO("Collapsing a bvh keeps its bounds and divides its node count", "bvh")
+{
+    GIVEN( auto const w = SphereGrid(16)
+         , auto const bvh = Bvh(w.Objects()) )
+    WHEN( auto const bvh4 = Bvh4(bvh)
+        , auto const bvh8 = Bvh8(bvh) )
+    THEN( bvh4.GetBounds() == bvh.GetBounds()
+        , bvh8.GetBounds() == bvh.GetBounds()
+        , bvh4.NodeCount() * 2u < bvh.NodeCount()
+        , bvh8.NodeCount() < bvh4.NodeCount()
+        , bvh4.LeafCount() == bvh8.LeafCount() )
+}
+
+SCENARIO("A single object makes a wide bvh with a single leaf", "bvh")
+{
+    GIVEN( auto const s = std::make_shared<Sphere>()
+         , auto const bvh = Bvh({ s }) )
+    WHEN( auto const bvh4 = Bvh4(bvh) )
+    THEN( bvh4.NodeCount() == 1
+        , bvh4.LeafCount() == 1
+        , HitsSomething(bvh4, Ray(Point(0.f, 0.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , !HitsSomething(bvh4, Ray(Point(0.f, 2.f, -5.f), Vector(0.f, 0.f, 1.f))) )
+}
+
+SCENARIO("Intersecting a world through a wide bvh gives the same result as brute force", "bvh")
+{
+    GIVEN( auto w = SphereGrid(8)
+         , w.Add(std::make_shared<Plane>())
+         , w.BuildAccelerator()
+         , w.SetAcceleratorType(World::AcceleratorType::Bvh4) )
+    THEN( w.GetBvh4() != nullptr
+        , w.GetAccelerator() == w.GetBvh4()
+        , SameIntersections(w, World::AcceleratorType::Bvh4, Ray(Point(0.f, 0.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameIntersections(w, World::AcceleratorType::Bvh4, Ray(Point(9.f, 6.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameIntersections(w, World::AcceleratorType::Bvh4, Ray(Point(25.f, 25.f, .5f), Vector(-1.f, -1.f, 0.f).Normalized()))
+        , SameIntersections(w, World::AcceleratorType::Bvh8, Ray(Point(-5.f, 0.f, 0.f), Vector(1.f, 0.f, 0.f)))
+        , SameIntersections(w, World::AcceleratorType::Bvh8, Ray(Point(10.f, 10.f, 10.f), Vector(.1f, .2f, -1.f).Normalized()))
+        , SameIntersections(w, World::AcceleratorType::Bvh8, Ray(Point(1.5f, 1.5f, -5.f), Vector(0.f, 0.f, 1.f))) )
+}
+
+SCENARIO("Closest hit queries through a wide bvh give the same result as brute force", "bvh")
+{
+    GIVEN( auto w = SphereGrid(8)
+         , w.Add(std::make_shared<Plane>())
+         , w.BuildAccelerator() )
+    THEN( SameClosestHit(w, World::AcceleratorType::Bvh4, Ray(Point(0.f, 0.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameClosestHit(w, World::AcceleratorType::Bvh4, Ray(Point(9.f, 6.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameClosestHit(w, World::AcceleratorType::Bvh4, Ray(Point(25.f, 25.f, .5f), Vector(-1.f, -1.f, 0.f).Normalized()))
+        , SameClosestHit(w, World::AcceleratorType::Bvh8, Ray(Point(-5.f, 0.f, 0.f), Vector(1.f, 0.f, 0.f)))
+        , SameClosestHit(w, World::AcceleratorType::Bvh8, Ray(Point(10.f, 10.f, 10.f), Vector(.1f, .2f, -1.f).Normalized()))
+        , SameClosestHit(w, World::AcceleratorType::Bvh8, Ray(Point(3.f, 3.f, 0.f), Vector(0.f, 0.f, 1.f))) )
+}
+
+SCENARIO("Shadow queries through a wide bvh give the same result as brute force", "bvh")
+{
+    GIVEN( auto w = SphereGrid(8)
+         , w.BuildAccelerator() )
+    THEN( SameShadows(w, World::AcceleratorType::Bvh4, Point(0.f, 0.f, 1.f))
+        , SameShadows(w, World::AcceleratorType::Bvh4, Point(3.f, 3.f, 2.f))
+        , SameShadows(w, World::AcceleratorType::Bvh4, Point(21.f, 21.f, 5.f))
+        , SameShadows(w, World::AcceleratorType::Bvh8, Point(30.f, 0.f, -2.f))
+        , SameShadows(w, World::AcceleratorType::Bvh8, Point(-1.f, 1.f, -1.f)) )
+}
+
+SCENARIO("Refitting a world also refits its wide bvhs", "bvh")
+{
+    GIVEN( auto w = SphereGrid(8)
+         , w.BuildAccelerator() )
+    WHEN( w.Objects()[10]->SetTransform(matrix::Translation(3.5f, 4.f, 0.f) * matrix::Scaling(.5f, .5f, .5f))
+        , w.RefitAccelerator({ w.Objects()[10] }) )
+    THEN( SameIntersections(w, World::AcceleratorType::Bvh4, Ray(Point(3.5f, 4.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameIntersections(w, World::AcceleratorType::Bvh8, Ray(Point(3.5f, 4.f, -5.f), Vector(0.f, 0.f, 1.f)))
+        , SameClosestHit(w, World::AcceleratorType::Bvh4, Ray(Point(-5.f, 4.f, 0.f), Vector(1.f, 0.f, 0.f)))
+        , SameShadows(w, World::AcceleratorType::Bvh8, Point(4.f, 3.5f, -1.f)) )
+}
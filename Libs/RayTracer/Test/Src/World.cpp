@@ -1,8 +1,11 @@
 #include "TestHelpers.h"
 
 #include <RayTracer/Archetype.h>
+#include <RayTracer/Camera.h>
+#include <RayTracer/Pattern.h>
 #include <RayTracer/Ray.h>
 #include <RayTracer/Shapes/Group.h>
+#include <RayTracer/Shapes/Instance.h>
 #include <RayTracer/Shapes/Plane.h>
 #include <RayTracer/Shapes/Sphere.h>
 #include <RayTracer/Transformations.h>
@@ -11,7 +14,10 @@
 
 #include <Beddev/Beddev.h>
 
+#include <algorithm>
+#include <memory>
 #include <sstream>
+#include <vector>
 
 namespace
 {
@@ -57,6 +63,85 @@ namespace
     }]
 })";
 
+    void RenderPixels(Camera const& c, World const& w, uint32_t size)
+    {
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                w.ColorAt(c.RayForPixel(x, y));
+            }
+        }
+    }
+
+    // Shadows of points just behind the spheres of SphereGrid(size), twice
+    // per sphere so the cache is hit, with the occluder cache against
+    // without it
+    bool SameCachedShadows(World& w, int size, World::AcceleratorType type)
+    {
+        w.SetAcceleratorType(type);
+        for (int i = 0; i < size; i++)
+        {
+            for (int j = 0; j < size; j++)
+            {
+                auto const center = Point(3.f * i, 3.f * j, (float)((i + j) % 3));
+                auto const away = (center - w.Lights()[0].Position()).Normalized();
+                for (float const distance : { .6f, .8f, 2.f })
+                {
+                    auto const point = center + (away * distance);
+                    w.UseOccluderCache(false);
+                    bool const expected = w.IsShadowed(point, w.Lights()[0]);
+                    w.UseOccluderCache(true);
+                    if (w.IsShadowed(point, w.Lights()[0]) != expected)
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    // Renders until every worker of the pool rendered a tile, so each of them
+    // allocated its per-thread storage
+    void WarmUpWorkers(Camera const& c, World const& w, RenderSettings settings, RenderTarget& target)
+    {
+        settings.m_workerStats = true;
+        std::vector<uint32_t> tasks;
+        for (int i = 0; i < 1000; i++)
+        {
+            RenderStats stats;
+            c.Render(w, settings, target, nullptr, &stats);
+            tasks.resize(stats.m_workers.size(), 0u);
+            for (size_t worker = 0u; worker < tasks.size(); worker++)
+            {
+                tasks[worker] += stats.m_workers[worker].m_tasks;
+            }
+            if (std::all_of(tasks.begin(), tasks.end(), [](uint32_t count) { return count > 0u; }))
+            {
+                return;
+            }
+        }
+    }
+
+    // Number of shapes of a world still alive once it is destroyed, after it
+    // cached an occluder on this thread
+    size_t ShapesLeftOfShadowedWorld()
+    {
+        std::vector<std::weak_ptr<Shape>> shapes;
+        {
+            auto const w = DefaultWorld();
+            w.IsShadowed(Point(10.f, -10.f, 10.f), w.Lights()[0]);
+            shapes.assign(w.Objects().begin(), w.Objects().end());
+        }
+        return std::count_if(shapes.begin(), shapes.end(), [](auto const& shape) { return !shape.expired(); });
+    }
+
+    ShapePtr PrototypeRoot(ShapePtr const& instance)
+    {
+        return std::dynamic_pointer_cast<Instance>(instance)->Prototype()->m_root;
+    }
+
 }
 
 SCENARIO("Creating a world", "world")
@@ -220,6 +305,64 @@ SCENARIO("There is no shadow when an object is behind the point", "shadows")
     THEN( !w.IsShadowed(point, w.Lights()[0]) )
 }
 
+SCENARIO("Shadow rays first test the last occluder of the light", "shadows")
+{
+    GIVEN( auto const w = DefaultWorld()
+         , auto const p1 = Point(10.f, -10.f, 10.f)
+         , auto const p2 = Point(9.f, -10.f, 10.f) )
+    WHEN( w.IsShadowed(p1, w.Lights()[0])
+        , w.IsShadowed(p2, w.Lights()[0]) )
+    THEN( w.GetOccluderCacheStats().m_queries == 2
+        , w.GetOccluderCacheStats().m_hits == 1 )
+}
+
+SCENARIO("A cached occluder not blocking the light doesn't cast a shadow", "shadows")
+{
+    GIVEN( auto const w = DefaultWorld()
+         , w.IsShadowed(Point(10.f, -10.f, 10.f), w.Lights()[0]) )
+    WHEN( auto const shadowed = w.IsShadowed(Point(0.f, 10.f, 0.f), w.Lights()[0]) )
+    THEN( !shadowed
+        , w.GetOccluderCacheStats().m_queries == 2
+        , w.GetOccluderCacheStats().m_hits == 0 )
+}
+
+SCENARIO("Removed objects are not kept as occluders", "shadows")
+{
+    GIVEN( auto w = DefaultWorld()
+         , auto const point = Point(10.f, -10.f, 10.f)
+         , w.IsShadowed(point, w.Lights()[0]) )
+    WHEN( w.ModifyObjects().clear() )
+    THEN( !w.IsShadowed(point, w.Lights()[0]) )
+}
+
+SCENARIO("Cached occluders don't keep their world alive", "shadows")
+{
+    WHEN( auto const left = ShapesLeftOfShadowedWorld() )
+    THEN( left == 0u )
+}
+
+SCENARIO("Cached occluders give the same shadows with every accelerator", "shadows")
+{
+    GIVEN( auto w = SphereGrid(8)
+         , w.BuildAccelerator() )
+    THEN( SameCachedShadows(w, 8, World::AcceleratorType::None)
+        , SameCachedShadows(w, 8, World::AcceleratorType::Bvh)
+        , SameCachedShadows(w, 8, World::AcceleratorType::LinearBvh)
+        , SameCachedShadows(w, 8, World::AcceleratorType::Bvh4)
+        , SameCachedShadows(w, 8, World::AcceleratorType::Bvh8)
+        , w.GetOccluderCacheStats().m_hits > 0u )
+}
+
+SCENARIO("The occluder cache can be disabled", "shadows")
+{
+    GIVEN( auto w = DefaultWorld()
+         , w.UseOccluderCache(false) )
+    WHEN( w.IsShadowed(Point(10.f, -10.f, 10.f), w.Lights()[0])
+        , w.IsShadowed(Point(10.f, -10.f, 10.f), w.Lights()[0]) )
+    THEN( w.IsShadowed(Point(10.f, -10.f, 10.f), w.Lights()[0])
+        , w.GetOccluderCacheStats().m_queries == 0 )
+}
+
 SCENARIO("ShadeHit is given an intersection in shadow", "shadows")
 {
     GIVEN( auto w = World()
@@ -421,6 +564,47 @@ SCENARIO("ShadeHit() with a reflective, transparent material", "refraction")
     THEN( color == Color(.93391f, .69643f, .69243f) )
 }
 
+SCENARIO("Rendering does no heap allocations once warmed up", "World")
+{
+    GIVEN( auto w = DefaultWorld()
+         , auto floor = std::make_shared<Plane>()
+         , floor->SetTransform(matrix::Translation(0.f, -1.f, 0.f))
+         , floor->ModifyMaterial().Reflective(.5f)
+         , w.Add(floor)
+         , auto glass = GlassySphere()
+         , glass->SetTransform(matrix::Translation(1.f, 0.f, -2.f) * matrix::Scaling(.5f, .5f, .5f))
+         , w.Add(glass)
+         , w.BuildAccelerator()
+         , auto c = Camera(16, 16, PI / 2)
+         , c.SetTransform(matrix::View(Point(0.f, 1.f, -5.f), Point(0.f, 0.f, 0.f), Vector(0.f, 1.f, 0.f)))
+         , auto const render = [&]() { RenderPixels(c, w, 16u); }
+         , render() )
+    THEN( CountAllocations(render) == 0u )
+}
+
+// Only a reflective, transparent floor fills the image, so every tile needs
+// what the others do and any tile warms a worker up
+SCENARIO("Rendering tiles does no heap allocations once warmed up", "World")
+{
+    GIVEN( auto w = World()
+         , w.Add(PointLight(Point(-10.f, 10.f, -10.f), Color(1.f, 1.f, 1.f)))
+         , auto floor = std::make_shared<Plane>()
+         , floor->ModifyMaterial().Pattern(std::make_shared<CheckerPattern>(Color(1.f, 1.f, 1.f), Color(.2f, .2f, .2f)))
+         , floor->ModifyMaterial().Reflective(.5f)
+         , floor->ModifyMaterial().Transparency(.5f)
+         , floor->ModifyMaterial().RefractiveIndex(1.5f)
+         , w.Add(floor)
+         , w.BuildAccelerator()
+         , auto c = Camera(48, 48, PI / 3)
+         , c.SetTransform(matrix::View(Point(0.f, 4.f, -4.f), Point(0.f, 0.f, 0.f), Vector(0.f, 1.f, 0.f)))
+         , auto target = RenderTarget(48, 48)
+         , auto settings = RenderSettings()
+         , settings.m_threads = 3u // no more than the 9 tiles, so every worker gets some
+         , WarmUpWorkers(c, w, settings, target)
+         , auto const render = [&]() { c.Render(w, settings, target); } )
+    THEN( CountOtherAllocations(render) == 0u )
+}
+
 SCENARIO("Loading a world from an empty scene.json file", "World")
 {
     GIVEN( auto w = World()
@@ -450,11 +634,12 @@ SCENARIO("Loading a world from a scene.json file", "World")
         , objects.size() == 2
         , objects.at(0)->Name() == "TestGroup"
         , objects.at(0)->Transform() == matrix::Scaling(3.f, 3.f, 3.f)
-        , std::dynamic_pointer_cast<Group>(objects.at(0))->Children().size() == 3
-        , std::dynamic_pointer_cast<Group>(objects.at(0))->Children()[0]->Name() == "TestCube"
-        , std::dynamic_pointer_cast<Group>(objects.at(0))->Children()[1]->Name() == "TestSphere"
-        , std::dynamic_pointer_cast<Group>(objects[0])->Children()[2]->Name() == "TestArch2"
-        , std::dynamic_pointer_cast<Sphere>(std::dynamic_pointer_cast<Group>(objects[0])->Children()[2]) != nullptr
+        , std::dynamic_pointer_cast<Instance>(objects.at(0)) != nullptr
+        , std::dynamic_pointer_cast<Group>(PrototypeRoot(objects.at(0)))->Children().size() == 3
+        , std::dynamic_pointer_cast<Group>(PrototypeRoot(objects.at(0)))->Children()[0]->Name() == "TestCube"
+        , std::dynamic_pointer_cast<Group>(PrototypeRoot(objects.at(0)))->Children()[1]->Name() == "TestSphere"
+        , std::dynamic_pointer_cast<Group>(PrototypeRoot(objects[0]))->Children()[2]->Name() == "TestArch2"
+        , std::dynamic_pointer_cast<Sphere>(std::dynamic_pointer_cast<Group>(PrototypeRoot(objects[0]))->Children()[2]) != nullptr
         , objects.at(1)->Name() == "TestCylinder"
         , objects.at(1)->Transform() == (matrix::Translation(0.f, 0.f, -1.f) * matrix::RotationY(PIOVR2) * matrix::Scaling(0.25f, 1.0f, 0.25f))
         , archetypes.size() == 2
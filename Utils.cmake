@@ -3,13 +3,15 @@ cmake_minimum_required( VERSION 3.14 )
 include(GenerateExportHeader)
 
 function(AddTarget NAME)
-    set( options EXECUTABLE LIBRARY TEST INTERFACE EXPORT_HEADER )
+    set( options EXECUTABLE LIBRARY STATIC TEST INTERFACE EXPORT_HEADER )
     set( oneValueArgs FOLDER )
     set( multiValueArgs SOURCES DEPS INTERFACE_DIRS PUBLIC_DIRS PRIVATE_DIRS PUBLIC_DEFS PRIVATE_DEFS RESOURCES )
     cmake_parse_arguments( ADDTARGET "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN} )
 
     if (ADDTARGET_EXECUTABLE OR ADDTARGET_TEST)
         add_executable( ${NAME} )
+    elseif (ADDTARGET_LIBRARY AND ADDTARGET_STATIC)
+        add_library( ${NAME} STATIC )
     elseif (ADDTARGET_LIBRARY)
         add_library( ${NAME} )
     elseif (ADDTARGET_INTERFACE)